@@ -0,0 +1,614 @@
+/*
+  SparkFun parser benchmark example sketch
+
+  This example measures the parser throughput using data streams that
+  resemble the output of common GNSS receivers:
+
+    * UM980: NMEA, Unicore binary and Unicore hash (#) messages
+    * ZED-F9P: u-blox UBX, RTCM and NMEA messages
+    * mosaic-X5: SBF messages with SPARTN data between the SBF messages
+
+  The data streams are generated when the sketch starts.  A recorded
+  capture may be measured instead by copying it into the corpus array in
+  place of the call to buildCorpus.  Each data stream is parsed without
+  errors and again after flipping bits in the data stream, passing the
+  data to sempParseNextByte, to sempParseBuffer and to sempParseBuffer
+  with zero-copy enabled.  The results are displayed in MB/s, messages
+  per second and nanoseconds per byte.
+
+  License: MIT. Please see LICENSE.md for more details
+*/
+
+#include <SparkFun_Extensible_Message_Parser.h> //http://librarymanager/All#SparkFun_Extensible_Message_Parser
+
+//----------------------------------------
+// Constants
+//----------------------------------------
+
+// Size of the generated data stream, reduce for processors with less RAM
+#define CORPUS_BYTES            (64 * 1024)
+
+// Number of bytes passed to sempParseBuffer, similar to a UART or DMA block
+#define CHUNK_BYTES             256
+
+// Minimum duration of each measurement
+#define RUN_MICROSECONDS        (500 * 1000)
+
+// Average distance between the bit errors in the data stream
+#define BIT_ERROR_BYTES         1000
+
+// Set to zero (0) to measure the parsers without the preamble tables
+#define USE_PREAMBLE_TABLE      1
+
+// Account for the largest messages
+#define BUFFER_LENGTH           3000
+
+// Largest message built by the message builders
+#define MAXIMUM_MESSAGE_BYTES   1100
+
+// Message types in the generated data stream
+#define MSG_NMEA                0x01
+#define MSG_RTCM                0x02
+#define MSG_UBLOX               0x04
+#define MSG_UNICORE_BINARY      0x08
+#define MSG_UNICORE_HASH        0x10
+#define MSG_SBF                 0x20
+#define MSG_SPARTN              0x40
+
+// NMEA sentences without the checksum
+const char * const nmeaSentences[] =
+{
+    "GPGGA,210230,3855.4487,N,09446.0071,W,1,07,1.1,370.5,M,-29.5,M,,",
+    "GPGSV,2,1,08,02,74,042,45,04,18,190,36,07,67,279,42,12,29,323,36",
+    "GPGSV,2,2,08,15,30,050,47,19,09,158,,26,12,281,40,27,38,173,41",
+    "GPRMC,210230,A,3855.4487,N,09446.0071,W,0.0,076.2,130495,003.8,E",
+};
+const int nmeaSentenceCount = sizeof(nmeaSentences) / sizeof(nmeaSentences[0]);
+
+// Unicore hash sentences without the CRC
+const char * const unicoreHashSentences[] =
+{
+    "VERSION,97,GPS,FINE,2282,248561000,0,0,18,676;UM980,R4.10Build7923,HRPT00-S10C-P,2310415000001-MD22B1224962616,ff3bac96f31f9bdd,2022/09/28",
+    "BESTNAVA,97,GPS,FINE,2283,499142000,0,0,18,964;SOL_COMPUTED,PPP,40.09029479894,-105.18505761208,1560.0356,-17.0000,WGS84,0.0107,0.0094,0.0210,\"0\",0.000,0.000,35,30,30,30,0,06,00,33",
+};
+const int unicoreHashSentenceCount = sizeof(unicoreHashSentences) / sizeof(unicoreHashSentences[0]);
+
+// SPARTN OCB 0 message from the SPARTN_Test example
+const uint8_t spartnMessage[] =
+{
+    0x73, 0x00, 0x16, 0x69, 0x08, 0xBF, 0x33, 0xD0, 0x78, 0x6C, 0x2D, 0x48, 0x2A, 0x18, 0xF0, 0xC0,
+    0x3E, 0x1D, 0x9C, 0x37, 0x7E, 0x9A, 0x5E, 0xE8, 0x39, 0xC6, 0x0E, 0xBD, 0xDE, 0xA9, 0x7D, 0x43,
+    0xB9, 0x17, 0x96, 0xC7, 0x04, 0xAF, 0x9A, 0x4B, 0xBF, 0x70, 0x65, 0xC3, 0x66, 0x80, 0xCA, 0x45,
+    0x20, 0x16, 0x41, 0xA4, 0x14, 0x2B, 0x5B, 0xD4, 0x11, 0x6F, 0x64,
+};
+
+// Build the tables listing the parsers for each benchmark
+SEMP_PARSE_ROUTINE const nmeaParserTable[] = {sempNmeaPreamble};
+SEMP_PARSE_ROUTINE const rtcmParserTable[] = {sempRtcmPreamble};
+SEMP_PARSE_ROUTINE const ubloxParserTable[] = {sempUbloxPreamble};
+SEMP_PARSE_ROUTINE const unicoreBinaryParserTable[] = {sempUnicoreBinaryPreamble};
+SEMP_PARSE_ROUTINE const unicoreHashParserTable[] = {sempUnicoreHashPreamble};
+SEMP_PARSE_ROUTINE const sbfParserTable[] = {sempSbfPreamble};
+SEMP_PARSE_ROUTINE const spartnParserTable[] = {sempSpartnPreamble};
+SEMP_PARSE_ROUTINE const um980ParserTable[] =
+{
+    sempNmeaPreamble,
+    sempUnicoreBinaryPreamble,
+    sempUnicoreHashPreamble,
+};
+SEMP_PARSE_ROUTINE const zedF9pParserTable[] =
+{
+    sempUbloxPreamble,
+    sempRtcmPreamble,
+    sempNmeaPreamble,
+};
+SEMP_PARSE_ROUTINE const allParserTable[] =
+{
+    sempNmeaPreamble,
+    sempUbloxPreamble,
+    sempRtcmPreamble,
+    sempUnicoreBinaryPreamble,
+    sempUnicoreHashPreamble,
+    sempSpartnPreamble,
+};
+
+const char * const nmeaParserNames[] = {"NMEA parser"};
+const char * const rtcmParserNames[] = {"RTCM parser"};
+const char * const ubloxParserNames[] = {"U-Blox parser"};
+const char * const unicoreBinaryParserNames[] = {"Unicore binary parser"};
+const char * const unicoreHashParserNames[] = {"Unicore hash parser"};
+const char * const sbfParserNames[] = {"SBF parser"};
+const char * const spartnParserNames[] = {"SPARTN parser"};
+const char * const um980ParserNames[] =
+{
+    "NMEA parser",
+    "Unicore binary parser",
+    "Unicore hash parser",
+};
+const char * const zedF9pParserNames[] =
+{
+    "U-Blox parser",
+    "RTCM parser",
+    "NMEA parser",
+};
+const char * const allParserNames[] =
+{
+    "NMEA parser",
+    "U-Blox parser",
+    "RTCM parser",
+    "Unicore binary parser",
+    "Unicore hash parser",
+    "SPARTN parser",
+};
+
+const int16_t nmeaPreambleTable[] = {SEMP_NMEA_PREAMBLE};
+const int16_t rtcmPreambleTable[] = {SEMP_RTCM_PREAMBLE};
+const int16_t ubloxPreambleTable[] = {SEMP_UBLOX_PREAMBLE};
+const int16_t unicoreBinaryPreambleTable[] = {SEMP_UNICORE_BINARY_PREAMBLE};
+const int16_t unicoreHashPreambleTable[] = {SEMP_UNICORE_HASH_PREAMBLE};
+const int16_t sbfPreambleTable[] = {SEMP_SBF_PREAMBLE};
+const int16_t spartnPreambleTable[] = {SEMP_SPARTN_PREAMBLE};
+const int16_t um980PreambleTable[] =
+{
+    SEMP_NMEA_PREAMBLE,
+    SEMP_UNICORE_BINARY_PREAMBLE,
+    SEMP_UNICORE_HASH_PREAMBLE,
+};
+const int16_t zedF9pPreambleTable[] =
+{
+    SEMP_UBLOX_PREAMBLE,
+    SEMP_RTCM_PREAMBLE,
+    SEMP_NMEA_PREAMBLE,
+};
+const int16_t allPreambleTable[] =
+{
+    SEMP_NMEA_PREAMBLE,
+    SEMP_UBLOX_PREAMBLE,
+    SEMP_RTCM_PREAMBLE,
+    SEMP_UNICORE_BINARY_PREAMBLE,
+    SEMP_UNICORE_HASH_PREAMBLE,
+    SEMP_SPARTN_PREAMBLE,
+};
+
+typedef struct _BENCHMARK
+{
+    const char *name;                       // Name of the data stream
+    uint32_t messageTypes;                  // Messages in the data stream
+    const SEMP_PARSE_ROUTINE *parserTable;  // Table of parsers
+    const char * const *parserNames;        // Table of parser names
+    const int16_t *preambleTable;           // Table of preamble bytes
+    uint16_t parserCount;                   // Number of parsers
+} BENCHMARK;
+
+#define BENCHMARK_INIT(name, types, x)  \
+    {name, types, x##ParserTable, x##ParserNames, x##PreambleTable, sizeof(x##ParserTable) / sizeof(x##ParserTable[0])}
+
+const BENCHMARK benchmarks[] =
+{
+    BENCHMARK_INIT("NMEA", MSG_NMEA, nmea),
+    BENCHMARK_INIT("RTCM", MSG_RTCM, rtcm),
+    BENCHMARK_INIT("U-Blox", MSG_UBLOX, ublox),
+    BENCHMARK_INIT("Unicore binary", MSG_UNICORE_BINARY, unicoreBinary),
+    BENCHMARK_INIT("Unicore hash", MSG_UNICORE_HASH, unicoreHash),
+    BENCHMARK_INIT("SBF", MSG_SBF, sbf),
+    BENCHMARK_INIT("SPARTN", MSG_SPARTN, spartn),
+    BENCHMARK_INIT("UM980", MSG_NMEA | MSG_UNICORE_BINARY | MSG_UNICORE_HASH, um980),
+    BENCHMARK_INIT("ZED-F9P", MSG_UBLOX | MSG_RTCM | MSG_NMEA, zedF9p),
+    BENCHMARK_INIT("mosaic-X5", MSG_SBF | MSG_SPARTN, sbf),
+    BENCHMARK_INIT("All but SBF", MSG_NMEA | MSG_UBLOX | MSG_RTCM
+                   | MSG_UNICORE_BINARY | MSG_UNICORE_HASH | MSG_SPARTN, all),
+};
+const int benchmarkCount = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+// Ways of passing the data stream to the parser
+enum
+{
+    MODE_NEXT_BYTE = 0,
+    MODE_BUFFER,
+    MODE_ZERO_COPY,
+    MODE_COUNT
+};
+
+const char * const modeNames[] =
+{
+    "next byte",
+    "buffer",
+    "zero-copy",
+};
+
+//----------------------------------------
+// Locals
+//----------------------------------------
+
+uint8_t corpus[CORPUS_BYTES];
+uint32_t corpusMessages;
+uint32_t messageCount;
+uint32_t randomValue;
+SEMP_PARSE_STATE *spartnParser;
+
+//----------------------------------------
+// Test routine
+//----------------------------------------
+
+// Initialize the system
+void setup()
+{
+    size_t corpusBytes;
+    int index;
+    int mode;
+
+    delay(1000);
+
+    Serial.begin(115200);
+    Serial.println();
+    Serial.println("Benchmark example sketch");
+    Serial.println();
+
+    // Measure each of the data streams
+    for (index = 0; index < benchmarkCount; index++)
+    {
+        // Build the data stream
+        corpusBytes = buildCorpus(benchmarks[index].messageTypes);
+        Serial.printf("%s: %d bytes, %ld messages\r\n", benchmarks[index].name,
+                      corpusBytes, corpusMessages);
+
+        // Parse the valid messages
+        for (mode = 0; mode < MODE_COUNT; mode++)
+            runBenchmark(&benchmarks[index], corpusBytes, mode, false);
+
+        // Parse the data stream containing bit errors
+        addBitErrors(corpusBytes);
+        for (mode = 0; mode < MODE_COUNT; mode++)
+            runBenchmark(&benchmarks[index], corpusBytes, mode, true);
+        Serial.println();
+    }
+    Serial.println("Benchmark complete");
+}
+
+// Main loop processing after system is initialized
+void loop()
+{
+    // Nothing to do here...
+}
+
+// Parse the data stream repeatedly and display the results
+void runBenchmark(const BENCHMARK *benchmark, size_t corpusBytes, int mode, bool bitErrors)
+{
+    size_t bytes;
+    uint32_t elapsed;
+    size_t offset;
+    SEMP_PARSE_STATE *parse;
+    uint32_t passes;
+    uint32_t start;
+    double totalBytes;
+
+    // Initialize the parser
+    parse = sempBeginParser(benchmark->parserTable, benchmark->parserCount,
+                            benchmark->parserNames, benchmark->parserCount,
+                            0, BUFFER_LENGTH, benchmarkMessage, benchmark->name,
+                            &Serial, nullptr, nullptr,
+                            USE_PREAMBLE_TABLE ? benchmark->preambleTable : nullptr);
+    if (!parse)
+        reportFatalError("Failed to initialize the parser");
+    sempDisableErrorOutput(parse);
+    if (mode == MODE_ZERO_COPY)
+        sempEnableZeroCopy(parse);
+
+    // Pass the data between the SBF messages to the SPARTN parser
+    if (benchmark->messageTypes == (MSG_SBF | MSG_SPARTN))
+    {
+        spartnParser = sempBeginParser(spartnParserTable, 1, spartnParserNames, 1,
+                                       0, BUFFER_LENGTH, benchmarkMessage, "SPARTN",
+                                       &Serial, nullptr, nullptr,
+                                       USE_PREAMBLE_TABLE ? spartnPreambleTable : nullptr);
+        if (!spartnParser)
+            reportFatalError("Failed to initialize the SPARTN parser");
+        sempDisableErrorOutput(spartnParser);
+        sempSbfSetInvalidDataCallback(parse, invalidSbfData);
+    }
+
+    // Parse the data stream until the run time expires
+    messageCount = 0;
+    passes = 0;
+    start = micros();
+    do
+    {
+        if (mode == MODE_NEXT_BYTE)
+        {
+            for (offset = 0; offset < corpusBytes; offset++)
+                sempParseNextByte(parse, corpus[offset]);
+        }
+        else
+        {
+            for (offset = 0; offset < corpusBytes; offset += bytes)
+            {
+                bytes = corpusBytes - offset;
+                if (bytes > CHUNK_BYTES)
+                    bytes = CHUNK_BYTES;
+                sempParseBuffer(parse, &corpus[offset], bytes);
+            }
+        }
+        passes += 1;
+        elapsed = micros() - start;
+    } while (elapsed < RUN_MICROSECONDS);
+
+    // Done with the parsers
+    sempStopParser(&parse);
+    if (spartnParser)
+        sempStopParser(&spartnParser);
+
+    // Verify that all of the valid messages were found
+    if ((!bitErrors) && (messageCount != (passes * corpusMessages)))
+        Serial.printf("ERROR: Found %ld messages, expecting %ld\r\n",
+                      messageCount / passes, corpusMessages);
+
+    // Display the results
+    totalBytes = (double)passes * corpusBytes;
+    Serial.printf("    %-6s %-9s %8.2f MB/s, %10.0f messages/s, %7.2f ns/byte, %ld messages\r\n",
+                  bitErrors ? "errors" : "clean",
+                  modeNames[mode],
+                  totalBytes / elapsed,
+                  messageCount * 1000000. / elapsed,
+                  elapsed * 1000. / totalBytes,
+                  messageCount / passes);
+}
+
+// Callback from within the SBF parser when invalid data is identified
+// The data is passed on to the SPARTN parser
+void invalidSbfData(SEMP_PARSE_STATE *parse)
+{
+    sempParseBuffer(spartnParser, parse->buffer, parse->length);
+}
+
+// Call back from within parser, for end of message
+void benchmarkMessage(SEMP_PARSE_STATE *parse, uint16_t type)
+{
+    messageCount += 1;
+}
+
+// Build a data stream containing the specified message types
+size_t buildCorpus(uint32_t messageTypes)
+{
+    size_t length;
+    uint32_t messageType;
+
+    corpusMessages = 0;
+    length = 0;
+    randomValue = 1;
+    messageType = 1;
+    while ((length + MAXIMUM_MESSAGE_BYTES) <= sizeof(corpus))
+    {
+        // Select the next message type
+        do
+        {
+            messageType <<= 1;
+            if (messageType > MSG_SPARTN)
+                messageType = 1;
+        } while ((messageType & messageTypes) == 0);
+
+        // Add the message to the data stream
+        switch (messageType)
+        {
+        case MSG_NMEA:
+            length += buildNmeaSentence(&corpus[length]);
+            break;
+        case MSG_RTCM:
+            length += buildRtcmMessage(&corpus[length]);
+            break;
+        case MSG_UBLOX:
+            length += buildUbloxMessage(&corpus[length]);
+            break;
+        case MSG_UNICORE_BINARY:
+            length += buildUnicoreBinaryMessage(&corpus[length]);
+            break;
+        case MSG_UNICORE_HASH:
+            length += buildUnicoreHashSentence(&corpus[length]);
+            break;
+        case MSG_SBF:
+            length += buildSbfMessage(&corpus[length]);
+            break;
+        case MSG_SPARTN:
+            memcpy(&corpus[length], spartnMessage, sizeof(spartnMessage));
+            length += sizeof(spartnMessage);
+            break;
+        }
+        corpusMessages += 1;
+    }
+    return length;
+}
+
+// Flip bits in the data stream
+void addBitErrors(size_t corpusBytes)
+{
+    size_t offset;
+
+    for (offset = nextRandom() % BIT_ERROR_BYTES; offset < corpusBytes;
+         offset += 1 + nextRandom() % (2 * BIT_ERROR_BYTES))
+        corpus[offset] ^= 1 << (nextRandom() & 7);
+}
+
+// Get the next pseudo random value, repeatable between runs
+uint32_t nextRandom()
+{
+    randomValue = randomValue * 1103515245 + 12345;
+    return randomValue >> 16;
+}
+
+// Fill a payload with pseudo random data
+void fillPayload(uint8_t *buffer, size_t length)
+{
+    while (length--)
+        *buffer++ = nextRandom();
+}
+
+// Build an NMEA sentence, returns the sentence length in bytes
+size_t buildNmeaSentence(uint8_t *buffer)
+{
+    uint8_t checksum;
+    const char *sentence;
+
+    // Compute the checksum
+    sentence = nmeaSentences[corpusMessages % nmeaSentenceCount];
+    checksum = 0;
+    for (const char *data = sentence; *data; data++)
+        checksum ^= *data;
+    return sprintf((char *)buffer, "$%s*%02X\r\n", sentence, checksum);
+}
+
+// Build an RTCM message, returns the message length in bytes
+size_t buildRtcmMessage(uint8_t *buffer)
+{
+    uint32_t crc;
+    size_t index;
+    size_t length;
+    uint16_t messageNumber;
+
+    // Vary the message number and the payload length
+    messageNumber = 1077 + 10 * (corpusMessages % 4);
+    length = 100 + (corpusMessages % 200);
+
+    // Build the header and payload
+    buffer[0] = SEMP_RTCM_PREAMBLE;
+    buffer[1] = length >> 8;
+    buffer[2] = length & 0xff;
+    fillPayload(&buffer[3], length);
+    buffer[3] = messageNumber >> 4;
+    buffer[4] = (buffer[4] & 0x0f) | ((messageNumber << 4) & 0xf0);
+    length += 3;
+
+    // Add the CRC-24Q
+    crc = 0;
+    for (index = 0; index < length; index++)
+        crc = ((crc << 8) ^ semp_crc24qTable[buffer[index] ^ ((crc >> 16) & 0xff)]) & 0xffffff;
+    buffer[length++] = crc >> 16;
+    buffer[length++] = crc >> 8;
+    buffer[length++] = crc;
+    return length;
+}
+
+// Build a u-blox UBX message, returns the message length in bytes
+size_t buildUbloxMessage(uint8_t *buffer)
+{
+    uint8_t ckA;
+    uint8_t ckB;
+    size_t index;
+    size_t length;
+
+    // Build a NAV-PVT message
+    length = 92;
+    buffer[0] = SEMP_UBLOX_PREAMBLE;
+    buffer[1] = 0x62;
+    buffer[2] = 0x01;
+    buffer[3] = 0x07;
+    buffer[4] = length & 0xff;
+    buffer[5] = length >> 8;
+    fillPayload(&buffer[6], length);
+    length += 6;
+
+    // Add the checksum
+    ckA = 0;
+    ckB = 0;
+    for (index = 2; index < length; index++)
+    {
+        ckA += buffer[index];
+        ckB += ckA;
+    }
+    buffer[length++] = ckA;
+    buffer[length++] = ckB;
+    return length;
+}
+
+// Build a Unicore binary message, returns the message length in bytes
+size_t buildUnicoreBinaryMessage(uint8_t *buffer)
+{
+    uint32_t crc;
+    size_t length;
+    SEMP_UNICORE_HEADER header;
+
+    // Build the header for a BESTNAV message followed by the payload
+    length = 72 + 8 * (corpusMessages % 8);
+    memset(&header, 0, sizeof(header));
+    header.syncA = SEMP_UNICORE_BINARY_PREAMBLE;
+    header.syncB = 0x44;
+    header.syncC = 0xb5;
+    header.messageId = 2118;
+    header.messageLength = length;
+    header.weekNumber = 2283;
+    header.secondsOfWeek = corpusMessages * 1000;
+    memcpy(buffer, &header, sizeof(header));
+    fillPayload(&buffer[sizeof(header)], length);
+    length += sizeof(header);
+
+    // Add the CRC
+    crc = semp_crc32Buffer(0, buffer, length);
+    buffer[length++] = crc;
+    buffer[length++] = crc >> 8;
+    buffer[length++] = crc >> 16;
+    buffer[length++] = crc >> 24;
+    return length;
+}
+
+// Build a Unicore hash sentence, returns the sentence length in bytes
+size_t buildUnicoreHashSentence(uint8_t *buffer)
+{
+    uint8_t checksum;
+    uint32_t crc;
+    const char *sentence;
+
+    // The VERSION sentence uses a CRC computed without the # or * characters
+    sentence = unicoreHashSentences[corpusMessages % unicoreHashSentenceCount];
+    if (strncmp(sentence, "VERSION,", 8) == 0)
+    {
+        crc = semp_crc32Buffer(0, (const uint8_t *)sentence, strlen(sentence));
+        return sprintf((char *)buffer, "#%s*%08lx\r\n", sentence, (unsigned long)crc);
+    }
+
+    // The other sentences use the NMEA checksum
+    checksum = 0;
+    for (const char *data = sentence; *data; data++)
+        checksum ^= *data;
+    return sprintf((char *)buffer, "#%s*%02X\r\n", sentence, checksum);
+}
+
+// Build an SBF message, returns the message length in bytes
+size_t buildSbfMessage(uint8_t *buffer)
+{
+    uint16_t crc;
+    int bit;
+    size_t index;
+    size_t length;
+
+    // Build a PVTGeodetic block, the length includes the header
+    length = 96;
+    buffer[0] = '$';
+    buffer[1] = '@';
+    buffer[4] = 4007 & 0xff;
+    buffer[5] = 4007 >> 8;
+    buffer[6] = length & 0xff;
+    buffer[7] = length >> 8;
+    fillPayload(&buffer[8], length - 8);
+
+    // Compute the CRC-CCITT over the ID, length and payload
+    crc = 0;
+    for (index = 4; index < length; index++)
+    {
+        crc ^= buffer[index] << 8;
+        for (bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+    buffer[2] = crc & 0xff;
+    buffer[3] = crc >> 8;
+    return length;
+}
+
+// Print the error message every 15 seconds
+void reportFatalError(const char *errorMsg)
+{
+    while (1)
+    {
+        Serial.print("HALTED: ");
+        Serial.print(errorMsg);
+        Serial.println();
+        sleep(15);
+    }
+}
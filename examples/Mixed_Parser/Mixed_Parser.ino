@@ -32,6 +32,13 @@ const char * const parserNames[] =
 };
 const int parserNameCount = sizeof(parserNames) / sizeof(parserNames[0]);
 
+// List the first byte of the messages for each of the parsers
+const int16_t preambleTable[] =
+{
+    SEMP_NMEA_PREAMBLE,
+    SEMP_UBLOX_PREAMBLE,
+};
+
 // Provide a mix of NMEA sentences and u-blox messages
 const uint8_t nmea_1[] =
 {
@@ -175,7 +182,8 @@ void setup()
     // Initialize the parser
     parse = sempBeginParser(parserTable, parserCount,
                             parserNames, parserNameCount,
-                            0, BUFFER_LENGTH, processMessage, "Mixed_Parser");
+                            0, BUFFER_LENGTH, processMessage, "Mixed_Parser",
+                            &Serial, nullptr, nullptr, preambleTable);
     if (!parse)
         reportFatalError("Failed to initialize the parser");
 
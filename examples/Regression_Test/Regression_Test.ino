@@ -0,0 +1,2210 @@
+/*
+  SparkFun parser regression test example sketch
+
+  This example looks for differences between the ways of passing data to
+  the parsers and for throughput regressions.  Data streams resembling
+  the output of common GNSS receivers are generated and then damaged in
+  a repeatable way: flipping bits, inserting and deleting bytes, copying
+  pieces of the stream over other pieces, overwriting runs of bytes and
+  corrupting the header bytes that follow each preamble, such as the
+  message length fields.  Each damaged data stream is passed to:
+
+    * sempParseNextByte
+    * sempParseBuffer using random chunk sizes
+    * sempParseBuffer with zero-copy enabled
+    * SEMP_PARSER_SET parseNextByte
+    * SEMP_PARSER_SET parseBuffer using random chunk sizes
+
+  with resync both disabled and enabled.  The type, length and contents
+  of each message passed to the end of message callback are combined
+  into a hash value, which must match the hash value produced by
+  sempParseNextByte.  With resync enabled, sempParseNextByte must also
+  find at least as many messages as without resync.  Idle bytes follow
+  each data stream, ending a false message that started near the end of
+  the data stream and delivering the messages found when rescanning it.
+  The mismatches are displayed with the pass number that reproduces them.
+
+  A data stream with random bytes between the messages, including copies
+  of the message headers with and without a corrupted length, is then
+  parsed with and without resync.  Resync must find all of the messages.
+
+  The throughput of sempParseNextByte and sempParseBuffer is then
+  measured using the valid data streams.  sempParseBuffer skips the bytes
+  between the messages and consumes the runs of payload bytes, the test
+  fails when its throughput is below MINIMUM_SPEEDUP_PERCENT of the
+  throughput of sempParseNextByte measured on the same board.
+
+  Finally the known answer checks build messages with known field values
+  and compare the results of the RTCM decoders, the sentence field
+  routines, the byte and message rings, the splitter and the epoch
+  grouping with the expected values.  The statistics are checked when
+  built with SEMP_STATS and the message filter, forwarding, batch
+  delivery, binary log, pool and file descriptor stream are checked when
+  built with SEMP_FEATURES.
+
+  The data stream is parsed by the routine checkDataStream, which may
+  also be called with data supplied by a fuzzer.
+
+  License: MIT. Please see LICENSE.md for more details
+*/
+
+#include <SparkFun_Extensible_Message_Parser.h> //http://librarymanager/All#SparkFun_Extensible_Message_Parser
+#include <SparkFun_Extensible_Message_Parser_Set.h>
+#if SEMP_STREAM_FD
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif  // SEMP_STREAM_FD
+
+//----------------------------------------
+// Constants
+//----------------------------------------
+
+// Size of the generated data stream, reduce for processors with less RAM
+#define CORPUS_BYTES            (16 * 1024)
+
+// Space for the bytes added to the data stream
+#define INSERT_BYTES            1024
+
+// Number of damaged data streams checked for each regression test
+#define FUZZ_PASSES             30
+
+// Largest number of bytes passed to sempParseBuffer
+#define MAXIMUM_CHUNK_BYTES     300
+
+// Number of bytes passed to sempParseBuffer when measuring the throughput
+#define CHUNK_BYTES             256
+
+// Minimum duration of each throughput measurement
+#define RUN_MICROSECONDS        (500 * 1000)
+
+// Minimum throughput of sempParseBuffer in percent of the throughput of
+// sempParseNextByte
+#define MINIMUM_SPEEDUP_PERCENT 150
+
+// Account for the largest messages
+#define BUFFER_LENGTH           3000
+
+// Largest message built by the message builders
+#define MAXIMUM_MESSAGE_BYTES   1100
+
+// Largest run of random bytes placed between the messages of the noisy
+// data stream
+#define NOISE_BYTES             128
+
+// Number of message header bytes copied into the noise
+#define NOISE_HEADER_BYTES      8
+
+// Size of the byte ring used by the known answer checks, a power of two
+#define RING_BYTES              256
+
+// Number of messages saved by the known answer checks
+#define CAPTURE_MESSAGES        8
+
+// Number of bytes saved from the start of each message
+#define CAPTURE_BYTES           128
+
+// Message types in the generated data stream
+#define MSG_NMEA                0x01
+#define MSG_RTCM                0x02
+#define MSG_UBLOX               0x04
+#define MSG_UNICORE_BINARY      0x08
+#define MSG_UNICORE_HASH        0x10
+#define MSG_SBF                 0x20
+#define MSG_SPARTN              0x40
+
+// FNV-1a hash of the messages
+#define HASH_OFFSET_BASIS       0x811c9dc5
+#define HASH_PRIME              0x01000193
+
+// NMEA sentences without the checksum
+const char * const nmeaSentences[] =
+{
+    "GPGGA,210230,3855.4487,N,09446.0071,W,1,07,1.1,370.5,M,-29.5,M,,",
+    "GPGSV,2,1,08,02,74,042,45,04,18,190,36,07,67,279,42,12,29,323,36",
+    "GPGSV,2,2,08,15,30,050,47,19,09,158,,26,12,281,40,27,38,173,41",
+    "GPRMC,210230,A,3855.4487,N,09446.0071,W,0.0,076.2,130495,003.8,E",
+};
+const int nmeaSentenceCount = sizeof(nmeaSentences) / sizeof(nmeaSentences[0]);
+
+// Unicore hash sentences without the CRC
+const char * const unicoreHashSentences[] =
+{
+    "VERSION,97,GPS,FINE,2282,248561000,0,0,18,676;UM980,R4.10Build7923,HRPT00-S10C-P,2310415000001-MD22B1224962616,ff3bac96f31f9bdd,2022/09/28",
+    "BESTNAVA,97,GPS,FINE,2283,499142000,0,0,18,964;SOL_COMPUTED,PPP,40.09029479894,-105.18505761208,1560.0356,-17.0000,WGS84,0.0107,0.0094,0.0210,\"0\",0.000,0.000,35,30,30,30,0,06,00,33",
+};
+const int unicoreHashSentenceCount = sizeof(unicoreHashSentences) / sizeof(unicoreHashSentences[0]);
+
+// SPARTN OCB 0 message from the SPARTN_Test example
+const uint8_t spartnMessage[] =
+{
+    0x73, 0x00, 0x16, 0x69, 0x08, 0xBF, 0x33, 0xD0, 0x78, 0x6C, 0x2D, 0x48, 0x2A, 0x18, 0xF0, 0xC0,
+    0x3E, 0x1D, 0x9C, 0x37, 0x7E, 0x9A, 0x5E, 0xE8, 0x39, 0xC6, 0x0E, 0xBD, 0xDE, 0xA9, 0x7D, 0x43,
+    0xB9, 0x17, 0x96, 0xC7, 0x04, 0xAF, 0x9A, 0x4B, 0xBF, 0x70, 0x65, 0xC3, 0x66, 0x80, 0xCA, 0x45,
+    0x20, 0x16, 0x41, 0xA4, 0x14, 0x2B, 0x5B, 0xD4, 0x11, 0x6F, 0x64,
+};
+
+// RTCM 1005 and 1006 field values for the known answer checks, the ECEF
+// coordinates and antenna height are in units of 0.0001 m.  The second
+// station uses the limits of the 38-bit coordinates.
+const SEMP_RTCM_1005 rtcmStations[] =
+{
+    // Number, ID, ITRF, GPS, GLONASS, Galileo, reference, oscillator, quarter cycle,
+    // X, Y, Z, height
+    {1005, 2003, 14, true, true, true, false, true, 2,
+     11141045999LL, -48507297108LL, 39755214643LL, 0},
+    {1006, 4095, 0, true, false, false, true, false, 0,
+     -1LL, 137438953471LL, -137438953472LL, 15000},
+};
+const int rtcmStationCount = sizeof(rtcmStations) / sizeof(rtcmStations[0]);
+
+// RTCM MSM4 field values for the known answer checks, the GPS satellites
+// 5 and 12 with the signals 2 (1C) and 15 (2L), satellite 5 has no 2L cell
+const SEMP_RTCM_MSM rtcmMsmHeader =
+{
+    // Number, ID, epoch time, MSM type, GNSS, multiple message, IODS,
+    // clock steering, external clock, smoothing, smoothing interval
+    1074, 2003, 345600000, 4, 7, false, 3, 1, 2, true, 5,
+};
+const SEMP_RTCM_MSM_SATELLITE rtcmMsmSatellites[] =
+{
+    // ID, rough range, extended info, rough range modulo 1 ms, rate
+    {5, 76, 0, 512, 0},
+    {12, 80, 0, 1023, 0},
+};
+const int rtcmMsmSatelliteCount = sizeof(rtcmMsmSatellites) / sizeof(rtcmMsmSatellites[0]);
+const uint8_t rtcmMsmSignalIds[] = {2, 15};
+const int rtcmMsmSignalCount = sizeof(rtcmMsmSignalIds) / sizeof(rtcmMsmSignalIds[0]);
+const SEMP_RTCM_MSM_CELL rtcmMsmCells[] =
+{
+    // Pseudorange, phase range, rate, lock time, CNR, half-cycle, satellite, signal
+    {-1000, -200000, 0, 5, 45, 0, 0, 2},
+    {2000, 100000, 0, 15, 38, 1, 1, 2},
+    {16383, 2097151, 0, 0, 63, 0, 1, 15},
+};
+const int rtcmMsmCellCount = sizeof(rtcmMsmCells) / sizeof(rtcmMsmCells[0]);
+
+// RTCM 1033 field values for the known answer checks
+const SEMP_RTCM_1033 rtcmDescriptors =
+{
+    2003,                       // Station ID
+    1,                          // Antenna setup ID
+    "TRM59800.00     SCIS",     // Antenna descriptor
+    "5000118056",               // Antenna serial number
+    "SEPT POLARX5",             // Receiver type
+    "5.4.0",                    // Receiver firmware
+    "3029012",                  // Receiver serial number
+};
+
+// Sentence field values for the known answer checks, a nullptr value
+// when the sentence does not have the field
+typedef struct _FIELD_ANSWER
+{
+    uint16_t field;                         // Field number
+    const char *value;                      // Field value
+} FIELD_ANSWER;
+
+const FIELD_ANSWER nmeaFieldAnswers[] =
+{
+    {0, "GPGGA"}, {1, "210230"}, {9, "370.5"}, {11, "-29.5"}, {13, ""}, {14, ""}, {15, nullptr},
+};
+const int nmeaFieldAnswerCount = sizeof(nmeaFieldAnswers) / sizeof(nmeaFieldAnswers[0]);
+
+const FIELD_ANSWER unicoreHashFieldAnswers[] =
+{
+    {0, "BESTNAVA"}, {9, "964"}, {10, "SOL_COMPUTED"}, {12, "40.09029479894"}, {30, "33"}, {31, nullptr},
+};
+const int unicoreHashFieldAnswerCount = sizeof(unicoreHashFieldAnswers) / sizeof(unicoreHashFieldAnswers[0]);
+
+// Epoch callbacks for the known answer checks, in the order of delivery
+typedef struct _EPOCH_ANSWER
+{
+    uint32_t id;                            // Message ID
+    uint32_t time;                          // Epoch time, not used for single messages
+    uint16_t type;                          // Index into the parser table
+    uint8_t status;                         // Epoch status
+    uint8_t message;                        // Message number in the data
+} EPOCH_ANSWER;
+
+const EPOCH_ANSWER epochAnswers[] =
+{
+    {SEMP_NMEA_ID_GGA, 0, 2, SEMP_EPOCH_SINGLE, 1},
+    {0x0107, 1000, 0, SEMP_EPOCH_COMPLETE, 0},
+    {0x0109, 1000, 0, SEMP_EPOCH_COMPLETE, 2},
+    {0x0161, 1000, 0, SEMP_EPOCH_COMPLETE, 3},
+    {0x0107, 2000, 0, SEMP_EPOCH_ENDED, 4},
+};
+const int epochAnswerCount = sizeof(epochAnswers) / sizeof(epochAnswers[0]);
+
+// Build the tables listing the parsers for each regression test, the SBF
+// parser is tested by itself as in the Benchmark example
+SEMP_PARSE_ROUTINE const nmeaParserTable[] = {sempNmeaPreamble};
+SEMP_PARSE_ROUTINE const rtcmParserTable[] = {sempRtcmPreamble};
+SEMP_PARSE_ROUTINE const ubloxParserTable[] = {sempUbloxPreamble};
+SEMP_PARSE_ROUTINE const unicoreBinaryParserTable[] = {sempUnicoreBinaryPreamble};
+SEMP_PARSE_ROUTINE const unicoreHashParserTable[] = {sempUnicoreHashPreamble};
+SEMP_PARSE_ROUTINE const sbfParserTable[] = {sempSbfPreamble};
+SEMP_PARSE_ROUTINE const spartnParserTable[] = {sempSpartnPreamble};
+SEMP_PARSE_ROUTINE const um980ParserTable[] =
+{
+    sempNmeaPreamble,
+    sempUnicoreBinaryPreamble,
+    sempUnicoreHashPreamble,
+};
+SEMP_PARSE_ROUTINE const zedF9pParserTable[] =
+{
+    sempUbloxPreamble,
+    sempRtcmPreamble,
+    sempNmeaPreamble,
+};
+SEMP_PARSE_ROUTINE const allParserTable[] =
+{
+    sempNmeaPreamble,
+    sempUbloxPreamble,
+    sempRtcmPreamble,
+    sempUnicoreBinaryPreamble,
+    sempUnicoreHashPreamble,
+    sempSpartnPreamble,
+};
+
+const char * const nmeaParserNames[] = {"NMEA parser"};
+const char * const rtcmParserNames[] = {"RTCM parser"};
+const char * const ubloxParserNames[] = {"U-Blox parser"};
+const char * const unicoreBinaryParserNames[] = {"Unicore binary parser"};
+const char * const unicoreHashParserNames[] = {"Unicore hash parser"};
+const char * const sbfParserNames[] = {"SBF parser"};
+const char * const spartnParserNames[] = {"SPARTN parser"};
+const char * const um980ParserNames[] =
+{
+    "NMEA parser",
+    "Unicore binary parser",
+    "Unicore hash parser",
+};
+const char * const zedF9pParserNames[] =
+{
+    "U-Blox parser",
+    "RTCM parser",
+    "NMEA parser",
+};
+const char * const allParserNames[] =
+{
+    "NMEA parser",
+    "U-Blox parser",
+    "RTCM parser",
+    "Unicore binary parser",
+    "Unicore hash parser",
+    "SPARTN parser",
+};
+
+const int16_t nmeaPreambleTable[] = {SEMP_NMEA_PREAMBLE};
+const int16_t rtcmPreambleTable[] = {SEMP_RTCM_PREAMBLE};
+const int16_t ubloxPreambleTable[] = {SEMP_UBLOX_PREAMBLE};
+const int16_t unicoreBinaryPreambleTable[] = {SEMP_UNICORE_BINARY_PREAMBLE};
+const int16_t unicoreHashPreambleTable[] = {SEMP_UNICORE_HASH_PREAMBLE};
+const int16_t sbfPreambleTable[] = {SEMP_SBF_PREAMBLE};
+const int16_t spartnPreambleTable[] = {SEMP_SPARTN_PREAMBLE};
+const int16_t um980PreambleTable[] =
+{
+    SEMP_NMEA_PREAMBLE,
+    SEMP_UNICORE_BINARY_PREAMBLE,
+    SEMP_UNICORE_HASH_PREAMBLE,
+};
+const int16_t zedF9pPreambleTable[] =
+{
+    SEMP_UBLOX_PREAMBLE,
+    SEMP_RTCM_PREAMBLE,
+    SEMP_NMEA_PREAMBLE,
+};
+const int16_t allPreambleTable[] =
+{
+    SEMP_NMEA_PREAMBLE,
+    SEMP_UBLOX_PREAMBLE,
+    SEMP_RTCM_PREAMBLE,
+    SEMP_UNICORE_BINARY_PREAMBLE,
+    SEMP_UNICORE_HASH_PREAMBLE,
+    SEMP_SPARTN_PREAMBLE,
+};
+
+// Build the parser sets, the protocols are listed in the same order as
+// the parser tables so that the message types match
+typedef SEMP_PARSER_SET<BUFFER_LENGTH, SEMP_NMEA_PROTOCOL> nmeaParserSet;
+typedef SEMP_PARSER_SET<BUFFER_LENGTH, SEMP_RTCM_PROTOCOL> rtcmParserSet;
+typedef SEMP_PARSER_SET<BUFFER_LENGTH, SEMP_UBLOX_PROTOCOL> ubloxParserSet;
+typedef SEMP_PARSER_SET<BUFFER_LENGTH, SEMP_UNICORE_BINARY_PROTOCOL> unicoreBinaryParserSet;
+typedef SEMP_PARSER_SET<BUFFER_LENGTH, SEMP_UNICORE_HASH_PROTOCOL> unicoreHashParserSet;
+typedef SEMP_PARSER_SET<BUFFER_LENGTH, SEMP_SBF_PROTOCOL> sbfParserSet;
+typedef SEMP_PARSER_SET<BUFFER_LENGTH, SEMP_SPARTN_PROTOCOL> spartnParserSet;
+typedef SEMP_PARSER_SET<BUFFER_LENGTH,
+                        SEMP_NMEA_PROTOCOL,
+                        SEMP_UNICORE_BINARY_PROTOCOL,
+                        SEMP_UNICORE_HASH_PROTOCOL> um980ParserSet;
+typedef SEMP_PARSER_SET<BUFFER_LENGTH,
+                        SEMP_UBLOX_PROTOCOL,
+                        SEMP_RTCM_PROTOCOL,
+                        SEMP_NMEA_PROTOCOL> zedF9pParserSet;
+typedef SEMP_PARSER_SET<BUFFER_LENGTH,
+                        SEMP_NMEA_PROTOCOL,
+                        SEMP_UBLOX_PROTOCOL,
+                        SEMP_RTCM_PROTOCOL,
+                        SEMP_UNICORE_BINARY_PROTOCOL,
+                        SEMP_UNICORE_HASH_PROTOCOL,
+                        SEMP_SPARTN_PROTOCOL> allParserSet;
+
+// Ways of passing the data stream to the parser
+enum
+{
+    MODE_NEXT_BYTE = 0,
+    MODE_BUFFER,
+    MODE_ZERO_COPY,
+    MODE_SET_NEXT_BYTE,
+    MODE_SET_BUFFER,
+    MODE_COUNT
+};
+
+const char * const modeNames[] =
+{
+    "next byte",
+    "buffer",
+    "zero-copy",
+    "set next byte",
+    "set buffer",
+};
+
+// Ways of damaging the data stream
+enum
+{
+    DAMAGE_NONE = 0,
+    DAMAGE_BIT_FLIPS,
+    DAMAGE_INSERT,
+    DAMAGE_DELETE,
+    DAMAGE_COPY,
+    DAMAGE_OVERWRITE,
+    DAMAGE_HEADER,
+    DAMAGE_COUNT
+};
+
+const char * const damageNames[] =
+{
+    "none",
+    "bit flips",
+    "insert",
+    "delete",
+    "copy",
+    "overwrite",
+    "header",
+};
+
+typedef void (*SET_PARSE_ROUTINE)(const uint8_t *data, size_t length, int mode, bool resync);
+
+typedef const char * (*GET_FIELD_ROUTINE)(const SEMP_PARSE_STATE *parse, uint16_t field, size_t *length);
+
+typedef struct _REGRESSION_TEST
+{
+    const char *name;                       // Name of the data stream
+    uint32_t messageTypes;                  // Messages in the data stream
+    const SEMP_PARSE_ROUTINE *parserTable;  // Table of parsers
+    const char * const *parserNames;        // Table of parser names
+    const int16_t *preambleTable;           // Table of preamble bytes
+    uint16_t parserCount;                   // Number of parsers
+    SET_PARSE_ROUTINE parseWithSet;         // Parse the data using the parser set
+} REGRESSION_TEST;
+
+// Message saved by the known answer checks
+typedef struct _CAPTURED_MESSAGE
+{
+    const uint8_t *buffer;                  // Address of the message during the callback
+    size_t offset;                          // Offset of the message in the data or arena
+    uint32_t length;                        // Message length in bytes
+    uint32_t id;                            // Message ID, stream number or decode result
+    uint32_t time;                          // Epoch time
+    uint16_t type;                          // Index into the parser table
+    uint8_t status;                         // Epoch status
+    uint8_t data[CAPTURE_BYTES];            // First bytes of the message
+} CAPTURED_MESSAGE;
+
+//----------------------------------------
+// Locals
+//----------------------------------------
+
+CAPTURED_MESSAGE captured[CAPTURE_MESSAGES];
+uint32_t capturedCount;
+uint32_t chunkValue;
+uint8_t corpus[CORPUS_BYTES + INSERT_BYTES];
+uint32_t corpusMessages;
+SEMP_RTCM_1005 decodedStations[2];
+SEMP_RTCM_1033 decodedDescriptors;
+SEMP_RTCM_MSM decodedMsm;
+SEMP_EPOCH epochState;
+uint32_t errorCount;
+const uint8_t idleBytes[BUFFER_LENGTH] = {0};
+uint32_t knownAnswerCount;
+uint32_t messageCount;
+uint32_t messageHash;
+uint32_t randomValue;
+uint64_t ringStorage[2 * RING_BYTES / sizeof(uint64_t)];
+
+#if SEMP_FEATURES
+uint32_t batchCount;
+uint32_t forwardAborts;
+uint32_t forwardCommitted;
+uint8_t forwardData[512];
+uint32_t forwardLength;
+#endif  // SEMP_FEATURES
+
+//----------------------------------------
+// Support routines
+//----------------------------------------
+
+// Call back from within parser, for end of message
+void recordMessage(SEMP_PARSE_STATE *parse, uint16_t type)
+{
+    uint32_t index;
+    uint32_t length;
+
+    // Zero-copy delivers the NMEA and Unicore hash sentences without the
+    // carriage return and line feed added by the parsers, leave the line
+    // ending out of the hash value
+    length = parse->length;
+    while (length && ((parse->buffer[length - 1] == '\r') || (parse->buffer[length - 1] == '\n')))
+        length -= 1;
+
+    // Add the message type, length and contents to the hash value
+    messageCount += 1;
+    messageHash = hashByte(messageHash, type);
+    messageHash = hashByte(messageHash, type >> 8);
+    for (index = 0; index < 32; index += 8)
+        messageHash = hashByte(messageHash, length >> index);
+    for (index = 0; index < length; index++)
+        messageHash = hashByte(messageHash, parse->buffer[index]);
+}
+
+// Call back from within parser, for end of message
+void countMessage(SEMP_PARSE_STATE *parse, uint16_t type)
+{
+    messageCount += 1;
+}
+
+// Call back from within parser, for end of message
+void captureParsedMessage(SEMP_PARSE_STATE *parse, uint16_t type)
+{
+    captureMessage(parse->buffer, 0, parse->length, parse->messageId, type);
+}
+
+// Save a message for the known answer checks, returns the saved message
+// or nullptr when too many messages were delivered
+CAPTURED_MESSAGE * captureMessage(const uint8_t *buffer,
+                                  size_t offset,
+                                  size_t length,
+                                  uint32_t id,
+                                  uint16_t type)
+{
+    CAPTURED_MESSAGE *message;
+
+    // Count the message even when it is not saved
+    if (capturedCount++ >= CAPTURE_MESSAGES)
+        return nullptr;
+    message = &captured[capturedCount - 1];
+    message->buffer = buffer;
+    message->offset = offset;
+    message->length = length;
+    message->id = id;
+    message->time = 0;
+    message->type = type;
+    message->status = 0;
+    memcpy(message->data, buffer, SEMP_MIN(length, CAPTURE_BYTES));
+    return message;
+}
+
+// Compare a value with its known answer
+void checkAnswer(const char *check, const char *name, int64_t value, int64_t expected)
+{
+    knownAnswerCount += 1;
+    if (value != expected)
+    {
+        Serial.printf("ERROR: %s %s is %lld, expecting %lld\r\n",
+                      check, name, (long long)value, (long long)expected);
+        errorCount += 1;
+    }
+}
+
+// Compare a saved message with its known answer, returns the saved
+// message or nullptr when the message was not saved
+const CAPTURED_MESSAGE * checkCapturedMessage(const char *check,
+                                              uint32_t index,
+                                              uint16_t type,
+                                              const uint8_t *data,
+                                              size_t length)
+{
+    const CAPTURED_MESSAGE *message;
+    char name[32];
+
+    // Verify that the message was delivered
+    knownAnswerCount += 1;
+    if (index >= SEMP_MIN(capturedCount, CAPTURE_MESSAGES))
+    {
+        Serial.printf("ERROR: %s message %ld not delivered\r\n", check, index);
+        errorCount += 1;
+        return nullptr;
+    }
+
+    // Compare the type, length and the saved bytes
+    message = &captured[index];
+    sprintf(name, "message %ld type", index);
+    checkAnswer(check, name, message->type, type);
+    sprintf(name, "message %ld length", index);
+    checkAnswer(check, name, message->length, length);
+    sprintf(name, "message %ld matches", index);
+    checkAnswer(check, name, memcmp(message->data, data, SEMP_MIN(length, CAPTURE_BYTES)) == 0, true);
+    return message;
+}
+
+// Compare the fields of a sentence with their known answers
+void checkFields(const char *check,
+                 const SEMP_PARSE_STATE *parse,
+                 GET_FIELD_ROUTINE getField,
+                 const FIELD_ANSWER *answers,
+                 int answerCount)
+{
+    const char *expected;
+    int index;
+    size_t length;
+    const char *value;
+
+    for (index = 0; index < answerCount; index++)
+    {
+        knownAnswerCount += 1;
+        length = 0;
+        value = getField(parse, answers[index].field, &length);
+        expected = answers[index].value;
+        if (expected
+            ? ((!value) || (length != strlen(expected)) || memcmp(value, expected, length))
+            : (value != nullptr))
+        {
+            Serial.printf("ERROR: %s field %d is %.*s, expecting %s\r\n",
+                          check, answers[index].field,
+                          value ? (int)length : 7, value ? value : "nullptr",
+                          expected ? expected : "nullptr");
+            errorCount += 1;
+        }
+    }
+}
+
+// Add a byte to the hash value
+uint32_t hashByte(uint32_t hash, uint8_t data)
+{
+    return (hash ^ data) * HASH_PRIME;
+}
+
+// Get the next chunk size, repeatable between modes
+size_t nextChunk()
+{
+    chunkValue = chunkValue * 1103515245 + 12345;
+    return 1 + ((chunkValue >> 16) % MAXIMUM_CHUNK_BYTES);
+}
+
+//----------------------------------------
+// Parser set routine
+//----------------------------------------
+
+// Parse the data stream using a parser set
+template <typename PARSER_SET>
+void parseWithParserSet(const uint8_t *data, size_t length, int mode, bool resync)
+{
+    size_t bytes;
+    size_t offset;
+    static PARSER_SET parser;
+
+    // Initialize the parser, the parse structure is in the parser set
+    if (!parser.begin(recordMessage, "Parser set", &Serial))
+        reportFatalError("Failed to initialize the parser set");
+    sempDisableErrorOutput(parser.parse);
+    if (resync)
+        sempEnableResync(parser.parse);
+
+    // Parse the data stream followed by the idle bytes
+    if (mode == MODE_SET_NEXT_BYTE)
+    {
+        for (offset = 0; offset < length; offset++)
+            parser.parseNextByte(data[offset]);
+        for (offset = 0; offset < sizeof(idleBytes); offset++)
+            parser.parseNextByte(idleBytes[offset]);
+    }
+    else
+    {
+        for (offset = 0; offset < length; offset += bytes)
+        {
+            bytes = nextChunk();
+            if (bytes > (length - offset))
+                bytes = length - offset;
+            parser.parseBuffer(&data[offset], bytes);
+        }
+        parser.parseBuffer(idleBytes, sizeof(idleBytes));
+    }
+}
+
+//----------------------------------------
+// Regression tests
+//----------------------------------------
+
+#define REGRESSION_TEST_INIT(name, types, x)                            \
+    {name, types, x##ParserTable, x##ParserNames, x##PreambleTable,     \
+     sizeof(x##ParserTable) / sizeof(x##ParserTable[0]),                \
+     parseWithParserSet<x##ParserSet>}
+
+const REGRESSION_TEST regressionTests[] =
+{
+    REGRESSION_TEST_INIT("NMEA", MSG_NMEA, nmea),
+    REGRESSION_TEST_INIT("RTCM", MSG_RTCM, rtcm),
+    REGRESSION_TEST_INIT("U-Blox", MSG_UBLOX, ublox),
+    REGRESSION_TEST_INIT("Unicore binary", MSG_UNICORE_BINARY, unicoreBinary),
+    REGRESSION_TEST_INIT("Unicore hash", MSG_UNICORE_HASH, unicoreHash),
+    REGRESSION_TEST_INIT("SBF", MSG_SBF, sbf),
+    REGRESSION_TEST_INIT("SPARTN", MSG_SPARTN, spartn),
+    REGRESSION_TEST_INIT("UM980", MSG_NMEA | MSG_UNICORE_BINARY | MSG_UNICORE_HASH, um980),
+    REGRESSION_TEST_INIT("ZED-F9P", MSG_UBLOX | MSG_RTCM | MSG_NMEA, zedF9p),
+    REGRESSION_TEST_INIT("All but SBF", MSG_NMEA | MSG_UBLOX | MSG_RTCM
+                         | MSG_UNICORE_BINARY | MSG_UNICORE_HASH | MSG_SPARTN, all),
+};
+const int regressionTestCount = sizeof(regressionTests) / sizeof(regressionTests[0]);
+
+//----------------------------------------
+// Test routine
+//----------------------------------------
+
+// Initialize the system
+void setup()
+{
+    size_t corpusBytes;
+    int damage;
+    int index;
+    uint32_t pass;
+
+    delay(1000);
+
+    Serial.begin(115200);
+    Serial.println();
+    Serial.println("Regression_Test example sketch");
+    Serial.println();
+
+    // Compare the callbacks for each of the data streams
+    errorCount = 0;
+    for (index = 0; index < regressionTestCount; index++)
+    {
+        Serial.printf("%s\r\n", regressionTests[index].name);
+        for (pass = 0; pass < FUZZ_PASSES; pass++)
+        {
+            // Build the data stream, then damage it
+            corpusBytes = buildCorpus(regressionTests[index].messageTypes, 0);
+            randomValue = pass + 1;
+            damage = pass % DAMAGE_COUNT;
+            corpusBytes = damageCorpus(&regressionTests[index], corpusBytes, damage);
+
+            // Verify that all of the valid messages were found
+            checkDataStream(&regressionTests[index], corpus, corpusBytes, pass);
+            if ((damage == DAMAGE_NONE) && (messageCount != corpusMessages))
+            {
+                Serial.printf("ERROR: Found %ld messages, expecting %ld\r\n",
+                              messageCount, corpusMessages);
+                errorCount += 1;
+            }
+        }
+
+        // Verify that resync finds the messages between the noise
+        corpusBytes = buildCorpus(regressionTests[index].messageTypes, NOISE_BYTES);
+        checkResync(&regressionTests[index], corpusBytes);
+
+        // Compare the throughput of sempParseBuffer and sempParseNextByte
+        corpusBytes = buildCorpus(regressionTests[index].messageTypes, 0);
+        checkThroughput(&regressionTests[index], corpusBytes);
+        Serial.println();
+    }
+
+    // Compare the results with values computed from the messages
+    checkKnownAnswers();
+
+    // Display the test result
+    if (errorCount)
+        Serial.printf("Regression test FAILED, %ld errors\r\n", errorCount);
+    else
+        Serial.println("Regression test passed");
+}
+
+// Main loop processing after system is initialized
+void loop()
+{
+    // Nothing to do here...
+}
+
+// Parse the data stream each way and compare the callbacks, returns true
+// when the callbacks match and resync finds at least as many messages as
+// parsing without resync
+bool checkDataStream(const REGRESSION_TEST *test, const uint8_t *data, size_t length, uint32_t pass)
+{
+    uint32_t expectedCount;
+    uint32_t expectedHash;
+    bool match;
+    int mode;
+    uint32_t noResyncCount;
+    int resync;
+
+    // Parse the data stream with and without resync
+    match = true;
+    for (resync = 0; resync < 2; resync++)
+    {
+        // sempParseNextByte provides the expected callbacks
+        parseDataStream(test, data, length, MODE_NEXT_BYTE, resync, pass);
+        expectedCount = messageCount;
+        expectedHash = messageHash;
+
+        // Rescanning the failed messages must not lose messages
+        if (!resync)
+            noResyncCount = expectedCount;
+        else if (expectedCount < noResyncCount)
+        {
+            Serial.printf("ERROR: %s pass %ld, resync found %ld messages, expecting at least %ld\r\n",
+                          test->name, pass, expectedCount, noResyncCount);
+            errorCount += 1;
+            match = false;
+        }
+
+        // Compare the callbacks of the other modes
+        for (mode = MODE_NEXT_BYTE + 1; mode < MODE_COUNT; mode++)
+        {
+            parseDataStream(test, data, length, mode, resync, pass);
+            if ((messageCount != expectedCount) || (messageHash != expectedHash))
+            {
+                Serial.printf("ERROR: %s pass %ld, %s%s found %ld messages (0x%08lx), expecting %ld (0x%08lx)\r\n",
+                              test->name, pass, modeNames[mode],
+                              resync ? " with resync" : "",
+                              messageCount, messageHash,
+                              expectedCount, expectedHash);
+                errorCount += 1;
+                match = false;
+            }
+        }
+    }
+
+    // Leave the expected callbacks for the caller
+    messageCount = expectedCount;
+    messageHash = expectedHash;
+    return match;
+}
+
+// Parse the noisy data stream with and without resync.  The messages are
+// complete, so resync must find all of them.
+void checkResync(const REGRESSION_TEST *test, size_t corpusBytes)
+{
+    uint32_t noResyncCount;
+
+    // Verify that the parse modes agree on the noisy data stream
+    checkDataStream(test, corpus, corpusBytes, FUZZ_PASSES);
+    parseDataStream(test, corpus, corpusBytes, MODE_NEXT_BYTE, false, FUZZ_PASSES);
+    noResyncCount = messageCount;
+    parseDataStream(test, corpus, corpusBytes, MODE_NEXT_BYTE, true, FUZZ_PASSES);
+    if (messageCount != corpusMessages)
+    {
+        Serial.printf("ERROR: %s noise, resync found %ld messages, expecting %ld, %ld without resync\r\n",
+                      test->name, messageCount, corpusMessages, noResyncCount);
+        errorCount += 1;
+    }
+    else
+        Serial.printf("    Noise: %ld messages, %ld without resync\r\n",
+                      messageCount, noResyncCount);
+}
+
+// Parse the data stream using the specified mode
+void parseDataStream(const REGRESSION_TEST *test,
+                     const uint8_t *data,
+                     size_t length,
+                     int mode,
+                     bool resync,
+                     uint32_t pass)
+{
+    size_t bytes;
+    size_t offset;
+    SEMP_PARSE_STATE *parse;
+
+    // Each mode uses the same chunk sizes
+    chunkValue = pass + 1;
+    messageCount = 0;
+    messageHash = HASH_OFFSET_BASIS;
+
+    // The parser set contains its own parse structure
+    if (mode >= MODE_SET_NEXT_BYTE)
+    {
+        test->parseWithSet(data, length, mode, resync);
+        return;
+    }
+
+    // Initialize the parser
+    parse = sempBeginParser(test->parserTable, test->parserCount,
+                            test->parserNames, test->parserCount,
+                            0, BUFFER_LENGTH, recordMessage, test->name,
+                            &Serial, nullptr, nullptr, test->preambleTable);
+    if (!parse)
+        reportFatalError("Failed to initialize the parser");
+    sempDisableErrorOutput(parse);
+    if (resync)
+        sempEnableResync(parse);
+    if (mode == MODE_ZERO_COPY)
+        sempEnableZeroCopy(parse);
+
+    // Parse the data stream followed by the idle bytes
+    if (mode == MODE_NEXT_BYTE)
+    {
+        for (offset = 0; offset < length; offset++)
+            sempParseNextByte(parse, data[offset]);
+        for (offset = 0; offset < sizeof(idleBytes); offset++)
+            sempParseNextByte(parse, idleBytes[offset]);
+    }
+    else
+    {
+        for (offset = 0; offset < length; offset += bytes)
+        {
+            bytes = nextChunk();
+            if (bytes > (length - offset))
+                bytes = length - offset;
+            sempParseBuffer(parse, &data[offset], bytes);
+        }
+        sempParseBuffer(parse, idleBytes, sizeof(idleBytes));
+    }
+
+    // Done with the parser
+    sempStopParser(&parse);
+}
+
+// Compare the throughput of sempParseBuffer with sempParseNextByte
+void checkThroughput(const REGRESSION_TEST *test, size_t corpusBytes)
+{
+    float bufferMBps;
+    float minimum;
+    float nextByteMBps;
+
+    // Measure both ways of passing the data on this board
+    nextByteMBps = measureThroughput(test, corpusBytes, MODE_NEXT_BYTE);
+    bufferMBps = measureThroughput(test, corpusBytes, MODE_BUFFER);
+
+    // sempParseBuffer must be faster than sempParseNextByte
+    minimum = nextByteMBps * MINIMUM_SPEEDUP_PERCENT / 100;
+    if (bufferMBps < minimum)
+    {
+        Serial.printf("ERROR: %s %.2f MB/s, expecting at least %.2f MB/s\r\n",
+                      test->name, bufferMBps, minimum);
+        errorCount += 1;
+    }
+    else
+        Serial.printf("    %8.2f MB/s, %.2f MB/s using sempParseNextByte\r\n",
+                      bufferMBps, nextByteMBps);
+}
+
+// Measure the throughput of sempParseNextByte or sempParseBuffer, returns
+// the throughput in MB/s
+float measureThroughput(const REGRESSION_TEST *test, size_t corpusBytes, int mode)
+{
+    size_t bytes;
+    uint32_t elapsed;
+    size_t offset;
+    SEMP_PARSE_STATE *parse;
+    uint32_t passes;
+    uint32_t start;
+
+    // Initialize the parser
+    parse = sempBeginParser(test->parserTable, test->parserCount,
+                            test->parserNames, test->parserCount,
+                            0, BUFFER_LENGTH, countMessage, test->name,
+                            &Serial, nullptr, nullptr, test->preambleTable);
+    if (!parse)
+        reportFatalError("Failed to initialize the parser");
+    sempDisableErrorOutput(parse);
+
+    // Parse the data stream until the run time expires
+    passes = 0;
+    start = micros();
+    do
+    {
+        if (mode == MODE_NEXT_BYTE)
+        {
+            for (offset = 0; offset < corpusBytes; offset++)
+                sempParseNextByte(parse, corpus[offset]);
+        }
+        else
+        {
+            for (offset = 0; offset < corpusBytes; offset += bytes)
+            {
+                bytes = SEMP_MIN(corpusBytes - offset, CHUNK_BYTES);
+                sempParseBuffer(parse, &corpus[offset], bytes);
+            }
+        }
+        passes += 1;
+        elapsed = micros() - start;
+    } while (elapsed < RUN_MICROSECONDS);
+
+    // Done with the parser
+    sempStopParser(&parse);
+    return (float)passes * corpusBytes / elapsed;
+}
+
+//----------------------------------------
+// Known answer checks
+//----------------------------------------
+
+// Compare the results of the decoders, rings, splitter, epochs and
+// optional features with values computed from the messages
+void checkKnownAnswers()
+{
+    Serial.println("Known answers");
+    knownAnswerCount = 0;
+    checkRtcmDecoders();
+    checkSentenceFields();
+    checkRings();
+    checkSplitter();
+    checkEpochs();
+#if SEMP_STATS
+    checkStatistics();
+#endif  // SEMP_STATS
+#if SEMP_FEATURES
+    checkMessageFilter();
+    checkForwarding();
+    checkBatchDelivery();
+    checkBinaryLog();
+    checkPool();
+#endif  // SEMP_FEATURES
+#if SEMP_STREAM_FD
+    checkStream();
+#endif  // SEMP_STREAM_FD
+    Serial.printf("    %ld values checked\r\n", knownAnswerCount);
+    Serial.println();
+}
+
+// Initialize a parser for the known answer checks
+SEMP_PARSE_STATE * beginCheckParser(const REGRESSION_TEST *test, SEMP_EOM_CALLBACK eomCallback)
+{
+    SEMP_PARSE_STATE *parse;
+
+    parse = sempBeginParser(test->parserTable, test->parserCount,
+                            test->parserNames, test->parserCount,
+                            0, BUFFER_LENGTH, eomCallback, test->name,
+                            &Serial, nullptr, nullptr, test->preambleTable);
+    if (!parse)
+        reportFatalError("Failed to initialize the parser");
+    sempDisableErrorOutput(parse);
+    capturedCount = 0;
+    return parse;
+}
+
+// Call back from within parser, decode the RTCM message
+void decodeRtcmMessage(SEMP_PARSE_STATE *parse, uint16_t type)
+{
+    bool decoded;
+
+    switch (sempRtcmGetMessageNumber(parse))
+    {
+    case 1005:
+    case 1006:
+        decoded = sempRtcmDecode1005(parse->buffer, parse->length,
+                                     &decodedStations[sempRtcmGetMessageNumber(parse) - 1005]);
+        break;
+    case 1033:
+        decoded = sempRtcmDecode1033(parse->buffer, parse->length, &decodedDescriptors);
+        break;
+    default:
+        decoded = sempRtcmDecodeMsm(parse->buffer, parse->length, &decodedMsm);
+        break;
+    }
+    captureMessage(parse->buffer, 0, parse->length, decoded, type);
+}
+
+// Decode RTCM messages built with known field values
+void checkRtcmDecoders()
+{
+    char check[16];
+    const SEMP_RTCM_MSM_CELL *cell;
+    const SEMP_RTCM_1005 *expected;
+    int index;
+    size_t length;
+    SEMP_PARSE_STATE *parse;
+    const SEMP_RTCM_MSM_SATELLITE *satellite;
+    const SEMP_RTCM_1005 *station;
+
+    // The payload starts with the 12-bit message number 1005 (0x3ed) and
+    // the 12-bit station ID 2003 (0x7d3)
+    length = 0;
+    for (index = 0; index < rtcmStationCount; index++)
+        length += buildRtcm1005Message(&corpus[length], &rtcmStations[index]);
+    length += buildRtcmMsmMessage(&corpus[length]);
+    length += buildRtcm1033Message(&corpus[length]);
+    checkAnswer("RTCM 1005", "payload byte 0", corpus[3], 0x3e);
+    checkAnswer("RTCM 1005", "payload byte 1", corpus[4], 0xd7);
+    checkAnswer("RTCM 1005", "payload byte 2", corpus[5], 0xd3);
+
+    // Decode the messages in the eomCallback routine
+    parse = beginCheckParser(&regressionTests[1], decodeRtcmMessage);
+    sempParseBuffer(parse, corpus, length);
+    sempStopParser(&parse);
+    checkAnswer("RTCM", "messages", capturedCount, rtcmStationCount + 2);
+    for (index = 0; index < (int)SEMP_MIN(capturedCount, CAPTURE_MESSAGES); index++)
+        checkAnswer("RTCM", "message decoded", captured[index].id, true);
+
+    // Verify the antenna reference points
+    for (index = 0; index < rtcmStationCount; index++)
+    {
+        expected = &rtcmStations[index];
+        station = &decodedStations[expected->messageNumber - 1005];
+        sprintf(check, "RTCM %d", expected->messageNumber);
+        checkAnswer(check, "message number", station->messageNumber, expected->messageNumber);
+        checkAnswer(check, "station ID", station->stationId, expected->stationId);
+        checkAnswer(check, "ITRF year", station->itrfYear, expected->itrfYear);
+        checkAnswer(check, "GPS", station->gps, expected->gps);
+        checkAnswer(check, "GLONASS", station->glonass, expected->glonass);
+        checkAnswer(check, "Galileo", station->galileo, expected->galileo);
+        checkAnswer(check, "reference station", station->referenceStation, expected->referenceStation);
+        checkAnswer(check, "single oscillator", station->singleOscillator, expected->singleOscillator);
+        checkAnswer(check, "quarter cycle", station->quarterCycle, expected->quarterCycle);
+        checkAnswer(check, "ECEF X", station->ecefX, expected->ecefX);
+        checkAnswer(check, "ECEF Y", station->ecefY, expected->ecefY);
+        checkAnswer(check, "ECEF Z", station->ecefZ, expected->ecefZ);
+        checkAnswer(check, "antenna height", station->antennaHeight, expected->antennaHeight);
+    }
+
+    // Verify the MSM header, satellites and cells
+    checkAnswer("RTCM MSM4", "message number", decodedMsm.messageNumber, rtcmMsmHeader.messageNumber);
+    checkAnswer("RTCM MSM4", "station ID", decodedMsm.stationId, rtcmMsmHeader.stationId);
+    checkAnswer("RTCM MSM4", "epoch time", decodedMsm.epochTime, rtcmMsmHeader.epochTime);
+    checkAnswer("RTCM MSM4", "MSM type", decodedMsm.msmType, rtcmMsmHeader.msmType);
+    checkAnswer("RTCM MSM4", "GNSS", decodedMsm.gnss, rtcmMsmHeader.gnss);
+    checkAnswer("RTCM MSM4", "multiple message", decodedMsm.multipleMessage, rtcmMsmHeader.multipleMessage);
+    checkAnswer("RTCM MSM4", "IODS", decodedMsm.iods, rtcmMsmHeader.iods);
+    checkAnswer("RTCM MSM4", "clock steering", decodedMsm.clockSteering, rtcmMsmHeader.clockSteering);
+    checkAnswer("RTCM MSM4", "external clock", decodedMsm.externalClock, rtcmMsmHeader.externalClock);
+    checkAnswer("RTCM MSM4", "smoothing", decodedMsm.smoothing, rtcmMsmHeader.smoothing);
+    checkAnswer("RTCM MSM4", "smoothing interval", decodedMsm.smoothingInterval, rtcmMsmHeader.smoothingInterval);
+    checkAnswer("RTCM MSM4", "satellites", decodedMsm.satelliteCount, rtcmMsmSatelliteCount);
+    checkAnswer("RTCM MSM4", "signals", decodedMsm.signalCount, rtcmMsmSignalCount);
+    checkAnswer("RTCM MSM4", "cells", decodedMsm.cellCount, rtcmMsmCellCount);
+    for (index = 0; index < rtcmMsmSignalCount; index++)
+        checkAnswer("RTCM MSM4", "signal ID", decodedMsm.signalIds[index], rtcmMsmSignalIds[index]);
+    for (index = 0; index < rtcmMsmSatelliteCount; index++)
+    {
+        satellite = &rtcmMsmSatellites[index];
+        checkAnswer("RTCM MSM4", "satellite ID", decodedMsm.satellites[index].id, satellite->id);
+        checkAnswer("RTCM MSM4", "rough range", decodedMsm.satellites[index].roughRangeMs, satellite->roughRangeMs);
+        checkAnswer("RTCM MSM4", "rough range modulo",
+                    decodedMsm.satellites[index].roughRangeModMs, satellite->roughRangeModMs);
+    }
+    for (index = 0; index < rtcmMsmCellCount; index++)
+    {
+        cell = &rtcmMsmCells[index];
+        checkAnswer("RTCM MSM4", "cell satellite", decodedMsm.cells[index].satellite, cell->satellite);
+        checkAnswer("RTCM MSM4", "cell signal ID", decodedMsm.cells[index].signalId, cell->signalId);
+        checkAnswer("RTCM MSM4", "fine pseudorange", decodedMsm.cells[index].finePseudorange, cell->finePseudorange);
+        checkAnswer("RTCM MSM4", "fine phase range", decodedMsm.cells[index].finePhaseRange, cell->finePhaseRange);
+        checkAnswer("RTCM MSM4", "lock time", decodedMsm.cells[index].lockTime, cell->lockTime);
+        checkAnswer("RTCM MSM4", "half-cycle", decodedMsm.cells[index].halfCycle, cell->halfCycle);
+        checkAnswer("RTCM MSM4", "CNR", decodedMsm.cells[index].cnr, cell->cnr);
+    }
+
+    // Verify the descriptor strings
+    checkAnswer("RTCM 1033", "station ID", decodedDescriptors.stationId, rtcmDescriptors.stationId);
+    checkAnswer("RTCM 1033", "antenna setup ID", decodedDescriptors.antennaSetupId, rtcmDescriptors.antennaSetupId);
+    checkAnswer("RTCM 1033", "antenna descriptor",
+                strcmp(decodedDescriptors.antennaDescriptor, rtcmDescriptors.antennaDescriptor), 0);
+    checkAnswer("RTCM 1033", "antenna serial number",
+                strcmp(decodedDescriptors.antennaSerialNumber, rtcmDescriptors.antennaSerialNumber), 0);
+    checkAnswer("RTCM 1033", "receiver type",
+                strcmp(decodedDescriptors.receiverType, rtcmDescriptors.receiverType), 0);
+    checkAnswer("RTCM 1033", "receiver firmware",
+                strcmp(decodedDescriptors.receiverFirmware, rtcmDescriptors.receiverFirmware), 0);
+    checkAnswer("RTCM 1033", "receiver serial number",
+                strcmp(decodedDescriptors.receiverSerialNumber, rtcmDescriptors.receiverSerialNumber), 0);
+
+    // Fail the messages shorter than their fields or of another type
+    checkAnswer("RTCM 1005", "truncated message decoded",
+                sempRtcmDecode1005(corpus, 3 + 10, &decodedStations[0]), false);
+    checkAnswer("RTCM 1005", "MSM message decoded",
+                sempRtcmDecode1005(&captured[rtcmStationCount].data[0], captured[rtcmStationCount].length,
+                                   &decodedStations[0]), false);
+}
+
+// Call back from within parser, compare the fields of the sentence
+void checkSentenceFieldsCallback(SEMP_PARSE_STATE *parse, uint16_t type)
+{
+    capturedCount += 1;
+    if (type == 0)
+    {
+        checkAnswer("NMEA", "sentence ID", sempNmeaGetSentenceId(parse), SEMP_NMEA_ID_GGA);
+        checkAnswer("NMEA", "field count", sempNmeaGetFieldCount(parse), 15);
+        checkFields("NMEA", parse, sempNmeaGetField, nmeaFieldAnswers, nmeaFieldAnswerCount);
+    }
+    else
+    {
+        checkAnswer("Unicore hash", "sentence ID", sempUnicoreHashGetSentenceId(parse), SEMP_UNICORE_HASH_ID_BESTNAVA);
+        checkAnswer("Unicore hash", "field count", sempUnicoreHashGetFieldCount(parse), 31);
+        checkFields("Unicore hash", parse, sempUnicoreHashGetField,
+                    unicoreHashFieldAnswers, unicoreHashFieldAnswerCount);
+    }
+}
+
+// Get the fields of sentences copied into the parse buffer and parsed in
+// place
+void checkSentenceFields()
+{
+    size_t length;
+    int mode;
+    size_t offset;
+    SEMP_PARSE_STATE *parse;
+
+    // Build the GGA and BESTNAVA sentences
+    length = formatSentence(corpus, SEMP_NMEA_PREAMBLE, nmeaSentences[0], "\r\n");
+    length += formatSentence(&corpus[length], SEMP_UNICORE_HASH_PREAMBLE, unicoreHashSentences[1], "\r\n");
+
+    // Parse the sentences using the UM980 parsers
+    for (mode = MODE_NEXT_BYTE; mode <= MODE_ZERO_COPY; mode++)
+    {
+        parse = beginCheckParser(&regressionTests[7], checkSentenceFieldsCallback);
+        if (mode == MODE_ZERO_COPY)
+            sempEnableZeroCopy(parse);
+        if (mode == MODE_NEXT_BYTE)
+            for (offset = 0; offset < length; offset++)
+                sempParseNextByte(parse, corpus[offset]);
+        else
+            sempParseBuffer(parse, corpus, length);
+        sempStopParser(&parse);
+        checkAnswer("Sentence fields", "sentences", capturedCount, 2);
+    }
+}
+
+// Pass messages through the byte ring and message ring, wrapping around
+// the end of the storage
+void checkRings()
+{
+    size_t first;
+    size_t idle;
+    size_t length;
+    SEMP_MESSAGE_RING messageRing;
+    SEMP_PARSE_STATE *parse;
+    const SEMP_MESSAGE_RECORD *record;
+    SEMP_BYTE_RING ring;
+    const uint8_t *storage;
+
+    // Build two sentences, the first one wraps around the end of the ring
+    storage = (const uint8_t *)ringStorage;
+    first = formatSentence(corpus, SEMP_NMEA_PREAMBLE, nmeaSentences[0], "\r\n");
+    length = first + formatSentence(&corpus[first], SEMP_NMEA_PREAMBLE, nmeaSentences[3], "\r\n");
+    idle = RING_BYTES - (first / 2);
+
+    // Parse the ring with zero-copy enabled
+    sempByteRingInit(&ring, (uint8_t *)ringStorage, RING_BYTES);
+    parse = beginCheckParser(&regressionTests[0], captureParsedMessage);
+    sempEnableZeroCopy(parse);
+    checkAnswer("Byte ring", "idle bytes written", sempByteRingWrite(&ring, idleBytes, idle), idle);
+    checkAnswer("Byte ring", "idle bytes parsed", sempParseByteRing(parse, &ring), idle);
+    checkAnswer("Byte ring", "bytes written", sempByteRingWrite(&ring, corpus, length), length);
+    checkAnswer("Byte ring", "bytes available", sempByteRingAvailable(&ring), length);
+    checkAnswer("Byte ring", "bytes parsed", sempParseByteRing(parse, &ring), length);
+    checkAnswer("Byte ring", "bytes available after parsing", sempByteRingAvailable(&ring), 0);
+    sempStopParser(&parse);
+
+    // The sentence wrapping around the end of the ring is delivered from
+    // the parse buffer and the next sentence in place from the ring
+    checkAnswer("Byte ring", "messages", capturedCount, 2);
+    checkCapturedMessage("Byte ring", 0, 0, corpus, first);
+    checkCapturedMessage("Byte ring", 1, 0, &corpus[first], length - first);
+    checkAnswer("Byte ring", "wrapped message in the ring",
+                (captured[0].buffer >= storage) && (captured[0].buffer < &storage[RING_BYTES]), false);
+    checkAnswer("Byte ring", "message 1 ring offset", captured[1].buffer - storage, first - (first / 2));
+
+    // Leave 16 bytes at the end of the message ring while the first
+    // and second records are in the ring, too few for the record of a 16
+    // byte message which is placed at the start instead
+    sempMessageRingInit(&messageRing, (uint8_t *)ringStorage, SEMP_RING_MINIMUM_SIZE);
+    checkAnswer("Message ring", "write 24 bytes", sempMessageRingWrite(&messageRing, 1, 2, corpus, 24), true);
+    checkAnswer("Message ring", "write 8 bytes", sempMessageRingWrite(&messageRing, 3, 4, &corpus[24], 8), true);
+    record = sempMessageRingRead(&messageRing);
+    checkAnswer("Message ring", "read 24 bytes", record ? record->length : 0, 24);
+    if (record)
+        sempMessageRingRelease(&messageRing, record);
+    checkAnswer("Message ring", "write 16 bytes", sempMessageRingWrite(&messageRing, 5, 6, &corpus[32], 16), true);
+    checkAnswer("Message ring", "write to full ring", sempMessageRingWrite(&messageRing, 7, 8, corpus, 8), false);
+    record = sempMessageRingRead(&messageRing);
+    checkAnswer("Message ring", "read 8 bytes", record ? record->length : 0, 8);
+    if (record)
+        sempMessageRingRelease(&messageRing, record);
+    record = sempMessageRingRead(&messageRing);
+    checkAnswer("Message ring", "read wrapped record", record != nullptr, true);
+    if (record)
+    {
+        checkAnswer("Message ring", "wrapped record offset", (const uint8_t *)record - storage, 0);
+        checkAnswer("Message ring", "wrapped record stream", record->stream, 5);
+        checkAnswer("Message ring", "wrapped record type", record->type, 6);
+        checkAnswer("Message ring", "wrapped record length", record->length, 16);
+        checkAnswer("Message ring", "wrapped record matches", memcmp(&record[1], &corpus[32], 16) == 0, true);
+        sempMessageRingRelease(&messageRing, record);
+    }
+
+    // The empty ring ends 24 bytes into the storage, the 48 byte record
+    // of a 40 byte message only fits after restarting the ring
+    checkAnswer("Message ring", "write 40 bytes", sempMessageRingWrite(&messageRing, 9, 10, corpus, 40), true);
+    record = sempMessageRingRead(&messageRing);
+    checkAnswer("Message ring", "read restarted record", record != nullptr, true);
+    if (record)
+    {
+        checkAnswer("Message ring", "restarted record offset", (const uint8_t *)record - storage, 0);
+        checkAnswer("Message ring", "restarted record length", record->length, 40);
+        checkAnswer("Message ring", "restarted record matches", memcmp(&record[1], corpus, 40) == 0, true);
+        sempMessageRingRelease(&messageRing, record);
+    }
+    checkAnswer("Message ring", "read empty ring", sempMessageRingRead(&messageRing) != nullptr, false);
+}
+
+// Call back from within the splitter, for each message
+void splitMessage(const uint8_t *message, size_t offset, size_t length, uint16_t type)
+{
+    captureMessage(message, offset, length, 0, type);
+}
+
+// Split sentences ending with only a line feed into two chunks, the
+// second chunk starts in the middle of the second sentence
+void checkSplitter()
+{
+    char name[32];
+    int index;
+    size_t offsets[4];
+    SEMP_SPLITTER *splitter;
+
+    // Build the sentences
+    offsets[0] = 0;
+    for (index = 0; index < 3; index++)
+        offsets[index + 1] = offsets[index] + formatSentence(&corpus[offsets[index]], SEMP_NMEA_PREAMBLE,
+                                                             nmeaSentences[index], "\n");
+
+    // The byte following the line feed completes the last sentence
+    corpus[offsets[3]] = ' ';
+
+    // Parse both chunks, then deliver the messages
+    splitter = sempBeginSplitter(nmeaParserTable, 1, nmeaParserNames, 1,
+                                 0, BUFFER_LENGTH, corpus, offsets[3] + 1, 2,
+                                 splitMessage, "Splitter", &Serial, nmeaPreambleTable);
+    if (!splitter)
+        reportFatalError("Failed to initialize the splitter");
+    capturedCount = 0;
+    checkAnswer("Splitter", "first chunk", sempSplitterParseNextChunk(splitter), 0);
+    checkAnswer("Splitter", "second chunk", sempSplitterParseNextChunk(splitter), 1);
+    checkAnswer("Splitter", "chunks remaining", sempSplitterParseNextChunk(splitter), -1);
+    checkAnswer("Splitter", "messages delivered", sempSplitterDeliverMessages(splitter), 3);
+    checkAnswer("Splitter", "complete", sempSplitterComplete(splitter), true);
+    sempStopSplitter(&splitter);
+
+    // The sentences are passed from the data without the line feed
+    for (index = 0; index < 3; index++)
+    {
+        if (!checkCapturedMessage("Splitter", index, 0, &corpus[offsets[index]],
+                                  offsets[index + 1] - offsets[index] - 1))
+            continue;
+        sprintf(name, "message %d offset", index);
+        checkAnswer("Splitter", name, captured[index].offset, offsets[index]);
+        sprintf(name, "message %d in place", index);
+        checkAnswer("Splitter", name, captured[index].buffer == &corpus[offsets[index]], true);
+    }
+}
+
+// Call back from within parser, add the message to its epoch
+void addEpochMessage(SEMP_PARSE_STATE *parse, uint16_t type)
+{
+    sempEpochAddMessage(&epochState, parse, type, parse->buffer, parse->length);
+}
+
+// Call back from within the epoch routines, for each epoch
+void recordEpoch(SEMP_EPOCH *epoch,
+                 const SEMP_BATCH_ENTRY *entries,
+                 uint16_t count,
+                 const uint8_t *arena,
+                 uint8_t status)
+{
+    int index;
+    CAPTURED_MESSAGE *message;
+
+    for (index = 0; index < count; index++)
+    {
+        message = captureMessage(&arena[entries[index].offset], entries[index].offset,
+                                 entries[index].length, entries[index].id, entries[index].type);
+        if (message)
+        {
+            message->time = epoch->time;
+            message->status = status;
+        }
+    }
+}
+
+// Group u-blox NAV messages by iTOW, passing the other messages by
+// themselves
+void checkEpochs()
+{
+    uint8_t arena[512];
+    const EPOCH_ANSWER *answer;
+    SEMP_BATCH_ENTRY entries[4];
+    int index;
+    char name[32];
+    size_t offsets[6];
+    SEMP_PARSE_STATE *parse;
+
+    // NAV-PVT, NAV-ODO and NAV-EOE complete the first epoch, the GGA
+    // sentence is not part of the epoch and the second NAV-PVT starts the
+    // next epoch.  The iTOW of NAV-ODO follows the version field.
+    offsets[0] = 0;
+    offsets[1] = offsets[0] + buildUbloxNavMessage(&corpus[offsets[0]], 0x07, 1000, 0, 92);
+    offsets[2] = offsets[1] + formatSentence(&corpus[offsets[1]], SEMP_NMEA_PREAMBLE, nmeaSentences[0], "\r\n");
+    offsets[3] = offsets[2] + buildUbloxNavMessage(&corpus[offsets[2]], 0x09, 1000, 4, 20);
+    offsets[4] = offsets[3] + buildUbloxNavMessage(&corpus[offsets[3]], 0x61, 1000, 0, 4);
+    offsets[5] = offsets[4] + buildUbloxNavMessage(&corpus[offsets[4]], 0x07, 2000, 0, 92);
+
+    // Parse the messages using the ZED-F9P parsers
+    if (!sempEpochInit(&epochState, entries, 4, arena, sizeof(arena), recordEpoch))
+        reportFatalError("Failed to initialize the epoch");
+    parse = beginCheckParser(&regressionTests[8], addEpochMessage);
+    sempParseBuffer(parse, corpus, offsets[5]);
+    sempEpochFlush(&epochState);
+    sempStopParser(&parse);
+
+    // Verify the delivery order and the epoch of each message
+    checkAnswer("Epoch", "messages", capturedCount, epochAnswerCount);
+    for (index = 0; index < epochAnswerCount; index++)
+    {
+        answer = &epochAnswers[index];
+        if (!checkCapturedMessage("Epoch", index, answer->type, &corpus[offsets[answer->message]],
+                                  offsets[answer->message + 1] - offsets[answer->message]))
+            continue;
+        sprintf(name, "message %d ID", index);
+        checkAnswer("Epoch", name, captured[index].id, answer->id);
+        sprintf(name, "message %d status", index);
+        checkAnswer("Epoch", name, captured[index].status, answer->status);
+        if (answer->status != SEMP_EPOCH_SINGLE)
+        {
+            sprintf(name, "message %d time", index);
+            checkAnswer("Epoch", name, captured[index].time, answer->time);
+        }
+    }
+}
+
+#if SEMP_STATS
+// Count the valid, failed and discarded bytes of the NMEA sentences
+void checkStatistics()
+{
+    size_t offsets[4];
+    SEMP_PARSE_STATE *parse;
+    const SEMP_PARSER_STATS *stats;
+
+    // Five bytes of noise, a valid GGA sentence, a GSV sentence with a
+    // changed character and a valid RMC sentence
+    memcpy(corpus, "12345", 5);
+    offsets[0] = 5;
+    offsets[1] = offsets[0] + formatSentence(&corpus[offsets[0]], SEMP_NMEA_PREAMBLE, nmeaSentences[0], "\r\n");
+    offsets[2] = offsets[1] + formatSentence(&corpus[offsets[1]], SEMP_NMEA_PREAMBLE, nmeaSentences[1], "\r\n");
+    corpus[offsets[2] - 8] ^= 1;
+    offsets[3] = offsets[2] + formatSentence(&corpus[offsets[2]], SEMP_NMEA_PREAMBLE, nmeaSentences[3], "\r\n");
+
+    // Parse the data and verify the counters
+    parse = beginCheckParser(&regressionTests[0], captureParsedMessage);
+    sempParseBuffer(parse, corpus, offsets[3]);
+    stats = sempGetStats(parse, 0);
+    checkAnswer("Statistics", "available", stats != nullptr, true);
+    if (stats)
+    {
+        checkAnswer("Statistics", "messages", stats->messages, 2);
+        checkAnswer("Statistics", "bytes", stats->bytes, offsets[1] - offsets[0] + offsets[3] - offsets[2]);
+        checkAnswer("Statistics", "bad CRC", stats->badCrc, 1);
+        checkAnswer("Statistics", "bad header", stats->badHeader, 0);
+        checkAnswer("Statistics", "too long", stats->tooLong, 0);
+    }
+    checkAnswer("Statistics", "discarded bytes", sempGetDiscardedBytes(parse), 5);
+    checkAnswer("Statistics", "invalid type", sempGetStats(parse, 1) != nullptr, false);
+    sempResetStats(parse);
+    checkAnswer("Statistics", "messages after reset", stats ? stats->messages : 0, 0);
+    sempStopParser(&parse);
+}
+#endif  // SEMP_STATS
+
+#if SEMP_FEATURES
+// Drop the GSV sentences using the sentence names
+void checkMessageFilter()
+{
+    const char * const names[] = {"GPGSV"};
+    SEMP_MESSAGE_FILTER filter;
+    int index;
+    size_t offsets[5];
+    SEMP_PARSE_STATE *parse;
+
+    // Build the GGA, GSV and RMC sentences
+    offsets[0] = 0;
+    for (index = 0; index < nmeaSentenceCount; index++)
+        offsets[index + 1] = offsets[index] + formatSentence(&corpus[offsets[index]], SEMP_NMEA_PREAMBLE,
+                                                             nmeaSentences[index], "\r\n");
+
+    // Reject the listed sentence names
+    memset(&filter, 0, sizeof(filter));
+    filter.names = names;
+    filter.nameCount = 1;
+    filter.accept = false;
+    parse = beginCheckParser(&regressionTests[0], captureParsedMessage);
+    sempEnableMessageFilter(parse, &filter);
+    sempParseBuffer(parse, corpus, offsets[nmeaSentenceCount]);
+#if SEMP_STATS
+    checkAnswer("Message filter", "filtered", sempGetStats(parse, 0)->filtered, 2);
+#endif  // SEMP_STATS
+    sempStopParser(&parse);
+    checkAnswer("Message filter", "messages", capturedCount, 2);
+    checkCapturedMessage("Message filter", 0, 0, &corpus[offsets[0]], offsets[1] - offsets[0]);
+    checkCapturedMessage("Message filter", 1, 0, &corpus[offsets[3]], offsets[4] - offsets[3]);
+}
+
+// Call back from within parser, save the forwarded bytes
+void forwardWrite(SEMP_PARSE_STATE *parse, void *context, const uint8_t *data, size_t length)
+{
+    length = SEMP_MIN(length, sizeof(forwardData) - forwardLength);
+    memcpy(&forwardData[forwardLength], data, length);
+    forwardLength += length;
+}
+
+// Call back from within parser, commit or roll back the forwarded message
+void forwardEnd(SEMP_PARSE_STATE *parse, void *context, bool valid)
+{
+    if (valid)
+        forwardCommitted = forwardLength;
+    else
+    {
+        forwardLength = forwardCommitted;
+        forwardAborts += 1;
+    }
+}
+
+// Forward the valid sentences, rolling back a sentence with a bad checksum
+void checkForwarding()
+{
+    size_t bytes;
+    size_t length;
+    size_t offset;
+    size_t offsets[4];
+    SEMP_PARSE_STATE *parse;
+    const SEMP_FORWARD_SINK sink = {forwardWrite, forwardEnd, nullptr};
+
+    // Build a GGA sentence, a GSV sentence with a changed character and a
+    // RMC sentence
+    offsets[0] = 0;
+    offsets[1] = formatSentence(corpus, SEMP_NMEA_PREAMBLE, nmeaSentences[0], "\r\n");
+    offsets[2] = offsets[1] + formatSentence(&corpus[offsets[1]], SEMP_NMEA_PREAMBLE, nmeaSentences[1], "\r\n");
+    corpus[offsets[2] - 8] ^= 1;
+    offsets[3] = offsets[2] + formatSentence(&corpus[offsets[2]], SEMP_NMEA_PREAMBLE, nmeaSentences[3], "\r\n");
+
+    // Forward the sentences while they are parsed in small pieces
+    forwardAborts = 0;
+    forwardCommitted = 0;
+    forwardLength = 0;
+    parse = beginCheckParser(&regressionTests[0], captureParsedMessage);
+    sempEnableForwarding(parse, &sink);
+    for (offset = 0; offset < offsets[3]; offset += bytes)
+    {
+        bytes = SEMP_MIN(16, offsets[3] - offset);
+        sempParseBuffer(parse, &corpus[offset], bytes);
+    }
+    sempStopParser(&parse);
+
+    // The sink keeps the valid sentences
+    checkAnswer("Forwarding", "messages", capturedCount, 2);
+    checkAnswer("Forwarding", "aborts", forwardAborts, 1);
+    checkAnswer("Forwarding", "bytes", forwardCommitted, offsets[1] + offsets[3] - offsets[2]);
+    checkAnswer("Forwarding", "first sentence", memcmp(forwardData, corpus, offsets[1]) == 0, true);
+    checkAnswer("Forwarding", "second sentence",
+                memcmp(&forwardData[offsets[1]], &corpus[offsets[2]], offsets[3] - offsets[2]) == 0, true);
+}
+
+// Call back from within parser, for each batch
+void recordBatch(SEMP_PARSE_STATE *parse,
+                 const SEMP_BATCH_ENTRY *entries,
+                 uint16_t count,
+                 const uint8_t *arena)
+{
+    int index;
+
+    batchCount += 1;
+    for (index = 0; index < count; index++)
+        captureMessage(&arena[entries[index].offset], entries[index].offset,
+                       entries[index].length, entries[index].id, entries[index].type);
+}
+
+// Batch the sentences passed in a single sempParseBuffer call
+void checkBatchDelivery()
+{
+    uint8_t arena[512];
+    SEMP_BATCH_ENTRY entries[8];
+    const uint8_t ids[] = {SEMP_NMEA_ID_GGA, SEMP_NMEA_ID_GSV, SEMP_NMEA_ID_GSV, SEMP_NMEA_ID_RMC};
+    int index;
+    char name[32];
+    size_t offsets[5];
+    SEMP_PARSE_STATE *parse;
+
+    // Build the GGA, GSV and RMC sentences
+    offsets[0] = 0;
+    for (index = 0; index < nmeaSentenceCount; index++)
+        offsets[index + 1] = offsets[index] + formatSentence(&corpus[offsets[index]], SEMP_NMEA_PREAMBLE,
+                                                             nmeaSentences[index], "\r\n");
+
+    // The batch is delivered at the end of the sempParseBuffer call
+    batchCount = 0;
+    parse = beginCheckParser(&regressionTests[0], captureParsedMessage);
+    sempEnableBatchDelivery(parse, entries, 8, arena, sizeof(arena), recordBatch);
+    sempParseBuffer(parse, corpus, offsets[nmeaSentenceCount]);
+    checkAnswer("Batch", "batches", batchCount, 1);
+    sempStopParser(&parse);
+
+    // The sentences are packed into the arena in the order received
+    checkAnswer("Batch", "messages", capturedCount, nmeaSentenceCount);
+    for (index = 0; index < nmeaSentenceCount; index++)
+    {
+        if (!checkCapturedMessage("Batch", index, 0, &corpus[offsets[index]], offsets[index + 1] - offsets[index]))
+            continue;
+        sprintf(name, "message %d offset", index);
+        checkAnswer("Batch", name, captured[index].offset, offsets[index]);
+        sprintf(name, "message %d ID", index);
+        checkAnswer("Batch", name, captured[index].id, ids[index]);
+    }
+}
+
+// Record a bad checksum in the binary log
+void checkBinaryLog()
+{
+    uint8_t checksum;
+    SEMP_LOG_ENTRY entries[4];
+    SEMP_LOG_ENTRY entry;
+    size_t length;
+    SEMP_PARSE_STATE *parse;
+
+    // Build a GGA sentence with the wrong checksum
+    checksum = 0;
+    for (const char *data = nmeaSentences[0]; *data; data++)
+        checksum ^= *data;
+    length = sprintf((char *)corpus, "$%s*%02X\r\n", nmeaSentences[0], checksum ^ 0x5a);
+
+    // Parse the sentence and read the log entry
+    parse = beginCheckParser(&regressionTests[0], captureParsedMessage);
+    sempEnableBinaryLog(parse, entries, 4);
+    sempParseBuffer(parse, corpus, length);
+    checkAnswer("Binary log", "messages", capturedCount, 0);
+    checkAnswer("Binary log", "entry read", sempReadBinaryLog(parse, &entry), true);
+    checkAnswer("Binary log", "event", entry.event, SEMP_EVENT_BAD_CRC);
+    checkAnswer("Binary log", "type", entry.type, 0);
+    checkAnswer("Binary log", "received", entry.received, checksum ^ 0x5a);
+    checkAnswer("Binary log", "computed", entry.computed, checksum);
+    checkAnswer("Binary log", "length", entry.length, length - 2);
+    checkAnswer("Binary log", "second entry read", sempReadBinaryLog(parse, &entry), false);
+    sempStopParser(&parse);
+}
+
+// Call back from within the pool, for each message
+void recordPoolMessage(uint16_t stream, uint16_t type, const uint8_t *message, size_t length)
+{
+    captureMessage(message, 0, length, stream, type);
+}
+
+// Parse two streams with a single pool worker
+void checkPool()
+{
+    size_t first;
+    size_t length;
+    SEMP_POOL *pool;
+
+    // A GGA sentence for stream 0 and a NAV-PVT message for stream 1
+    first = formatSentence(corpus, SEMP_NMEA_PREAMBLE, nmeaSentences[0], "\r\n");
+    length = first + buildUbloxNavMessage(&corpus[first], 0x07, 1000, 0, 92);
+
+    // Queue the data, then parse it and deliver the messages
+    pool = sempBeginPool(allParserTable, 6, allParserNames, 6, 0, BUFFER_LENGTH,
+                         2, 1, 1024, recordPoolMessage, "Pool", &Serial, allPreambleTable);
+    if (!pool)
+        reportFatalError("Failed to initialize the pool");
+    capturedCount = 0;
+    checkAnswer("Pool", "stream 1 worker", sempPoolGetWorker(pool, 1), 0);
+    checkAnswer("Pool", "stream 0 queued", sempPoolParse(pool, 0, corpus, first), true);
+    checkAnswer("Pool", "stream 1 queued", sempPoolParse(pool, 1, &corpus[first], length - first), true);
+    checkAnswer("Pool", "worker ran", sempPoolRunWorker(pool, 0), true);
+    checkAnswer("Pool", "messages delivered", sempPoolDeliverMessages(pool, 0), 2);
+    sempStopPool(&pool);
+
+    // Verify the stream and parser of each message
+    if (checkCapturedMessage("Pool", 0, 0, corpus, first))
+        checkAnswer("Pool", "message 0 stream", captured[0].id, 0);
+    if (checkCapturedMessage("Pool", 1, 1, &corpus[first], length - first))
+        checkAnswer("Pool", "message 1 stream", captured[1].id, 1);
+}
+#endif  // SEMP_FEATURES
+
+#if SEMP_STREAM_FD
+// Read a sentence from a pipe
+void checkStream()
+{
+    int fds[2];
+    size_t length;
+    SEMP_PARSE_STATE *parse;
+    const SEMP_MESSAGE_RECORD *record;
+    SEMP_STREAM stream;
+    uint8_t *storage;
+
+    // Write a GGA sentence into a non-blocking pipe
+    if (pipe(fds))
+        reportFatalError("Failed to create the pipe");
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    length = formatSentence(corpus, SEMP_NMEA_PREAMBLE, nmeaSentences[0], "\r\n");
+    checkAnswer("Stream", "bytes written", write(fds[1], corpus, length), length);
+
+    // Read and parse the sentence
+    storage = (uint8_t *)ringStorage;
+    parse = beginCheckParser(&regressionTests[0], captureParsedMessage);
+    checkAnswer("Stream", "initialized",
+                sempStreamInit(&stream, parse, fds[0], 7, storage, RING_BYTES, &storage[RING_BYTES], RING_BYTES),
+                true);
+    checkAnswer("Stream", "bytes read", sempStreamRead(&stream), length);
+    record = sempStreamNextMessage(&stream);
+    checkAnswer("Stream", "message available", record != nullptr, true);
+    if (record)
+    {
+        checkAnswer("Stream", "message stream", record->stream, 7);
+        checkAnswer("Stream", "message type", record->type, 0);
+        checkAnswer("Stream", "message length", record->length, length);
+        checkAnswer("Stream", "message matches", memcmp(&record[1], corpus, length) == 0, true);
+        sempStreamRelease(&stream, record);
+    }
+    checkAnswer("Stream", "second message available", sempStreamNextMessage(&stream) != nullptr, false);
+
+    // No data is available until the end of the file
+    checkAnswer("Stream", "read without data", sempStreamRead(&stream), -1);
+    checkAnswer("Stream", "errno without data", errno, EAGAIN);
+    close(fds[1]);
+    checkAnswer("Stream", "read at end of file", sempStreamRead(&stream), 0);
+    close(fds[0]);
+    sempStopParser(&parse);
+}
+#endif  // SEMP_STREAM_FD
+
+// Damage the data stream, returns the new data stream length
+size_t damageCorpus(const REGRESSION_TEST *test, size_t corpusBytes, int damage)
+{
+    size_t bytes;
+    size_t destination;
+    uint16_t index;
+    size_t offset;
+
+    switch (damage)
+    {
+    case DAMAGE_BIT_FLIPS:
+        // Flip a bit in about one of every 500 bytes
+        for (offset = nextRandom() % 500; offset < corpusBytes;
+             offset += 1 + nextRandom() % 1000)
+            corpus[offset] ^= 1 << (nextRandom() & 7);
+        break;
+
+    case DAMAGE_INSERT:
+        // Insert runs of random bytes
+        for (index = 0; index < 8; index++)
+        {
+            bytes = 1 + nextRandom() % (INSERT_BYTES / 8);
+            offset = nextRandom() % corpusBytes;
+            memmove(&corpus[offset + bytes], &corpus[offset], corpusBytes - offset);
+            fillPayload(&corpus[offset], bytes);
+            corpusBytes += bytes;
+        }
+        break;
+
+    case DAMAGE_DELETE:
+        // Remove runs of bytes, truncating the messages
+        for (index = 0; index < 8; index++)
+        {
+            offset = nextRandom() % corpusBytes;
+            bytes = 1 + nextRandom() % 64;
+            bytes = SEMP_MIN(bytes, corpusBytes - offset);
+            memmove(&corpus[offset], &corpus[offset + bytes], corpusBytes - offset - bytes);
+            corpusBytes -= bytes;
+        }
+        break;
+
+    case DAMAGE_COPY:
+        // Copy pieces of the data stream over other pieces, splicing
+        // the start of one message onto the end of another
+        for (index = 0; index < 8; index++)
+        {
+            offset = nextRandom() % corpusBytes;
+            destination = nextRandom() % corpusBytes;
+            bytes = 1 + nextRandom() % 256;
+            bytes = SEMP_MIN(bytes, corpusBytes - SEMP_MAX(offset, destination));
+            memmove(&corpus[destination], &corpus[offset], bytes);
+        }
+        break;
+
+    case DAMAGE_OVERWRITE:
+        // Overwrite runs of bytes with random data
+        for (index = 0; index < 8; index++)
+        {
+            offset = nextRandom() % corpusBytes;
+            bytes = 1 + nextRandom() % 256;
+            bytes = SEMP_MIN(bytes, corpusBytes - offset);
+            fillPayload(&corpus[offset], bytes);
+        }
+        break;
+
+    case DAMAGE_HEADER:
+        // Change a byte in the header following some of the preambles,
+        // such as the message length, ID or other header fields
+        for (offset = 0; (offset + 8) < corpusBytes; offset++)
+            for (index = 0; index < test->parserCount; index++)
+                if ((corpus[offset] == test->preambleTable[index]) && ((nextRandom() & 3) == 0))
+                {
+                    corpus[offset + 1 + nextRandom() % 7] = nextRandom();
+                    break;
+                }
+        break;
+    }
+    return corpusBytes;
+}
+
+// Build a data stream containing the specified message types, placing
+// up to noiseBytes random bytes in front of each message
+size_t buildCorpus(uint32_t messageTypes, size_t noiseBytes)
+{
+    size_t bytes;
+    size_t length;
+    uint32_t messageType;
+    size_t offset;
+    size_t previous;
+
+    corpusMessages = 0;
+    length = 0;
+    previous = 0;
+    randomValue = 1;
+    messageType = 1;
+    while ((length + noiseBytes + MAXIMUM_MESSAGE_BYTES) <= CORPUS_BYTES)
+    {
+        // Add the noise to the data stream.  Copy the header of the
+        // previous message into some of the noise, corrupting some of
+        // the copies, creating false preambles followed by valid and
+        // invalid message lengths
+        if (noiseBytes)
+        {
+            bytes = nextRandom() % (noiseBytes + 1);
+            fillPayload(&corpus[length], bytes);
+            if (corpusMessages && (bytes >= NOISE_HEADER_BYTES) && (nextRandom() & 1))
+            {
+                offset = length + nextRandom() % (bytes - NOISE_HEADER_BYTES + 1);
+                memcpy(&corpus[offset], &corpus[previous], NOISE_HEADER_BYTES);
+                if (nextRandom() & 1)
+                    corpus[offset + 1 + nextRandom() % (NOISE_HEADER_BYTES - 1)] = nextRandom();
+            }
+            length += bytes;
+        }
+        previous = length;
+
+        // Select the next message type
+        do
+        {
+            messageType <<= 1;
+            if (messageType > MSG_SPARTN)
+                messageType = 1;
+        } while ((messageType & messageTypes) == 0);
+
+        // Add the message to the data stream
+        switch (messageType)
+        {
+        case MSG_NMEA:
+            length += buildNmeaSentence(&corpus[length]);
+            break;
+        case MSG_RTCM:
+            length += buildRtcmMessage(&corpus[length]);
+            break;
+        case MSG_UBLOX:
+            length += buildUbloxMessage(&corpus[length]);
+            break;
+        case MSG_UNICORE_BINARY:
+            length += buildUnicoreBinaryMessage(&corpus[length]);
+            break;
+        case MSG_UNICORE_HASH:
+            length += buildUnicoreHashSentence(&corpus[length]);
+            break;
+        case MSG_SBF:
+            length += buildSbfMessage(&corpus[length]);
+            break;
+        case MSG_SPARTN:
+            memcpy(&corpus[length], spartnMessage, sizeof(spartnMessage));
+            length += sizeof(spartnMessage);
+            break;
+        }
+        corpusMessages += 1;
+    }
+    return length;
+}
+
+// Get the next pseudo random value, repeatable between runs
+uint32_t nextRandom()
+{
+    randomValue = randomValue * 1103515245 + 12345;
+    return randomValue >> 16;
+}
+
+// Fill a payload with pseudo random data
+void fillPayload(uint8_t *buffer, size_t length)
+{
+    while (length--)
+        *buffer++ = nextRandom();
+}
+
+// Build an NMEA sentence, returns the sentence length in bytes
+size_t buildNmeaSentence(uint8_t *buffer)
+{
+    return formatSentence(buffer, SEMP_NMEA_PREAMBLE,
+                          nmeaSentences[corpusMessages % nmeaSentenceCount], "\r\n");
+}
+
+// Build a sentence using the NMEA checksum, returns the sentence length
+// in bytes
+size_t formatSentence(uint8_t *buffer, char preamble, const char *sentence, const char *lineTermination)
+{
+    uint8_t checksum;
+
+    // Compute the checksum
+    checksum = 0;
+    for (const char *data = sentence; *data; data++)
+        checksum ^= *data;
+    return sprintf((char *)buffer, "%c%s*%02X%s", preamble, sentence, checksum, lineTermination);
+}
+
+// Build an RTCM message, returns the message length in bytes
+size_t buildRtcmMessage(uint8_t *buffer)
+{
+    size_t length;
+    uint16_t messageNumber;
+
+    // Vary the message number and the payload length
+    messageNumber = 1077 + 10 * (corpusMessages % 4);
+    length = 100 + (corpusMessages % 200);
+
+    // Build the header and payload
+    buffer[0] = SEMP_RTCM_PREAMBLE;
+    buffer[1] = length >> 8;
+    buffer[2] = length & 0xff;
+    fillPayload(&buffer[3], length);
+    buffer[3] = messageNumber >> 4;
+    buffer[4] = (buffer[4] & 0x0f) | ((messageNumber << 4) & 0xf0);
+    return addRtcmCrc(buffer, length + 3);
+}
+
+// Add the CRC-24Q to an RTCM message, returns the message length in bytes
+size_t addRtcmCrc(uint8_t *buffer, size_t length)
+{
+    uint32_t crc;
+    size_t index;
+
+    crc = 0;
+    for (index = 0; index < length; index++)
+        crc = ((crc << 8) ^ semp_crc24qTable[buffer[index] ^ ((crc >> 16) & 0xff)]) & 0xffffff;
+    buffer[length++] = crc >> 16;
+    buffer[length++] = crc >> 8;
+    buffer[length++] = crc;
+    return length;
+}
+
+// Add the header and CRC-24Q to the RTCM payload following the header,
+// returns the message length in bytes
+size_t frameRtcmMessage(uint8_t *buffer, uint32_t payloadBits)
+{
+    size_t length;
+
+    length = (payloadBits + 7) / 8;
+    buffer[0] = SEMP_RTCM_PREAMBLE;
+    buffer[1] = length >> 8;
+    buffer[2] = length & 0xff;
+    return addRtcmCrc(buffer, length + 3);
+}
+
+// Write a field into a RTCM payload, most significant bit first
+void writeRtcmBits(uint8_t *payload, uint32_t *bitOffset, uint64_t value, int width)
+{
+    uint8_t mask;
+
+    while (width-- > 0)
+    {
+        mask = 0x80 >> (*bitOffset & 7);
+        if ((value >> width) & 1)
+            payload[*bitOffset >> 3] |= mask;
+        else
+            payload[*bitOffset >> 3] &= ~mask;
+        *bitOffset += 1;
+    }
+}
+
+// Write a counted string into a RTCM payload
+void writeRtcmString(uint8_t *payload, uint32_t *bitOffset, const char *string)
+{
+    writeRtcmBits(payload, bitOffset, strlen(string), 8);
+    while (*string)
+        writeRtcmBits(payload, bitOffset, *string++, 8);
+}
+
+// Build an RTCM 1005 or 1006 message, RTCM 10403.3 Tables 3.5-9 and
+// 3.5-10, returns the message length in bytes
+size_t buildRtcm1005Message(uint8_t *buffer, const SEMP_RTCM_1005 *station)
+{
+    uint32_t bit;
+    uint8_t *payload;
+
+    payload = &buffer[3];
+    memset(payload, 0, 32);
+    bit = 0;
+    writeRtcmBits(payload, &bit, station->messageNumber, 12);
+    writeRtcmBits(payload, &bit, station->stationId, 12);
+    writeRtcmBits(payload, &bit, station->itrfYear, 6);
+    writeRtcmBits(payload, &bit, station->gps, 1);
+    writeRtcmBits(payload, &bit, station->glonass, 1);
+    writeRtcmBits(payload, &bit, station->galileo, 1);
+    writeRtcmBits(payload, &bit, station->referenceStation, 1);
+    writeRtcmBits(payload, &bit, station->ecefX, 38);
+    writeRtcmBits(payload, &bit, station->singleOscillator, 1);
+    writeRtcmBits(payload, &bit, 0, 1);
+    writeRtcmBits(payload, &bit, station->ecefY, 38);
+    writeRtcmBits(payload, &bit, station->quarterCycle, 2);
+    writeRtcmBits(payload, &bit, station->ecefZ, 38);
+    if (station->messageNumber == 1006)
+        writeRtcmBits(payload, &bit, station->antennaHeight, 16);
+    return frameRtcmMessage(buffer, bit);
+}
+
+// Build an RTCM MSM4 message, RTCM 10403.3 Tables 3.5-78, 3.5-80 and
+// 3.5-82, returns the message length in bytes
+size_t buildRtcmMsmMessage(uint8_t *buffer)
+{
+    uint32_t bit;
+    int cell;
+    int index;
+    uint8_t *payload;
+    int satellite;
+    int signal;
+
+    // Write the header
+    payload = &buffer[3];
+    memset(payload, 0, 64);
+    bit = 0;
+    writeRtcmBits(payload, &bit, rtcmMsmHeader.messageNumber, 12);
+    writeRtcmBits(payload, &bit, rtcmMsmHeader.stationId, 12);
+    writeRtcmBits(payload, &bit, rtcmMsmHeader.epochTime, 30);
+    writeRtcmBits(payload, &bit, rtcmMsmHeader.multipleMessage, 1);
+    writeRtcmBits(payload, &bit, rtcmMsmHeader.iods, 3);
+    writeRtcmBits(payload, &bit, 0, 7);
+    writeRtcmBits(payload, &bit, rtcmMsmHeader.clockSteering, 2);
+    writeRtcmBits(payload, &bit, rtcmMsmHeader.externalClock, 2);
+    writeRtcmBits(payload, &bit, rtcmMsmHeader.smoothing, 1);
+    writeRtcmBits(payload, &bit, rtcmMsmHeader.smoothingInterval, 3);
+
+    // Write the satellite mask, signal mask and cell mask, the first bit
+    // of each mask is ID 1
+    for (index = 1; index <= SEMP_RTCM_MSM_SATELLITES; index++)
+    {
+        for (satellite = 0; satellite < rtcmMsmSatelliteCount; satellite++)
+            if (rtcmMsmSatellites[satellite].id == index)
+                break;
+        writeRtcmBits(payload, &bit, satellite < rtcmMsmSatelliteCount, 1);
+    }
+    for (index = 1; index <= SEMP_RTCM_MSM_SIGNALS; index++)
+    {
+        for (signal = 0; signal < rtcmMsmSignalCount; signal++)
+            if (rtcmMsmSignalIds[signal] == index)
+                break;
+        writeRtcmBits(payload, &bit, signal < rtcmMsmSignalCount, 1);
+    }
+    for (satellite = 0; satellite < rtcmMsmSatelliteCount; satellite++)
+        for (signal = 0; signal < rtcmMsmSignalCount; signal++)
+        {
+            for (cell = 0; cell < rtcmMsmCellCount; cell++)
+                if ((rtcmMsmCells[cell].satellite == satellite)
+                    && (rtcmMsmCells[cell].signalId == rtcmMsmSignalIds[signal]))
+                    break;
+            writeRtcmBits(payload, &bit, cell < rtcmMsmCellCount, 1);
+        }
+
+    // Write each field of the satellite data for all of the satellites,
+    // then each field of the signal data for all of the cells
+    for (satellite = 0; satellite < rtcmMsmSatelliteCount; satellite++)
+        writeRtcmBits(payload, &bit, rtcmMsmSatellites[satellite].roughRangeMs, 8);
+    for (satellite = 0; satellite < rtcmMsmSatelliteCount; satellite++)
+        writeRtcmBits(payload, &bit, rtcmMsmSatellites[satellite].roughRangeModMs, 10);
+    for (cell = 0; cell < rtcmMsmCellCount; cell++)
+        writeRtcmBits(payload, &bit, rtcmMsmCells[cell].finePseudorange, 15);
+    for (cell = 0; cell < rtcmMsmCellCount; cell++)
+        writeRtcmBits(payload, &bit, rtcmMsmCells[cell].finePhaseRange, 22);
+    for (cell = 0; cell < rtcmMsmCellCount; cell++)
+        writeRtcmBits(payload, &bit, rtcmMsmCells[cell].lockTime, 4);
+    for (cell = 0; cell < rtcmMsmCellCount; cell++)
+        writeRtcmBits(payload, &bit, rtcmMsmCells[cell].halfCycle, 1);
+    for (cell = 0; cell < rtcmMsmCellCount; cell++)
+        writeRtcmBits(payload, &bit, rtcmMsmCells[cell].cnr, 6);
+    return frameRtcmMessage(buffer, bit);
+}
+
+// Build an RTCM 1033 message, RTCM 10403.3 Table 3.5-24, returns the
+// message length in bytes
+size_t buildRtcm1033Message(uint8_t *buffer)
+{
+    uint32_t bit;
+    uint8_t *payload;
+
+    payload = &buffer[3];
+    bit = 0;
+    writeRtcmBits(payload, &bit, 1033, 12);
+    writeRtcmBits(payload, &bit, rtcmDescriptors.stationId, 12);
+    writeRtcmString(payload, &bit, rtcmDescriptors.antennaDescriptor);
+    writeRtcmBits(payload, &bit, rtcmDescriptors.antennaSetupId, 8);
+    writeRtcmString(payload, &bit, rtcmDescriptors.antennaSerialNumber);
+    writeRtcmString(payload, &bit, rtcmDescriptors.receiverType);
+    writeRtcmString(payload, &bit, rtcmDescriptors.receiverFirmware);
+    writeRtcmString(payload, &bit, rtcmDescriptors.receiverSerialNumber);
+    return frameRtcmMessage(buffer, bit);
+}
+
+// Build a u-blox UBX message, returns the message length in bytes
+size_t buildUbloxMessage(uint8_t *buffer)
+{
+    size_t length;
+
+    // Build a NAV-PVT message
+    length = 92;
+    buffer[0] = SEMP_UBLOX_PREAMBLE;
+    buffer[1] = 0x62;
+    buffer[2] = 0x01;
+    buffer[3] = 0x07;
+    buffer[4] = length & 0xff;
+    buffer[5] = length >> 8;
+    fillPayload(&buffer[6], length);
+    return addUbloxChecksum(buffer, length + 6);
+}
+
+// Build a u-blox UBX NAV message with the iTOW field at iTowOffset in
+// the payload, returns the message length in bytes
+size_t buildUbloxNavMessage(uint8_t *buffer, uint8_t id, uint32_t iTow, size_t iTowOffset, size_t length)
+{
+    buffer[0] = SEMP_UBLOX_PREAMBLE;
+    buffer[1] = 0x62;
+    buffer[2] = 0x01;
+    buffer[3] = id;
+    buffer[4] = length & 0xff;
+    buffer[5] = length >> 8;
+    memset(&buffer[6], 0, length);
+    buffer[6 + iTowOffset] = iTow;
+    buffer[7 + iTowOffset] = iTow >> 8;
+    buffer[8 + iTowOffset] = iTow >> 16;
+    buffer[9 + iTowOffset] = iTow >> 24;
+    return addUbloxChecksum(buffer, length + 6);
+}
+
+// Add the checksum to a u-blox UBX message, returns the message length
+// in bytes
+size_t addUbloxChecksum(uint8_t *buffer, size_t length)
+{
+    uint8_t ckA;
+    uint8_t ckB;
+    size_t index;
+
+    ckA = 0;
+    ckB = 0;
+    for (index = 2; index < length; index++)
+    {
+        ckA += buffer[index];
+        ckB += ckA;
+    }
+    buffer[length++] = ckA;
+    buffer[length++] = ckB;
+    return length;
+}
+
+// Build a Unicore binary message, returns the message length in bytes
+size_t buildUnicoreBinaryMessage(uint8_t *buffer)
+{
+    uint32_t crc;
+    size_t length;
+    SEMP_UNICORE_HEADER header;
+
+    // Build the header for a BESTNAV message followed by the payload
+    length = 72 + 8 * (corpusMessages % 8);
+    memset(&header, 0, sizeof(header));
+    header.syncA = SEMP_UNICORE_BINARY_PREAMBLE;
+    header.syncB = 0x44;
+    header.syncC = 0xb5;
+    header.messageId = 2118;
+    header.messageLength = length;
+    header.weekNumber = 2283;
+    header.secondsOfWeek = corpusMessages * 1000;
+    memcpy(buffer, &header, sizeof(header));
+    fillPayload(&buffer[sizeof(header)], length);
+    length += sizeof(header);
+
+    // Add the CRC
+    crc = semp_crc32Buffer(0, buffer, length);
+    buffer[length++] = crc;
+    buffer[length++] = crc >> 8;
+    buffer[length++] = crc >> 16;
+    buffer[length++] = crc >> 24;
+    return length;
+}
+
+// Build a Unicore hash sentence, returns the sentence length in bytes
+size_t buildUnicoreHashSentence(uint8_t *buffer)
+{
+    uint32_t crc;
+    const char *sentence;
+
+    // The VERSION sentence uses a CRC computed without the # or * characters
+    sentence = unicoreHashSentences[corpusMessages % unicoreHashSentenceCount];
+    if (strncmp(sentence, "VERSION,", 8) == 0)
+    {
+        crc = semp_crc32Buffer(0, (const uint8_t *)sentence, strlen(sentence));
+        return sprintf((char *)buffer, "#%s*%08lx\r\n", sentence, (unsigned long)crc);
+    }
+
+    // The other sentences use the NMEA checksum
+    return formatSentence(buffer, SEMP_UNICORE_HASH_PREAMBLE, sentence, "\r\n");
+}
+
+// Build an SBF message, returns the message length in bytes
+size_t buildSbfMessage(uint8_t *buffer)
+{
+    uint16_t crc;
+    int bit;
+    size_t index;
+    size_t length;
+
+    // Build a PVTGeodetic block, the length includes the header
+    length = 96;
+    buffer[0] = '$';
+    buffer[1] = '@';
+    buffer[4] = 4007 & 0xff;
+    buffer[5] = 4007 >> 8;
+    buffer[6] = length & 0xff;
+    buffer[7] = length >> 8;
+    fillPayload(&buffer[8], length - 8);
+
+    // Compute the CRC-CCITT over the ID, length and payload
+    crc = 0;
+    for (index = 4; index < length; index++)
+    {
+        crc ^= buffer[index] << 8;
+        for (bit = 0; bit < 8; bit++)
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x1021) : (crc << 1);
+    }
+    buffer[2] = crc & 0xff;
+    buffer[3] = crc >> 8;
+    return length;
+}
+
+// Print the error message every 15 seconds
+void reportFatalError(const char *errorMsg)
+{
+    while (1)
+    {
+        Serial.print("HALTED: ");
+        Serial.print(errorMsg);
+        Serial.println();
+        sleep(15);
+    }
+}
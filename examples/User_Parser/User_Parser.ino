@@ -36,8 +36,9 @@ bool userFindNumber(SEMP_PARSE_STATE *parse, uint8_t data)
     // Account for the valid message
     scratchPad->messageNumber += 1;
 
-    // Pass the valid message to the end-of-message handler
-    parse->eomCallback(parse, parse->type);
+    // Pass the valid message to the end-of-message handler, the parser
+    // must not call parse->eomCallback directly
+    sempDeliverMessage(parse);
 
     // Start searching for a preamble byte
     parse->state = sempFirstByte;
@@ -23,6 +23,66 @@ License: MIT. Please see LICENSE.md for more details
 // Save room for the asterisk, checksum, carriage return, linefeed and zero termination
 #define NMEA_BUFFER_OVERHEAD    (1 + 2 + 2 + 1)
 
+// Perfect hash of the three character sentence types, the multiplier
+// gives each of the types in sempNmeaSentenceTypes its own slot
+#define NMEA_TYPE_HASH(code)    ((uint32_t)((code) * 0x8a7d43b5u) >> 27)
+
+// Sentence types indexed by the sentence ID
+const char * const sempNmeaSentenceTypes[SEMP_NMEA_ID_COUNT] =
+{
+    "",    "DTM", "GBS", "GGA", "GLL", "GNS", "GRS", "GSA",
+    "GST", "GSV", "HDT", "RMC", "THS", "TXT", "VTG", "ZDA",
+};
+
+// Sentence ID for each of the perfect hash slots
+const uint8_t sempNmeaTypeHashSlots[32] =
+{
+    0,                  0,                  SEMP_NMEA_ID_GLL,   0,
+    0,                  0,                  0,                  SEMP_NMEA_ID_ZDA,
+    SEMP_NMEA_ID_VTG,   0,                  0,                  SEMP_NMEA_ID_THS,
+    0,                  0,                  0,                  0,
+    0,                  SEMP_NMEA_ID_GSA,   0,                  SEMP_NMEA_ID_RMC,
+    0,                  SEMP_NMEA_ID_GGA,   SEMP_NMEA_ID_TXT,   SEMP_NMEA_ID_DTM,
+    SEMP_NMEA_ID_HDT,   SEMP_NMEA_ID_GRS,   SEMP_NMEA_ID_GST,   SEMP_NMEA_ID_GNS,
+    0,                  SEMP_NMEA_ID_GSV,   0,                  SEMP_NMEA_ID_GBS,
+};
+
+//----------------------------------------
+// Support routines
+//----------------------------------------
+
+// Classify the sentence name, returns the sentence ID
+uint8_t sempNmeaClassifySentence(const SEMP_NMEA_VALUES *nmea)
+{
+    uint32_t code;
+    uint8_t id;
+
+    // Only the standard sentences have a two character talker ID followed
+    // by the three character sentence type
+    if ((nmea->sentenceNameLength != 5) || (nmea->sentenceName[0] == 'P'))
+        return SEMP_NMEA_ID_UNKNOWN;
+
+    // Look up the sentence type, verifying the slot's type
+    code = nmea->nameCode & 0xffffff;
+    id = sempNmeaTypeHashSlots[NMEA_TYPE_HASH(code)];
+    if (id && (memcmp(&nmea->sentenceName[2], sempNmeaSentenceTypes[id], 3) == 0))
+        return id;
+    return SEMP_NMEA_ID_UNKNOWN;
+}
+
+// Consume a run of sentence data bytes
+size_t sempNmeaConsumeBytes(SEMP_PARSE_STATE *parse, const uint8_t *data, size_t length)
+{
+    // Leave the byte that does not fit for sempNmeaFindAsterisk
+    if ((parse->length + NMEA_BUFFER_OVERHEAD) >= parse->bufferLength)
+        return 0;
+
+    // Index the fields while buffering the sentence data
+    return sempScanSentence(parse, data, length,
+                            parse->bufferLength - NMEA_BUFFER_OVERHEAD - parse->length,
+                            &parse->fields);
+}
+
 //----------------------------------------
 // NMEA parse routines
 //----------------------------------------
@@ -43,7 +103,12 @@ License: MIT. Please see LICENSE.md for more details
 void sempNmeaValidateChecksum(SEMP_PARSE_STATE *parse)
 {
     int checksum;
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    uint32_t received;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
+
+    // Remove the received line termination from the length
+    received = parse->length;
+    parse->length = sempSentenceLength(parse);
 
     // Convert the checksum characters into binary
     checksum = sempAsciiToNibble(parse->buffer[parse->length - 2]) << 4;
@@ -52,35 +117,34 @@ void sempNmeaValidateChecksum(SEMP_PARSE_STATE *parse)
     // Validate the checksum
     if ((checksum == parse->crc) || (parse->badCrc && (!parse->badCrc(parse))))
     {
-        // Always add the carriage return and line feed
-        parse->buffer[parse->length++] = '\r';
-        parse->buffer[parse->length++] = '\n';
-
-        // Zero terminate the NMEA sentence, don't count this in the length
-        parse->buffer[parse->length] = 0;
+        // Always end the sentence with a carriage return and line feed
+        sempTerminateSentence(parse, received);
 
         // Process this NMEA sentence
-        parse->eomCallback(parse, parse->type); // Pass parser array index
+        sempDeliverMessage(parse);
     }
     else
+    {
         // Display the checksum error
-        sempPrintf(parse->printDebug,
-                   "SEMP: %s NMEA %s, 0x%04x (%d) bytes, bad checksum, "
-                   "received 0x%c%c, computed: 0x%02x",
-                   parse->parserName,
-                   scratchPad->nmea.sentenceName,
-                   parse->length, parse->length,
-                   parse->buffer[parse->length - 2],
-                   parse->buffer[parse->length - 1],
-                   parse->crc);
+        sempLogEvent(parse, SEMP_EVENT_BAD_CRC, checksum, parse->crc);
+        SEMP_DEBUG_PRINTF(parse->printDebug,
+                          "SEMP: %s NMEA %s, 0x%04x (%d) bytes, bad checksum, "
+                          "received 0x%c%c, computed: 0x%02x",
+                          parse->parserName,
+                          scratchPad->nmea.sentenceName,
+                          parse->length, parse->length,
+                          parse->buffer[parse->length - 2],
+                          parse->buffer[parse->length - 1],
+                          parse->crc);
+
+        // Keep the received bytes in the buffer for resync
+        parse->length = received;
+    }
 }
 
 // Read the linefeed
 bool sempNmeaLineFeed(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    // Don't add the current character to the length
-    parse->length -= 1;
-
     // Process the LF
     if (data == '\n')
     {
@@ -92,6 +156,9 @@ bool sempNmeaLineFeed(SEMP_PARSE_STATE *parse, uint8_t data)
         return true;
     }
 
+    // Don't add the current character to the length
+    parse->length -= 1;
+
     // Pass the sentence to the upper layer
     sempNmeaValidateChecksum(parse);
 
@@ -102,9 +169,6 @@ bool sempNmeaLineFeed(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the remaining carriage return
 bool sempNmeaCarriageReturn(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    // Don't add the current character to the length
-    parse->length -= 1;
-
     // Process the CR
     if (data == '\r')
     {
@@ -116,6 +180,9 @@ bool sempNmeaCarriageReturn(SEMP_PARSE_STATE *parse, uint8_t data)
         return true;
     }
 
+    // Don't add the current character to the length
+    parse->length -= 1;
+
     // Pass the sentence to the upper layer
     sempNmeaValidateChecksum(parse);
 
@@ -123,12 +190,10 @@ bool sempNmeaCarriageReturn(SEMP_PARSE_STATE *parse, uint8_t data)
     return sempFirstByte(parse, data);
 }
 
-// Read the line termination
+// Read the line termination, the received carriage return and line feed
+// remain in the buffer until the checksum is validated
 bool sempNmeaLineTermination(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    // Don't add the current character to the length
-    parse->length -= 1;
-
     // Process the line termination
     if (data == '\r')
     {
@@ -141,6 +206,9 @@ bool sempNmeaLineTermination(SEMP_PARSE_STATE *parse, uint8_t data)
         return true;
     }
 
+    // Don't add the current character to the length
+    parse->length -= 1;
+
     // Pass the sentence to the upper layer
     sempNmeaValidateChecksum(parse);
 
@@ -159,9 +227,10 @@ bool sempNmeaChecksumByte2(SEMP_PARSE_STATE *parse, uint8_t data)
     }
 
     // Invalid checksum character
-    sempPrintf(parse->printDebug,
-               "SEMP %s: NMEA invalid second checksum character",
-               parse->parserName);
+    sempLogEvent(parse, SEMP_EVENT_INVALID_DATA, data, 0);
+    SEMP_DEBUG_PRINTF(parse->printDebug,
+                      "SEMP %s: NMEA invalid second checksum character",
+                      parse->parserName);
 
     // Start searching for a preamble byte
     return sempFirstByte(parse, data);
@@ -178,9 +247,10 @@ bool sempNmeaChecksumByte1(SEMP_PARSE_STATE *parse, uint8_t data)
     }
 
     // Invalid checksum character
-    sempPrintf(parse->printDebug,
-               "SEMP %s: NMEA invalid first checksum character",
-               parse->parserName);
+    sempLogEvent(parse, SEMP_EVENT_INVALID_DATA, data, 0);
+    SEMP_DEBUG_PRINTF(parse->printDebug,
+                      "SEMP %s: NMEA invalid first checksum character",
+                      parse->parserName);
 
     // Start searching for a preamble byte
     return sempFirstByte(parse, data);
@@ -190,20 +260,27 @@ bool sempNmeaChecksumByte1(SEMP_PARSE_STATE *parse, uint8_t data)
 bool sempNmeaFindAsterisk(SEMP_PARSE_STATE *parse, uint8_t data)
 {
     if (data == '*')
+    {
+        parse->fields.end = parse->length - 1;
+        parse->consumeBytes = nullptr;
         parse->state = sempNmeaChecksumByte1;
+    }
     else
     {
         // Include this byte in the checksum
         parse->crc ^= data;
+        if (data == ',')
+            sempSentenceAddField(&parse->fields, parse->length);
 
         // Verify that enough space exists in the buffer
         if ((uint32_t)(parse->length + NMEA_BUFFER_OVERHEAD) > parse->bufferLength)
         {
             // sentence too long
-            sempPrintf(parse->printDebug,
-                       "SEMP %s: NMEA sentence too long, increase the buffer size > %d",
-                       parse->parserName,
-                       parse->bufferLength);
+            sempLogEvent(parse, SEMP_EVENT_TOO_LONG, 0, 0);
+            SEMP_DEBUG_PRINTF(parse->printDebug,
+                              "SEMP %s: NMEA sentence too long, increase the buffer size > %d",
+                              parse->parserName,
+                              parse->bufferLength);
 
             // Start searching for a preamble byte
             return sempFirstByte(parse, data);
@@ -215,7 +292,7 @@ bool sempNmeaFindAsterisk(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the sentence name
 bool sempNmeaFindFirstComma(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     parse->crc ^= data;
     if ((data != ',') || (scratchPad->nmea.sentenceNameLength == 0))
     {
@@ -223,29 +300,44 @@ bool sempNmeaFindFirstComma(SEMP_PARSE_STATE *parse, uint8_t data)
         uint8_t upper = data & ~0x20;
         if (((upper < 'A') || (upper > 'Z')) && ((data < '0') || (data > '9')))
         {
-            sempPrintf(parse->printDebug,
-                       "SEMP %s: NMEA invalid sentence name character 0x%02x",
-                       parse->parserName, data);
+            sempLogEvent(parse, SEMP_EVENT_BAD_HEADER, data, 0);
+            SEMP_DEBUG_PRINTF(parse->printDebug,
+                              "SEMP %s: NMEA invalid sentence name character 0x%02x",
+                              parse->parserName, data);
             return sempFirstByte(parse, data);
         }
 
         // Name too long, start searching for a preamble byte
         if (scratchPad->nmea.sentenceNameLength == (sizeof(scratchPad->nmea.sentenceName) - 1))
         {
-            sempPrintf(parse->printDebug,
-                       "SEMP %s: NMEA sentence name > %ld characters",
-                       parse->parserName,
-                       sizeof(scratchPad->nmea.sentenceName) - 1);
+            sempLogEvent(parse, SEMP_EVENT_BAD_HEADER, data, 0);
+            SEMP_DEBUG_PRINTF(parse->printDebug,
+                              "SEMP %s: NMEA sentence name > %ld characters",
+                              parse->parserName,
+                              sizeof(scratchPad->nmea.sentenceName) - 1);
             return sempFirstByte(parse, data);
         }
 
         // Save the sentence name
         scratchPad->nmea.sentenceName[scratchPad->nmea.sentenceNameLength++] = data;
+        scratchPad->nmea.nameCode = (scratchPad->nmea.nameCode << 8) | data;
     }
     else
     {
+        // Classify the sentence
+        scratchPad->nmea.sentenceId = sempNmeaClassifySentence(&scratchPad->nmea);
+
         // Zero terminate the sentence name
         scratchPad->nmea.sentenceName[scratchPad->nmea.sentenceNameLength++] = 0;
+
+        // Skip the data and checksum when rejected by the filter
+        if (sempFilterSentence(parse, scratchPad->nmea.sentenceId,
+                               (const char *)scratchPad->nmea.sentenceName, '*', 2))
+            return true;
+
+        // Start the field index with the sentence name and the first field
+        sempSentenceStartFields(parse, ',');
+        parse->consumeBytes = sempNmeaConsumeBytes;
         parse->state = sempNmeaFindAsterisk;
     }
     return true;
@@ -254,39 +346,64 @@ bool sempNmeaFindFirstComma(SEMP_PARSE_STATE *parse, uint8_t data)
 // Check for the preamble
 bool sempNmeaPreamble(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     if (data != '$')
         return false;
     scratchPad->nmea.sentenceNameLength = 0;
+    scratchPad->nmea.sentenceId = SEMP_NMEA_ID_UNKNOWN;
+    scratchPad->nmea.nameCode = 0;
     parse->state = sempNmeaFindFirstComma;
     return true;
 }
 
+// Name the parser states, the preamble routine is first
+const SEMP_STATE_NAME sempNmeaStateNames[] =
+{
+    SEMP_STATE(sempNmeaPreamble),
+    SEMP_STATE(sempNmeaFindFirstComma),
+    SEMP_STATE(sempNmeaFindAsterisk),
+    SEMP_STATE(sempNmeaChecksumByte1),
+    SEMP_STATE(sempNmeaChecksumByte2),
+    SEMP_STATE(sempNmeaLineTermination),
+    SEMP_STATE(sempNmeaCarriageReturn),
+    SEMP_STATE(sempNmeaLineFeed),
+};
+
+// State name table, see sempBeginParser
+const SEMP_STATE_TABLE sempNmeaStateTable =
+{
+    sempNmeaStateNames,
+    sizeof(sempNmeaStateNames) / sizeof(SEMP_STATE_NAME)
+};
+
 // Translates state value into an string, returns nullptr if not found
 const char * sempNmeaGetStateName(const SEMP_PARSE_STATE *parse)
 {
-    if (parse->state == sempNmeaPreamble)
-        return "sempNmeaPreamble";
-    if (parse->state == sempNmeaFindFirstComma)
-        return "sempNmeaFindFirstComma";
-    if (parse->state == sempNmeaFindAsterisk)
-        return "sempNmeaFindAsterisk";
-    if (parse->state == sempNmeaChecksumByte1)
-        return "sempNmeaChecksumByte1";
-    if (parse->state == sempNmeaChecksumByte2)
-        return "sempNmeaChecksumByte2";
-    if (parse->state == sempNmeaLineTermination)
-        return "sempNmeaLineTermination";
-    if (parse->state == sempNmeaCarriageReturn)
-        return "sempNmeaCarriageReturn";
-    if (parse->state == sempNmeaLineFeed)
-        return "sempNmeaLineFeed";
-    return nullptr;
+    return sempFindStateName(&sempNmeaStateTable, parse->state);
 }
 
 // Return the NMEA sentence name as a string
 const char * sempNmeaGetSentenceName(const SEMP_PARSE_STATE *parse)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     return (const char *)scratchPad->nmea.sentenceName;
 }
+
+// Get the NMEA sentence ID
+uint8_t sempNmeaGetSentenceId(const SEMP_PARSE_STATE *parse)
+{
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
+    return scratchPad->nmea.sentenceId;
+}
+
+// Get the number of fields in the NMEA sentence
+uint16_t sempNmeaGetFieldCount(const SEMP_PARSE_STATE *parse)
+{
+    return parse->fields.count;
+}
+
+// Get a field of the NMEA sentence
+const char * sempNmeaGetField(const SEMP_PARSE_STATE *parse, uint16_t field, size_t *length)
+{
+    return sempSentenceGetField(parse, &parse->fields, field, length);
+}
@@ -13,6 +13,7 @@ should need to be listed in SparkFun_Extensible_Message_Parser.h.
 License: MIT. Please see LICENSE.md for more details
 ------------------------------------------------------------------------------*/
 
+#include <stddef.h>
 #include <stdio.h>
 #include "SparkFun_Extensible_Message_Parser.h"
 #include "semp_crc24q.h" // 24-bit CRC-24Q cyclic redundancy checksum for RTCM parsing
@@ -28,6 +29,23 @@ uint32_t sempRtcmComputeCrc24q(SEMP_PARSE_STATE *parse, uint8_t data)
     return crc & 0x00ffffff;
 }
 
+// Consume a run of message data bytes
+size_t sempRtcmConsumeBytes(SEMP_PARSE_STATE *parse, const uint8_t *data, size_t length)
+{
+    size_t bytes;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
+
+    // Leave the last data byte for sempRtcmReadData
+    if (scratchPad->rtcm.bytesRemaining <= 1)
+        return 0;
+
+    // Save the data bytes and update the CRC
+    bytes = sempBufferBytes(parse, data, length, scratchPad->rtcm.bytesRemaining - 1);
+    parse->crc = semp_crc24qBuffer(parse->crc, data, bytes);
+    scratchPad->rtcm.bytesRemaining -= bytes;
+    return bytes;
+}
+
 //----------------------------------------
 // RTCM parse routines
 //----------------------------------------
@@ -49,7 +67,7 @@ uint32_t sempRtcmComputeCrc24q(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the CRC
 bool sempRtcmReadCrc(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     // Account for this data byte
     scratchPad->rtcm.bytesRemaining -= 1;
@@ -60,22 +78,29 @@ bool sempRtcmReadCrc(SEMP_PARSE_STATE *parse, uint8_t data)
 
     // Process the message if CRC is valid
     if ((parse->crc == 0) || (parse->badCrc && (!parse->badCrc(parse))))
-        parse->eomCallback(parse, parse->type); // Pass parser array index
+        sempDeliverMessage(parse);
 
     // Display the RTCM messages with bad CRC
     else
-        sempPrintf(parse->printDebug,
-                   "SEMP: %s RTCM %d, 0x%04x (%d) bytes, bad CRC, "
-                   "received %02x %02x %02x, computed: %02x %02x %02x",
-                   parse->parserName,
-                   scratchPad->rtcm.message,
-                   parse->length, parse->length,
-                   parse->buffer[parse->length - 3],
-                   parse->buffer[parse->length - 2],
-                   parse->buffer[parse->length - 1],
-                   (scratchPad->rtcm.crc >> 16) & 0xff,
-                   (scratchPad->rtcm.crc >> 8) & 0xff,
-                   scratchPad->rtcm.crc & 0xff);
+    {
+        sempLogEvent(parse, SEMP_EVENT_BAD_CRC,
+                     (parse->buffer[parse->length - 3] << 16)
+                     | (parse->buffer[parse->length - 2] << 8)
+                     | parse->buffer[parse->length - 1],
+                     scratchPad->rtcm.crc);
+        SEMP_DEBUG_PRINTF(parse->printDebug,
+                          "SEMP: %s RTCM %d, 0x%04x (%d) bytes, bad CRC, "
+                          "received %02x %02x %02x, computed: %02x %02x %02x",
+                          parse->parserName,
+                          scratchPad->rtcm.message,
+                          parse->length, parse->length,
+                          parse->buffer[parse->length - 3],
+                          parse->buffer[parse->length - 2],
+                          parse->buffer[parse->length - 1],
+                          (scratchPad->rtcm.crc >> 16) & 0xff,
+                          (scratchPad->rtcm.crc >> 8) & 0xff,
+                          scratchPad->rtcm.crc & 0xff);
+    }
 
     // Search for another preamble byte
     parse->state = sempFirstByte;
@@ -85,7 +110,7 @@ bool sempRtcmReadCrc(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the rest of the message
 bool sempRtcmReadData(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     // Account for this data byte
     scratchPad->rtcm.bytesRemaining -= 1;
@@ -95,6 +120,7 @@ bool sempRtcmReadData(SEMP_PARSE_STATE *parse, uint8_t data)
     {
         scratchPad->rtcm.crc = parse->crc;
         scratchPad->rtcm.bytesRemaining = 3;
+        parse->consumeBytes = nullptr;
         parse->state = sempRtcmReadCrc;
     }
     return true;
@@ -103,10 +129,17 @@ bool sempRtcmReadData(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the lower 4 bits of the message number
 bool sempRtcmReadMessage2(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     scratchPad->rtcm.message |= data >> 4;
     scratchPad->rtcm.bytesRemaining -= 1;
+
+    // Skip the rest of the message and the CRC when rejected by the filter
+    if (sempFilterMessage(parse, scratchPad->rtcm.message,
+                          scratchPad->rtcm.bytesRemaining + 3))
+        return true;
+
+    parse->consumeBytes = sempRtcmConsumeBytes;
     parse->state = sempRtcmReadData;
     return true;
 }
@@ -114,7 +147,7 @@ bool sempRtcmReadMessage2(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the upper 8 bits of the message number
 bool sempRtcmReadMessage1(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     scratchPad->rtcm.message = data << 4;
     scratchPad->rtcm.bytesRemaining -= 1;
@@ -125,9 +158,13 @@ bool sempRtcmReadMessage1(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the lower 8 bits of the length
 bool sempRtcmReadLength2(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     scratchPad->rtcm.bytesRemaining |= data;
+
+    // Verify that the message and CRC fit in the buffer
+    if (!sempMessageFits(parse, scratchPad->rtcm.bytesRemaining + 3))
+        return sempFirstByte(parse, data);
     parse->state = sempRtcmReadMessage1;
     return true;
 }
@@ -135,12 +172,15 @@ bool sempRtcmReadLength2(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the upper two bits of the length
 bool sempRtcmReadLength1(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     // Verify the length byte - check the 6 MS bits are all zero
     if (data & (~3))
+    {
         // Invalid length, start searching for a preamble byte
+        sempLogEvent(parse, SEMP_EVENT_BAD_HEADER, data, 0);
         return sempFirstByte(parse, data);
+    }
 
     // Save the upper 2 bits of the length
     scratchPad->rtcm.bytesRemaining = data << 8;
@@ -164,29 +204,438 @@ bool sempRtcmPreamble(SEMP_PARSE_STATE *parse, uint8_t data)
     return false;
 }
 
+// Name the parser states, the preamble routine is first
+const SEMP_STATE_NAME sempRtcmStateNames[] =
+{
+    SEMP_STATE(sempRtcmPreamble),
+    SEMP_STATE(sempRtcmReadLength1),
+    SEMP_STATE(sempRtcmReadLength2),
+    SEMP_STATE(sempRtcmReadMessage1),
+    SEMP_STATE(sempRtcmReadMessage2),
+    SEMP_STATE(sempRtcmReadData),
+    SEMP_STATE(sempRtcmReadCrc),
+};
+
+// State name table, see sempBeginParser
+const SEMP_STATE_TABLE sempRtcmStateTable =
+{
+    sempRtcmStateNames,
+    sizeof(sempRtcmStateNames) / sizeof(SEMP_STATE_NAME)
+};
+
 // Translates state value into an string, returns nullptr if not found
 const char * sempRtcmGetStateName(const SEMP_PARSE_STATE *parse)
 {
-    if (parse->state == sempRtcmPreamble)
-        return "sempRtcmPreamble";
-    if (parse->state == sempRtcmReadLength1)
-        return "sempRtcmReadLength1";
-    if (parse->state == sempRtcmReadLength2)
-        return "sempRtcmReadLength2";
-    if (parse->state == sempRtcmReadMessage1)
-        return "sempRtcmReadMessage1";
-    if (parse->state == sempRtcmReadMessage2)
-        return "sempRtcmReadMessage2";
-    if (parse->state == sempRtcmReadData)
-        return "sempRtcmReadData";
-    if (parse->state == sempRtcmReadCrc)
-        return "sempRtcmReadCrc";
-    return nullptr;
+    return sempFindStateName(&sempRtcmStateTable, parse->state);
 }
 
 // Get the message number
 uint16_t sempRtcmGetMessageNumber(const SEMP_PARSE_STATE *parse)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     return scratchPad->rtcm.message;
 }
+
+//----------------------------------------
+// RTCM decode routines
+//----------------------------------------
+
+// Describe a MSM data field
+typedef struct _SEMP_RTCM_FIELD
+{
+    uint8_t width;                 // Width of the field in bits
+    bool isSigned;                 // Field is two's complement
+    uint8_t offset;                // Offset of the value in the structure
+    uint8_t bytes;                 // Size of the value in the structure
+} SEMP_RTCM_FIELD;
+
+#define SEMP_RTCM_SAT_FIELD(width, isSigned, member)            \
+    {width, isSigned, offsetof(SEMP_RTCM_MSM_SATELLITE, member),  \
+     sizeof(((SEMP_RTCM_MSM_SATELLITE *)0)->member)}
+
+#define SEMP_RTCM_CELL_FIELD(width, isSigned, member)           \
+    {width, isSigned, offsetof(SEMP_RTCM_MSM_CELL, member),       \
+     sizeof(((SEMP_RTCM_MSM_CELL *)0)->member)}
+
+// MSM4 and MSM6 satellite data, RTCM 10403.3 Tables 3.5-79 and 3.5-83
+const SEMP_RTCM_FIELD sempRtcmMsm46Satellite[] =
+{
+    SEMP_RTCM_SAT_FIELD( 8, false, roughRangeMs),           // DF397
+    SEMP_RTCM_SAT_FIELD(10, false, roughRangeModMs),        // DF398
+};
+
+// MSM5 and MSM7 satellite data, RTCM 10403.3 Tables 3.5-81 and 3.5-85
+const SEMP_RTCM_FIELD sempRtcmMsm57Satellite[] =
+{
+    SEMP_RTCM_SAT_FIELD( 8, false, roughRangeMs),           // DF397
+    SEMP_RTCM_SAT_FIELD( 4, false, extendedInfo),           // DF419
+    SEMP_RTCM_SAT_FIELD(10, false, roughRangeModMs),        // DF398
+    SEMP_RTCM_SAT_FIELD(14, true,  roughPhaseRangeRate),    // DF399
+};
+
+// MSM4 signal data, RTCM 10403.3 Table 3.5-80
+const SEMP_RTCM_FIELD sempRtcmMsm4Signal[] =
+{
+    SEMP_RTCM_CELL_FIELD(15, true,  finePseudorange),       // DF400
+    SEMP_RTCM_CELL_FIELD(22, true,  finePhaseRange),        // DF401
+    SEMP_RTCM_CELL_FIELD( 4, false, lockTime),              // DF402
+    SEMP_RTCM_CELL_FIELD( 1, false, halfCycle),             // DF420
+    SEMP_RTCM_CELL_FIELD( 6, false, cnr),                   // DF403
+};
+
+// MSM5 signal data, RTCM 10403.3 Table 3.5-82
+const SEMP_RTCM_FIELD sempRtcmMsm5Signal[] =
+{
+    SEMP_RTCM_CELL_FIELD(15, true,  finePseudorange),       // DF400
+    SEMP_RTCM_CELL_FIELD(22, true,  finePhaseRange),        // DF401
+    SEMP_RTCM_CELL_FIELD( 4, false, lockTime),              // DF402
+    SEMP_RTCM_CELL_FIELD( 1, false, halfCycle),             // DF420
+    SEMP_RTCM_CELL_FIELD( 6, false, cnr),                   // DF403
+    SEMP_RTCM_CELL_FIELD(15, true,  finePhaseRangeRate),    // DF404
+};
+
+// MSM6 signal data, RTCM 10403.3 Table 3.5-84
+const SEMP_RTCM_FIELD sempRtcmMsm6Signal[] =
+{
+    SEMP_RTCM_CELL_FIELD(20, true,  finePseudorange),       // DF405
+    SEMP_RTCM_CELL_FIELD(24, true,  finePhaseRange),        // DF406
+    SEMP_RTCM_CELL_FIELD(10, false, lockTime),              // DF407
+    SEMP_RTCM_CELL_FIELD( 1, false, halfCycle),             // DF420
+    SEMP_RTCM_CELL_FIELD(10, false, cnr),                   // DF408
+};
+
+// MSM7 signal data, RTCM 10403.3 Table 3.5-86
+const SEMP_RTCM_FIELD sempRtcmMsm7Signal[] =
+{
+    SEMP_RTCM_CELL_FIELD(20, true,  finePseudorange),       // DF405
+    SEMP_RTCM_CELL_FIELD(24, true,  finePhaseRange),        // DF406
+    SEMP_RTCM_CELL_FIELD(10, false, lockTime),              // DF407
+    SEMP_RTCM_CELL_FIELD( 1, false, halfCycle),             // DF420
+    SEMP_RTCM_CELL_FIELD(10, false, cnr),                   // DF408
+    SEMP_RTCM_CELL_FIELD(15, true,  finePhaseRangeRate),    // DF404
+};
+
+// Describe the data fields of a MSM type
+typedef struct _SEMP_RTCM_MSM_LAYOUT
+{
+    const SEMP_RTCM_FIELD *satellite;
+    uint8_t satelliteFields;
+    const SEMP_RTCM_FIELD *signal;
+    uint8_t signalFields;
+} SEMP_RTCM_MSM_LAYOUT;
+
+// MSM4 - MSM7 data layouts, indexed by msmType - 4
+const SEMP_RTCM_MSM_LAYOUT sempRtcmMsmLayouts[] =
+{
+    {sempRtcmMsm46Satellite, sizeof(sempRtcmMsm46Satellite) / sizeof(SEMP_RTCM_FIELD),
+     sempRtcmMsm4Signal, sizeof(sempRtcmMsm4Signal) / sizeof(SEMP_RTCM_FIELD)},
+    {sempRtcmMsm57Satellite, sizeof(sempRtcmMsm57Satellite) / sizeof(SEMP_RTCM_FIELD),
+     sempRtcmMsm5Signal, sizeof(sempRtcmMsm5Signal) / sizeof(SEMP_RTCM_FIELD)},
+    {sempRtcmMsm46Satellite, sizeof(sempRtcmMsm46Satellite) / sizeof(SEMP_RTCM_FIELD),
+     sempRtcmMsm6Signal, sizeof(sempRtcmMsm6Signal) / sizeof(SEMP_RTCM_FIELD)},
+    {sempRtcmMsm57Satellite, sizeof(sempRtcmMsm57Satellite) / sizeof(SEMP_RTCM_FIELD),
+     sempRtcmMsm7Signal, sizeof(sempRtcmMsm7Signal) / sizeof(SEMP_RTCM_FIELD)},
+};
+
+// Prepare to read the bit fields of a payload
+void sempRtcmBitReaderInit(SEMP_RTCM_BIT_READER *reader,
+                           const uint8_t *payload,
+                           size_t length)
+{
+    reader->data = payload;
+    reader->end = payload + length;
+    reader->bits = 0;
+    reader->count = 0;
+    reader->overrun = false;
+}
+
+// Load at least SEMP_RTCM_MAX_FIELD_BITS bits into the bit buffer when
+// the payload has the data
+void sempRtcmRefill(SEMP_RTCM_BIT_READER *reader)
+{
+    int bytes;
+
+    // Load 64 bits at once, keeping the whole bytes.  The bits of a partial
+    // byte are loaded again by the next refill at the same position.
+    if ((reader->end - reader->data) >= 8)
+    {
+        reader->bits |= sempReadU8Be(reader->data) >> reader->count;
+        bytes = (63 - reader->count) >> 3;
+        reader->data += bytes;
+        reader->count += bytes << 3;
+        return;
+    }
+
+    // Load the last bytes of the payload one at a time
+    while ((reader->count <= (64 - 8)) && (reader->data < reader->end))
+    {
+        reader->bits |= (uint64_t)*reader->data++ << (64 - 8 - reader->count);
+        reader->count += 8;
+    }
+}
+
+// Read an unsigned field of 1 - SEMP_RTCM_MAX_FIELD_BITS bits
+uint64_t sempRtcmGetBits(SEMP_RTCM_BIT_READER *reader, int width)
+{
+    uint64_t value;
+
+    // Make sure the field is in the bit buffer
+    if (reader->count < width)
+    {
+        sempRtcmRefill(reader);
+        if (reader->count < width)
+        {
+            reader->overrun = true;
+            reader->bits = 0;
+            reader->count = 0;
+            return 0;
+        }
+    }
+
+    // Remove the field from the top of the bit buffer
+    value = reader->bits >> (64 - width);
+    reader->bits <<= width;
+    reader->count -= width;
+    return value;
+}
+
+// Read a two's complement field of 1 - SEMP_RTCM_MAX_FIELD_BITS bits
+int64_t sempRtcmGetSignedBits(SEMP_RTCM_BIT_READER *reader, int width)
+{
+    // Place the sign bit in bit 63, then shift it back into place
+    return (int64_t)(sempRtcmGetBits(reader, width) << (64 - width)) >> (64 - width);
+}
+
+// Skip a field of any width
+void sempRtcmSkipBits(SEMP_RTCM_BIT_READER *reader, uint32_t width)
+{
+    while (width > SEMP_RTCM_MAX_FIELD_BITS)
+    {
+        sempRtcmGetBits(reader, SEMP_RTCM_MAX_FIELD_BITS);
+        width -= SEMP_RTCM_MAX_FIELD_BITS;
+    }
+    if (width)
+        sempRtcmGetBits(reader, width);
+}
+
+// Locate the payload of a RTCM message, returns false when the message
+// is shorter than its payload length
+bool sempRtcmGetPayload(SEMP_RTCM_BIT_READER *reader,
+                        const uint8_t *message,
+                        size_t length)
+{
+    size_t payloadLength;
+
+    if ((!message) || (length < 3) || (message[0] != 0xd3))
+        return false;
+    payloadLength = ((message[1] & 3) << 8) | message[2];
+    if (length < (3 + payloadLength))
+        return false;
+    sempRtcmBitReaderInit(reader, &message[3], payloadLength);
+    return true;
+}
+
+// Save a field value in a satellite or cell structure
+void sempRtcmStoreField(uint8_t *base, const SEMP_RTCM_FIELD *field, uint64_t value)
+{
+    switch (field->bytes)
+    {
+    case 1:
+        *(uint8_t *)&base[field->offset] = (uint8_t)value;
+        break;
+    case 2:
+        *(uint16_t *)&base[field->offset] = (uint16_t)value;
+        break;
+    case 4:
+        *(uint32_t *)&base[field->offset] = (uint32_t)value;
+        break;
+    }
+}
+
+// Read the field-major data of the satellites or cells
+void sempRtcmReadMsmFields(SEMP_RTCM_BIT_READER *reader,
+                           const SEMP_RTCM_FIELD *fields,
+                           int fieldCount,
+                           uint8_t *base,
+                           size_t bytes,
+                           int count)
+{
+    const SEMP_RTCM_FIELD *field;
+    int index;
+    uint64_t value;
+
+    // Each field is present for all of the satellites or cells before the
+    // next field starts
+    for (field = fields; field < &fields[fieldCount]; field++)
+    {
+        for (index = 0; index < count; index++)
+        {
+            if (field->isSigned)
+                value = (uint64_t)sempRtcmGetSignedBits(reader, field->width);
+            else
+                value = sempRtcmGetBits(reader, field->width);
+            sempRtcmStoreField(&base[index * bytes], field, value);
+        }
+    }
+}
+
+// Decode a MSM4, MSM5, MSM6 or MSM7 message
+bool sempRtcmDecodeMsm(const uint8_t *message, size_t length, SEMP_RTCM_MSM *msm)
+{
+    int bit;
+    uint64_t cellMask;
+    int cellBits;
+    int cells;
+    const SEMP_RTCM_MSM_LAYOUT *layout;
+    uint16_t messageNumber;
+    SEMP_RTCM_BIT_READER reader;
+    uint64_t satelliteMask;
+    int satellite;
+    uint32_t signalMask;
+    int signal;
+
+    // Verify the message number, MSM messages are 1071 - 1137
+    if (!sempRtcmGetPayload(&reader, message, length))
+        return false;
+    messageNumber = sempRtcmGetBits(&reader, 12);
+    if ((messageNumber < 1071) || (messageNumber > 1137)
+        || ((messageNumber % 10) < 4) || ((messageNumber % 10) > 7))
+        return false;
+    memset(msm, 0, sizeof(*msm));
+    msm->messageNumber = messageNumber;
+    msm->gnss = messageNumber / 10 - 100;
+    msm->msmType = messageNumber % 10;
+    layout = &sempRtcmMsmLayouts[msm->msmType - 4];
+
+    // Read the MSM header, RTCM 10403.3 Table 3.5-78
+    msm->stationId = sempRtcmGetBits(&reader, 12);
+    msm->epochTime = sempRtcmGetBits(&reader, 30);
+    msm->multipleMessage = sempRtcmGetBits(&reader, 1);
+    msm->iods = sempRtcmGetBits(&reader, 3);
+    sempRtcmSkipBits(&reader, 7);
+    msm->clockSteering = sempRtcmGetBits(&reader, 2);
+    msm->externalClock = sempRtcmGetBits(&reader, 2);
+    msm->smoothing = sempRtcmGetBits(&reader, 1);
+    msm->smoothingInterval = sempRtcmGetBits(&reader, 3);
+    satelliteMask = sempRtcmGetBits(&reader, 32) << 32;
+    satelliteMask |= sempRtcmGetBits(&reader, 32);
+    signalMask = sempRtcmGetBits(&reader, 32);
+
+    // Get the satellite and signal IDs from the masks
+    for (bit = 0; bit < SEMP_RTCM_MSM_SATELLITES; bit++)
+        if (satelliteMask & (1ull << (63 - bit)))
+            msm->satellites[msm->satelliteCount++].id = bit + 1;
+    for (bit = 0; bit < SEMP_RTCM_MSM_SIGNALS; bit++)
+        if (signalMask & (1ul << (31 - bit)))
+            msm->signalIds[msm->signalCount++] = bit + 1;
+    cellBits = msm->satelliteCount * msm->signalCount;
+    if (cellBits > SEMP_RTCM_MSM_CELLS)
+        return false;
+
+    // Read the cell mask, satellite-major with a bit for each signal
+    cellMask = 0;
+    if (cellBits > 32)
+    {
+        cellMask = sempRtcmGetBits(&reader, 32) << (cellBits - 32);
+        cellMask |= sempRtcmGetBits(&reader, cellBits - 32);
+    }
+    else if (cellBits)
+        cellMask = sempRtcmGetBits(&reader, cellBits);
+
+    // Assign the cells to the satellites and signals
+    cells = 0;
+    bit = cellBits;
+    for (satellite = 0; satellite < msm->satelliteCount; satellite++)
+    {
+        for (signal = 0; signal < msm->signalCount; signal++)
+        {
+            bit -= 1;
+            if (cellMask & (1ull << bit))
+            {
+                msm->cells[cells].satellite = satellite;
+                msm->cells[cells].signalId = msm->signalIds[signal];
+                cells += 1;
+            }
+        }
+    }
+    msm->cellCount = cells;
+
+    // Read the satellite data and the signal data
+    sempRtcmReadMsmFields(&reader, layout->satellite, layout->satelliteFields,
+                          (uint8_t *)msm->satellites, sizeof(SEMP_RTCM_MSM_SATELLITE),
+                          msm->satelliteCount);
+    sempRtcmReadMsmFields(&reader, layout->signal, layout->signalFields,
+                          (uint8_t *)msm->cells, sizeof(SEMP_RTCM_MSM_CELL),
+                          msm->cellCount);
+    return !reader.overrun;
+}
+
+// Decode a 1005 or 1006 message
+bool sempRtcmDecode1005(const uint8_t *message, size_t length, SEMP_RTCM_1005 *station)
+{
+    SEMP_RTCM_BIT_READER reader;
+
+    // Verify the message number
+    if (!sempRtcmGetPayload(&reader, message, length))
+        return false;
+    memset(station, 0, sizeof(*station));
+    station->messageNumber = sempRtcmGetBits(&reader, 12);
+    if ((station->messageNumber != 1005) && (station->messageNumber != 1006))
+        return false;
+
+    // Read the fields, RTCM 10403.3 Tables 3.5-9 and 3.5-10
+    station->stationId = sempRtcmGetBits(&reader, 12);
+    station->itrfYear = sempRtcmGetBits(&reader, 6);
+    station->gps = sempRtcmGetBits(&reader, 1);
+    station->glonass = sempRtcmGetBits(&reader, 1);
+    station->galileo = sempRtcmGetBits(&reader, 1);
+    station->referenceStation = sempRtcmGetBits(&reader, 1);
+    station->ecefX = sempRtcmGetSignedBits(&reader, 38);
+    station->singleOscillator = sempRtcmGetBits(&reader, 1);
+    sempRtcmSkipBits(&reader, 1);
+    station->ecefY = sempRtcmGetSignedBits(&reader, 38);
+    station->quarterCycle = sempRtcmGetBits(&reader, 2);
+    station->ecefZ = sempRtcmGetSignedBits(&reader, 38);
+    if (station->messageNumber == 1006)
+        station->antennaHeight = sempRtcmGetBits(&reader, 16);
+    return !reader.overrun;
+}
+
+// Read a counted string, keeping the characters that fit in the buffer
+void sempRtcmGetString(SEMP_RTCM_BIT_READER *reader, char *buffer)
+{
+    int count;
+    int index;
+    uint8_t value;
+
+    count = sempRtcmGetBits(reader, 8);
+    for (index = 0; index < count; index++)
+    {
+        value = sempRtcmGetBits(reader, 8);
+        if (index < (SEMP_RTCM_1033_STRING_BYTES - 1))
+            buffer[index] = value;
+    }
+    buffer[SEMP_MIN(count, SEMP_RTCM_1033_STRING_BYTES - 1)] = 0;
+}
+
+// Decode a 1033 message
+bool sempRtcmDecode1033(const uint8_t *message, size_t length, SEMP_RTCM_1033 *descriptors)
+{
+    SEMP_RTCM_BIT_READER reader;
+
+    // Verify the message number
+    if ((!sempRtcmGetPayload(&reader, message, length))
+        || (sempRtcmGetBits(&reader, 12) != 1033))
+        return false;
+
+    // Read the fields, RTCM 10403.3 Table 3.5-24
+    memset(descriptors, 0, sizeof(*descriptors));
+    descriptors->stationId = sempRtcmGetBits(&reader, 12);
+    sempRtcmGetString(&reader, descriptors->antennaDescriptor);
+    descriptors->antennaSetupId = sempRtcmGetBits(&reader, 8);
+    sempRtcmGetString(&reader, descriptors->antennaSerialNumber);
+    sempRtcmGetString(&reader, descriptors->receiverType);
+    sempRtcmGetString(&reader, descriptors->receiverFirmware);
+    sempRtcmGetString(&reader, descriptors->receiverSerialNumber);
+    return !reader.overrun;
+}
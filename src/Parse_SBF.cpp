@@ -21,9 +21,26 @@ License: MIT. Please see LICENSE.md for more details
 // SBF parse routines
 //----------------------------------------
 
+// Consume a run of block bytes
+size_t sempSbfConsumeBytes(SEMP_PARSE_STATE *parse, const uint8_t *data, size_t length)
+{
+    size_t bytes;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
+
+    // Leave the last byte for sempSbfReadBytes
+    if (scratchPad->sbf.bytesRemaining <= 1)
+        return 0;
+
+    // Save the data bytes and update the CRC
+    bytes = sempBufferBytes(parse, data, length, scratchPad->sbf.bytesRemaining - 1);
+    scratchPad->sbf.computedCRC = semp_ccitt_crc_buffer(scratchPad->sbf.computedCRC, data, bytes);
+    scratchPad->sbf.bytesRemaining -= bytes;
+    return bytes;
+}
+
 bool sempSbfReadBytes(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     scratchPad->sbf.computedCRC = semp_ccitt_crc_update(scratchPad->sbf.computedCRC, data);
 
@@ -31,20 +48,24 @@ bool sempSbfReadBytes(SEMP_PARSE_STATE *parse, uint8_t data)
 
     if (scratchPad->sbf.bytesRemaining == 0)
     {
+        parse->consumeBytes = nullptr;
         parse->state = sempFirstByte;
 
         if ((scratchPad->sbf.computedCRC == scratchPad->sbf.expectedCRC)
             || (parse->badCrc && (!parse->badCrc(parse))))
         {
-            parse->eomCallback(parse, parse->type); // Pass parser array index
+            sempDeliverMessage(parse);
         }
         else
         {
-            sempPrintf(parse->printDebug,
-                    "SEMP: %s SBF %d, 0x%04x (%d) bytes, bad CRC",
-                    parse->parserName,
-                    scratchPad->sbf.sbfID,
-                    parse->length, parse->length);
+            sempLogEvent(parse, SEMP_EVENT_BAD_CRC,
+                         scratchPad->sbf.expectedCRC,
+                         scratchPad->sbf.computedCRC);
+            SEMP_DEBUG_PRINTF(parse->printDebug,
+                           "SEMP: %s SBF %d, 0x%04x (%d) bytes, bad CRC",
+                           parse->parserName,
+                           scratchPad->sbf.sbfID,
+                           parse->length, parse->length);
 
             if (scratchPad->sbf.invalidDataCallback)
                 scratchPad->sbf.invalidDataCallback(parse);
@@ -59,7 +80,7 @@ bool sempSbfReadBytes(SEMP_PARSE_STATE *parse, uint8_t data)
 // Check for Length MSB
 bool sempSbfLengthMSB(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     scratchPad->sbf.computedCRC = semp_ccitt_crc_update(scratchPad->sbf.computedCRC, data);
 
@@ -68,14 +89,28 @@ bool sempSbfLengthMSB(SEMP_PARSE_STATE *parse, uint8_t data)
     if (scratchPad->sbf.length % 4 == 0)
     {
         scratchPad->sbf.bytesRemaining = scratchPad->sbf.length - 8; // Subtract 8 header bytes
+
+        // Verify that the rest of the block fits in the buffer
+        if (!sempMessageFits(parse, scratchPad->sbf.bytesRemaining))
+        {
+            parse->state = sempFirstByte;
+            return false;
+        }
+
+        // Skip the rest of the block when rejected by the filter
+        if (sempFilterMessage(parse, scratchPad->sbf.sbfID, scratchPad->sbf.bytesRemaining))
+            return true;
+
+        parse->consumeBytes = sempSbfConsumeBytes;
         parse->state = sempSbfReadBytes;
         return true;
     }
     // else
-    sempPrintf(parse->printDebug,
-            "SEMP: %s SBF, 0x%04x (%d) bytes, length not modulo 4",
-            parse->parserName,
-            parse->length, parse->length);
+    sempLogEvent(parse, SEMP_EVENT_BAD_HEADER, data, 0);
+    SEMP_DEBUG_PRINTF(parse->printDebug,
+                   "SEMP: %s SBF, 0x%04x (%d) bytes, length not modulo 4",
+                   parse->parserName,
+                   parse->length, parse->length);
 
     if (scratchPad->sbf.invalidDataCallback)
         scratchPad->sbf.invalidDataCallback(parse);
@@ -87,7 +122,7 @@ bool sempSbfLengthMSB(SEMP_PARSE_STATE *parse, uint8_t data)
 // Check for Length LSB
 bool sempSbfLengthLSB(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     scratchPad->sbf.computedCRC = semp_ccitt_crc_update(scratchPad->sbf.computedCRC, data);
 
@@ -100,7 +135,7 @@ bool sempSbfLengthLSB(SEMP_PARSE_STATE *parse, uint8_t data)
 // Check for ID byte 2
 bool sempSbfID2(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     scratchPad->sbf.computedCRC = semp_ccitt_crc_update(scratchPad->sbf.computedCRC, data);
 
@@ -115,7 +150,7 @@ bool sempSbfID2(SEMP_PARSE_STATE *parse, uint8_t data)
 // Check for ID byte 1
 bool sempSbfID1(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     scratchPad->sbf.computedCRC = semp_ccitt_crc_update(scratchPad->sbf.computedCRC, data);
 
@@ -128,7 +163,7 @@ bool sempSbfID1(SEMP_PARSE_STATE *parse, uint8_t data)
 // Check for CRC byte 2
 bool sempSbfCRC2(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     scratchPad->sbf.expectedCRC |= ((uint16_t)data) << 8;
     scratchPad->sbf.computedCRC = 0;
@@ -140,7 +175,7 @@ bool sempSbfCRC2(SEMP_PARSE_STATE *parse, uint8_t data)
 // Check for CRC byte 1
 bool sempSbfCRC1(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     scratchPad->sbf.expectedCRC = data;
 
@@ -157,12 +192,13 @@ bool sempSbfPreamble2(SEMP_PARSE_STATE *parse, uint8_t data)
         return true;
     }
     // else
-    sempPrintf(parse->printDebug,
-            "SEMP: %s SBF, 0x%04x (%d) bytes, invalid preamble2",
-            parse->parserName,
-            parse->length, parse->length);
+    sempLogEvent(parse, SEMP_EVENT_BAD_HEADER, data, 0);
+    SEMP_DEBUG_PRINTF(parse->printDebug,
+                   "SEMP: %s SBF, 0x%04x (%d) bytes, invalid preamble2",
+                   parse->parserName,
+                   parse->length, parse->length);
 
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     if (scratchPad->sbf.invalidDataCallback)
         scratchPad->sbf.invalidDataCallback(parse);
 
@@ -179,135 +215,104 @@ bool sempSbfPreamble(SEMP_PARSE_STATE *parse, uint8_t data)
         return true;
     }
     // else
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     if (scratchPad->sbf.invalidDataCallback)
         scratchPad->sbf.invalidDataCallback(parse);
     return false;
 }
 
+// Name the parser states, the preamble routine is first
+const SEMP_STATE_NAME sempSbfStateNames[] =
+{
+    SEMP_STATE(sempSbfPreamble),
+    SEMP_STATE(sempSbfPreamble2),
+    SEMP_STATE(sempSbfCRC1),
+    SEMP_STATE(sempSbfCRC2),
+    SEMP_STATE(sempSbfID1),
+    SEMP_STATE(sempSbfID2),
+    SEMP_STATE(sempSbfLengthLSB),
+    SEMP_STATE(sempSbfLengthMSB),
+    SEMP_STATE(sempSbfReadBytes),
+};
+
+// State name table, see sempBeginParser
+const SEMP_STATE_TABLE sempSbfStateTable =
+{
+    sempSbfStateNames,
+    sizeof(sempSbfStateNames) / sizeof(SEMP_STATE_NAME)
+};
+
 // Translates state value into an string, returns nullptr if not found
 const char * sempSbfGetStateName(const SEMP_PARSE_STATE *parse)
 {
-    if (parse->state == sempSbfPreamble)
-        return "sempSbfPreamble";
-    if (parse->state == sempSbfPreamble2)
-        return "sempSbfPreamble2";
-    if (parse->state == sempSbfCRC1)
-        return "sempSbfCRC1";
-    if (parse->state == sempSbfCRC2)
-        return "sempSbfCRC2";
-    if (parse->state == sempSbfID1)
-        return "sempSbfID1";
-    if (parse->state == sempSbfID2)
-        return "sempSbfID2";
-    if (parse->state == sempSbfLengthLSB)
-        return "sempSbfLengthLSB";
-    if (parse->state == sempSbfLengthMSB)
-        return "sempSbfLengthMSB";
-    if (parse->state == sempSbfReadBytes)
-        return "sempSbfReadBytes";
-    return nullptr;
+    return sempFindStateName(&sempSbfStateTable, parse->state);
 }
 
 // Set the invalid data callback
 void sempSbfSetInvalidDataCallback(const SEMP_PARSE_STATE *parse, SEMP_INVALID_DATA_CALLBACK invalidDataCallback)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     scratchPad->sbf.invalidDataCallback = invalidDataCallback;
+
+    // The invalid data callback needs to see all of the non-SBF data
+    if (invalidDataCallback)
+        sempPreambleAcceptsAnyByte(parse, sempSbfPreamble);
 }
 
 // Get the Block Number
 uint16_t sempSbfGetBlockNumber(const SEMP_PARSE_STATE *parse)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     return scratchPad->sbf.sbfID;
 }
 
 // Get the Block Revision
 uint8_t sempSbfGetBlockRevision(const SEMP_PARSE_STATE *parse)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     return scratchPad->sbf.sbfIDrev;
 }
 
 // Get data
 uint8_t sempSbfGetU1(const SEMP_PARSE_STATE *parse, uint16_t offset)
 {
-    return parse->buffer[offset];
+    return sempReadU1(&parse->buffer[offset]);
 }
 uint16_t sempSbfGetU2(const SEMP_PARSE_STATE *parse, uint16_t offset)
 {
-    uint16_t data = parse->buffer[offset];
-    data |= ((uint16_t)parse->buffer[offset + 1]) << 8;
-    return data;
+    return sempReadU2Le(&parse->buffer[offset]);
 }
 uint32_t sempSbfGetU4(const SEMP_PARSE_STATE *parse, uint16_t offset)
 {
-    uint32_t data = 0;
-    for (uint16_t i = 0; i < sizeof(data); i++)
-        data |= ((uint32_t)parse->buffer[offset + i]) << (8 * i);
-    return data;
+    return sempReadU4Le(&parse->buffer[offset]);
 }
 uint64_t sempSbfGetU8(const SEMP_PARSE_STATE *parse, uint16_t offset)
 {
-    uint64_t data = 0;
-    for (uint16_t i = 0; i < sizeof(data); i++)
-        data |= ((uint64_t)parse->buffer[offset + i]) << (8 * i);
-    return data;
+    return sempReadU8Le(&parse->buffer[offset]);
 }
 int8_t sempSbfGetI1(const SEMP_PARSE_STATE *parse, uint16_t offset)
 {
-    union {
-        uint8_t unsignedN;
-        int8_t signedN;
-    } unsignedSignedN;
-    unsignedSignedN.unsignedN = sempSbfGetU1(parse, offset);
-    return unsignedSignedN.signedN;
+    return sempReadI1(&parse->buffer[offset]);
 }
 int16_t sempSbfGetI2(const SEMP_PARSE_STATE *parse, uint16_t offset)
 {
-    union {
-        uint16_t unsignedN;
-        int16_t signedN;
-    } unsignedSignedN;
-    unsignedSignedN.unsignedN = sempSbfGetU2(parse, offset);
-    return unsignedSignedN.signedN;
+    return sempReadI2Le(&parse->buffer[offset]);
 }
 int32_t sempSbfGetI4(const SEMP_PARSE_STATE *parse, uint16_t offset)
 {
-    union {
-        uint32_t unsignedN;
-        int32_t signedN;
-    } unsignedSignedN;
-    unsignedSignedN.unsignedN = sempSbfGetU4(parse, offset);
-    return unsignedSignedN.signedN;
+    return sempReadI4Le(&parse->buffer[offset]);
 }
 int64_t sempSbfGetI8(const SEMP_PARSE_STATE *parse, uint16_t offset)
 {
-    union {
-        uint64_t unsignedN;
-        int64_t signedN;
-    } unsignedSignedN;
-    unsignedSignedN.unsignedN = sempSbfGetU8(parse, offset);
-    return unsignedSignedN.signedN;
+    return sempReadI8Le(&parse->buffer[offset]);
 }
 float sempSbfGetF4(const SEMP_PARSE_STATE *parse, uint16_t offset)
 {
-    union {
-        uint32_t unsignedN;
-        float flt;
-    } unsignedFloat;
-    unsignedFloat.unsignedN = sempSbfGetU4(parse, offset);
-    return unsignedFloat.flt;
+    return sempReadF4Le(&parse->buffer[offset]);
 }
 double sempSbfGetF8(const SEMP_PARSE_STATE *parse, uint16_t offset)
 {
-    union {
-        uint64_t unsignedN;
-        double flt;
-    } unsignedFloat;
-    unsignedFloat.unsignedN = sempSbfGetU8(parse, offset);
-    return unsignedFloat.flt;
+    return sempReadF8Le(&parse->buffer[offset]);
 }
 const char *sempSbfGetString(const SEMP_PARSE_STATE *parse, uint16_t offset)
 {
@@ -315,12 +320,12 @@ const char *sempSbfGetString(const SEMP_PARSE_STATE *parse, uint16_t offset)
 }
 bool sempSbfIsEncapsulatedNMEA(const SEMP_PARSE_STATE *parse)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     return ((scratchPad->sbf.sbfID == 4097) && (parse->buffer[14] == 4));
 }
 bool sempSbfIsEncapsulatedRTCMv3(const SEMP_PARSE_STATE *parse)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     return ((scratchPad->sbf.sbfID == 4097) && (parse->buffer[14] == 2));
 }
 uint16_t sempSbfGetEncapsulatedPayloadLength(const SEMP_PARSE_STATE *parse)
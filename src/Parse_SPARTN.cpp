@@ -17,76 +17,98 @@ License: MIT. Please see LICENSE.md for more details
 #include "SparkFun_Extensible_Message_Parser.h"
 #include "semp_crc_spartn.h" // 4/8/16/24/32-bit cyclic redundancy checksums for SPARTN parsing
 
+//----------------------------------------
+// Support routines
+//----------------------------------------
+
+// Update the CRC-8 with a message byte
+uint32_t sempSpartnComputeCrc8(SEMP_PARSE_STATE *parse, uint8_t data)
+{
+    return semp_u8Crc8Table[data ^ (parse->crc & 0xff)];
+}
+
+// Update the CRC-16 with a message byte
+uint32_t sempSpartnComputeCrc16(SEMP_PARSE_STATE *parse, uint8_t data)
+{
+    uint32_t crc = parse->crc;
+    crc = semp_u16Crc16Table[data ^ ((crc >> 8) & 0xff)] ^ (crc << 8);
+    return crc & 0x0000ffff;
+}
+
+// Update the CRC-24 with a message byte
+uint32_t sempSpartnComputeCrc24(SEMP_PARSE_STATE *parse, uint8_t data)
+{
+    uint32_t crc = parse->crc;
+    crc = semp_u32Crc24Table[data ^ ((crc >> 16) & 0xff)] ^ (crc << 8);
+    return crc & 0x00ffffff;
+}
+
+// Update the CRC-32 with a message byte
+uint32_t sempSpartnComputeCrc32(SEMP_PARSE_STATE *parse, uint8_t data)
+{
+    uint32_t crc = parse->crc;
+    return semp_u32Crc32Table[data ^ (crc >> 24)] ^ (crc << 8);
+}
+
+// Update the CRC with a run of message bytes
+uint32_t sempSpartnCrcBuffer(SEMP_PARSE_STATE *parse, const uint8_t *data, size_t length)
+{
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
+
+    switch (scratchPad->spartn.crcType)
+    {
+    case 0:
+        return semp_uSpartnCrc8Buffer(parse->crc, data, length);
+    case 1:
+        return semp_uSpartnCrc16Buffer(parse->crc, data, length);
+    case 2:
+        return semp_uSpartnCrc24Buffer(parse->crc, data, length);
+    default:
+        return semp_uSpartnCrc32Buffer(parse->crc, data, length);
+    }
+}
+
 //----------------------------------------
 // SPARTN parse routines
 //----------------------------------------
 
+// Read the CRC
 bool sempSpartnReadTF018(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     scratchPad->spartn.frameCount++;
     if (scratchPad->spartn.frameCount == scratchPad->spartn.crcBytes)
     {
         uint16_t numBytes = 4 + scratchPad->spartn.TF007toTF016 + scratchPad->spartn.payloadLength + scratchPad->spartn.embeddedApplicationLengthBytes;
         uint8_t *ptr = &parse->buffer[numBytes];
+        uint32_t expected;
         bool valid;
-        switch (scratchPad->spartn.crcType)
-        {
-        case 0:
-        {
-            uint8_t expected = *ptr;
-            // Don't include the preamble in the CRC
-            valid =  ((semp_uSpartnCrc8(&parse->buffer[1], numBytes - 1) == expected)
-                      || (parse->badCrc && (!parse->badCrc(parse))));
-        }
-        break;
-        case 1:
-        {
-            uint16_t expected = *ptr++;
-            expected <<= 8;
-            expected |= *ptr;
-            // Don't include the preamble in the CRC
-            valid =  ((semp_uSpartnCrc16(&parse->buffer[1], numBytes - 1) == expected)
-                      || (parse->badCrc && (!parse->badCrc(parse))));
-        }
-        break;
-        case 2:
-        {
-            uint32_t expected = *ptr++;
-            expected <<= 8;
-            expected |= *ptr++;
-            expected <<= 8;
-            expected |= *ptr;
-            // Don't include the preamble in the CRC
-            valid =  ((semp_uSpartnCrc24(&parse->buffer[1], numBytes - 1) == expected)
-                      || (parse->badCrc && (!parse->badCrc(parse))));
-        }
-        break;
-        default:
-        {
-            uint32_t expected = *ptr++;
-            expected <<= 8;
-            expected |= *ptr++;
-            expected <<= 8;
-            expected |= *ptr++;
-            expected <<= 8;
-            expected |= *ptr;
-            // Don't include the preamble in the CRC
-            valid =  ((semp_uSpartnCrc32(&parse->buffer[1], numBytes - 1) == expected)
-                      || (parse->badCrc && (!parse->badCrc(parse))));
-        }
-        break;
-        }
+
+        // Get the CRC from the message, most significant byte first
+        expected = 0;
+        for (uint16_t index = 0; index < scratchPad->spartn.crcBytes; index++)
+            expected = (expected << 8) | *ptr++;
+
+        // The CRC-32 includes a final XOR
+        if (scratchPad->spartn.crcType > 2)
+            parse->crc ^= 0xFFFFFFFFU;
+
+        // The CRC was computed as the bytes arrived, excluding the preamble
+        valid =  ((parse->crc == expected)
+                  || (parse->badCrc && (!parse->badCrc(parse))));
         if (valid)
-            parse->eomCallback(parse, parse->type); // Pass parser array index
+            sempDeliverMessage(parse);
         else
-            sempPrintf(parse->printDebug,
-                    "SEMP: %s SPARTN %d %d, 0x%04x (%d) bytes, bad CRC",
-                    parse->parserName,
-                    scratchPad->spartn.messageType,
-                    scratchPad->spartn.messageSubtype,
-                    parse->length, parse->length);
+        {
+            sempLogEvent(parse, SEMP_EVENT_BAD_CRC, expected, parse->crc);
+            SEMP_DEBUG_PRINTF(parse->printDebug,
+                           "SEMP: %s SPARTN %d %d, 0x%04x (%d) bytes, bad CRC",
+                           parse->parserName,
+                           scratchPad->spartn.messageType,
+                           scratchPad->spartn.messageSubtype,
+                           parse->length, parse->length);
+        }
         parse->state = sempFirstByte;
         return false;
     }
@@ -96,11 +118,14 @@ bool sempSpartnReadTF018(SEMP_PARSE_STATE *parse, uint8_t data)
 
 bool sempSpartnReadTF017(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     scratchPad->spartn.frameCount++;
     if (scratchPad->spartn.frameCount == scratchPad->spartn.embeddedApplicationLengthBytes)
     {
+        // The CRC bytes are not included in the CRC
+        parse->computeCrc = nullptr;
+        parse->consumeBytes = nullptr;
         parse->state = sempSpartnReadTF018;
         scratchPad->spartn.frameCount = 0;
     }
@@ -110,7 +135,7 @@ bool sempSpartnReadTF017(SEMP_PARSE_STATE *parse, uint8_t data)
 
 bool sempSpartnReadTF016(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     scratchPad->spartn.frameCount++;
     if (scratchPad->spartn.frameCount == scratchPad->spartn.payloadLength)
@@ -122,6 +147,9 @@ bool sempSpartnReadTF016(SEMP_PARSE_STATE *parse, uint8_t data)
         }
         else
         {
+            // The CRC bytes are not included in the CRC
+            parse->computeCrc = nullptr;
+            parse->consumeBytes = nullptr;
             parse->state = sempSpartnReadTF018;
             scratchPad->spartn.frameCount = 0;
         }
@@ -130,9 +158,34 @@ bool sempSpartnReadTF016(SEMP_PARSE_STATE *parse, uint8_t data)
     return true;
 }
 
+// Consume a run of payload or embedded application bytes
+size_t sempSpartnConsumeBytes(SEMP_PARSE_STATE *parse, const uint8_t *data, size_t length)
+{
+    size_t bytes;
+    uint16_t fieldLength;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
+
+    // Determine the length of the current field
+    if (parse->state == sempSpartnReadTF016)
+        fieldLength = scratchPad->spartn.payloadLength;
+    else
+        fieldLength = scratchPad->spartn.embeddedApplicationLengthBytes;
+
+    // Leave the last byte of the field for the state routine
+    if ((scratchPad->spartn.frameCount + 1) >= fieldLength)
+        return 0;
+
+    // Save the data bytes and update the CRC
+    bytes = sempBufferBytes(parse, data, length,
+                            fieldLength - scratchPad->spartn.frameCount - 1);
+    parse->crc = sempSpartnCrcBuffer(parse, data, bytes);
+    scratchPad->spartn.frameCount += bytes;
+    return bytes;
+}
+
 bool sempSpartnReadTF009(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     scratchPad->spartn.frameCount++;
     if (scratchPad->spartn.frameCount == scratchPad->spartn.TF007toTF016)
@@ -169,7 +222,23 @@ bool sempSpartnReadTF009(SEMP_PARSE_STATE *parse, uint8_t data)
                 }
             }
         }
+
+        // Verify that the payload, embedded application data and CRC fit
+        // in the buffer
+        if (!sempMessageFits(parse, scratchPad->spartn.payloadLength
+                                    + scratchPad->spartn.embeddedApplicationLengthBytes
+                                    + scratchPad->spartn.crcBytes))
+            return sempFirstByte(parse, data);
+
+        // Skip the payload, embedded application data and CRC when
+        // rejected by the filter
+        if (sempFilterMessage(parse, scratchPad->spartn.messageType,
+                              scratchPad->spartn.payloadLength
+                              + scratchPad->spartn.embeddedApplicationLengthBytes
+                              + scratchPad->spartn.crcBytes))
+            return true;
         scratchPad->spartn.frameCount = 0;
+        parse->consumeBytes = sempSpartnConsumeBytes;
         parse->state = sempSpartnReadTF016;
     }
 
@@ -178,7 +247,7 @@ bool sempSpartnReadTF009(SEMP_PARSE_STATE *parse, uint8_t data)
 
 bool sempSpartnReadTF007(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     scratchPad->spartn.messageSubtype = data >> 4;
     scratchPad->spartn.timeTagType = (data >> 3) & 0x01;
@@ -197,7 +266,8 @@ bool sempSpartnReadTF007(SEMP_PARSE_STATE *parse, uint8_t data)
 
 bool sempSpartnReadTF002TF006(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
+    uint8_t crc;
 
     if (scratchPad->spartn.frameCount == 0)
     {
@@ -231,23 +301,45 @@ bool sempSpartnReadTF002TF006(SEMP_PARSE_STATE *parse, uint8_t data)
             break;
         }
         scratchPad->spartn.frameCRC = data & 0x0F;
-        parse->buffer[3] = parse->buffer[3] & 0xF0; // Zero the 4 LSBs before calculating the CRC
-        if (semp_uSpartnCrc4(&parse->buffer[1], 3) == scratchPad->spartn.frameCRC)
+
+        // Compute the header CRC with the 4 LSBs of this byte set to zero
+        crc = semp_uSpartnCrc4(&parse->buffer[1], 2);
+        crc = semp_u8Crc4Table[(data & 0xF0) ^ crc];
+        if (crc == scratchPad->spartn.frameCRC)
         {
-            parse->buffer[3] = data; // Restore TF005 and TF006 now we know the data is valid
+            // Start the message CRC, don't include the preamble
+            switch (scratchPad->spartn.crcType)
+            {
+            case 0:
+                parse->crc = semp_uSpartnCrc8Buffer(0, &parse->buffer[1], 3);
+                parse->computeCrc = sempSpartnComputeCrc8;
+                break;
+            case 1:
+                parse->crc = semp_uSpartnCrc16Buffer(0, &parse->buffer[1], 3);
+                parse->computeCrc = sempSpartnComputeCrc16;
+                break;
+            case 2:
+                parse->crc = semp_uSpartnCrc24Buffer(0, &parse->buffer[1], 3);
+                parse->computeCrc = sempSpartnComputeCrc24;
+                break;
+            default:
+                parse->crc = semp_uSpartnCrc32Buffer(0xFFFFFFFFU, &parse->buffer[1], 3);
+                parse->computeCrc = sempSpartnComputeCrc32;
+                break;
+            }
             parse->state = sempSpartnReadTF007;
         }
         else
         {
             // Invalid header CRC
-            parse->buffer[3] = data; // Restore the byte now we know the data is invalid
             parse->state = sempFirstByte;
 
-            sempPrintf(parse->printDebug,
-                    "SEMP: %s SPARTN %d, 0x%04x (%d) bytes, bad header CRC",
-                    parse->parserName,
-                    scratchPad->spartn.messageType,
-                    parse->length, parse->length);
+            sempLogEvent(parse, SEMP_EVENT_BAD_HEADER, scratchPad->spartn.frameCRC, crc);
+            SEMP_DEBUG_PRINTF(parse->printDebug,
+                           "SEMP: %s SPARTN %d, 0x%04x (%d) bytes, bad header CRC",
+                           parse->parserName,
+                           scratchPad->spartn.messageType,
+                           parse->length, parse->length);
 
             return false;
         }
@@ -260,7 +352,7 @@ bool sempSpartnReadTF002TF006(SEMP_PARSE_STATE *parse, uint8_t data)
 // Check for the preamble
 bool sempSpartnPreamble(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     if (data == 0x73)
     {
@@ -271,29 +363,34 @@ bool sempSpartnPreamble(SEMP_PARSE_STATE *parse, uint8_t data)
     return false;
 }
 
+// Name the parser states, the preamble routine is first
+const SEMP_STATE_NAME sempSpartnStateNames[] =
+{
+    SEMP_STATE(sempSpartnPreamble),
+    SEMP_STATE(sempSpartnReadTF002TF006),
+    SEMP_STATE(sempSpartnReadTF007),
+    SEMP_STATE(sempSpartnReadTF009),
+    SEMP_STATE(sempSpartnReadTF016),
+    SEMP_STATE(sempSpartnReadTF017),
+    SEMP_STATE(sempSpartnReadTF018),
+};
+
+// State name table, see sempBeginParser
+const SEMP_STATE_TABLE sempSpartnStateTable =
+{
+    sempSpartnStateNames,
+    sizeof(sempSpartnStateNames) / sizeof(SEMP_STATE_NAME)
+};
+
 // Translates state value into an string, returns nullptr if not found
 const char * sempSpartnGetStateName(const SEMP_PARSE_STATE *parse)
 {
-    if (parse->state == sempSpartnPreamble)
-        return "sempSpartnPreamble";
-    if (parse->state == sempSpartnReadTF002TF006)
-        return "sempSpartnReadTF002TF006";
-    if (parse->state == sempSpartnReadTF007)
-        return "sempSpartnReadTF007";
-    if (parse->state == sempSpartnReadTF009)
-        return "sempSpartnReadTF009";
-    if (parse->state == sempSpartnReadTF016)
-        return "sempSpartnReadTF016";
-    if (parse->state == sempSpartnReadTF017)
-        return "sempSpartnReadTF017";
-    if (parse->state == sempSpartnReadTF018)
-        return "sempSpartnReadTF018";
-    return nullptr;
+    return sempFindStateName(&sempSpartnStateTable, parse->state);
 }
 
 // Get the message number
 uint8_t sempSpartnGetMessageType(const SEMP_PARSE_STATE *parse)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     return scratchPad->spartn.messageType;
 }
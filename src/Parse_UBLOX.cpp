@@ -45,7 +45,7 @@ License: MIT. Please see LICENSE.md for more details
 bool sempUbloxCkB(SEMP_PARSE_STATE *parse, uint8_t data)
 {
     bool badChecksum;
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     // Validate the checksum
     badChecksum =
@@ -53,16 +53,22 @@ bool sempUbloxCkB(SEMP_PARSE_STATE *parse, uint8_t data)
 
     // Process this message if checksum is valid
     if ((badChecksum == false) || (parse->badCrc && (!parse->badCrc(parse))))
-        parse->eomCallback(parse, parse->type); // Pass parser array index
+        sempDeliverMessage(parse);
     else
-        sempPrintf(parse->printDebug,
-                   "SEMP %s: UBLOX bad checksum received 0x%02x%02x computed 0x%02x%02x",
-                   parse->parserName,
-                   parse->buffer[parse->length - 2], parse->buffer[parse->length - 1],
-                   scratchPad->ublox.ck_a, scratchPad->ublox.ck_b);
-
-    // Search for the next preamble byte
-    parse->length = 0;
+    {
+        sempLogEvent(parse, SEMP_EVENT_BAD_CRC,
+                     (parse->buffer[parse->length - 2] << 8) | parse->buffer[parse->length - 1],
+                     (scratchPad->ublox.ck_a << 8) | scratchPad->ublox.ck_b);
+        SEMP_DEBUG_PRINTF(parse->printDebug,
+                          "SEMP %s: UBLOX bad checksum received 0x%02x%02x computed 0x%02x%02x",
+                          parse->parserName,
+                          parse->buffer[parse->length - 2], parse->buffer[parse->length - 1],
+                          scratchPad->ublox.ck_a, scratchPad->ublox.ck_b);
+    }
+
+    // Search for the next preamble byte, keep the failed message for resync
+    if (!(parse->resync && parse->messageStarted))
+        parse->length = 0;
     parse->state = sempFirstByte;
     return false;
 }
@@ -70,14 +76,42 @@ bool sempUbloxCkB(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the CK_A byte
 bool sempUbloxCkA(SEMP_PARSE_STATE *parse, uint8_t data)
 {
+    parse->consumeBytes = nullptr;
     parse->state = sempUbloxCkB;
     return true;
 }
 
+// Consume a run of payload bytes
+size_t sempUbloxConsumeBytes(SEMP_PARSE_STATE *parse, const uint8_t *data, size_t length)
+{
+    unsigned int ckA;
+    unsigned int ckB;
+    size_t bytes;
+    const uint8_t *end;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
+
+    // Save the payload bytes
+    bytes = sempBufferBytes(parse, data, length, scratchPad->ublox.bytesRemaining);
+    scratchPad->ublox.bytesRemaining -= bytes;
+
+    // Calculate the checksum, the 8-bit values are truncated at the end
+    ckA = scratchPad->ublox.ck_a;
+    ckB = scratchPad->ublox.ck_b;
+    end = &data[bytes];
+    while (data < end)
+    {
+        ckA += *data++;
+        ckB += ckA;
+    }
+    scratchPad->ublox.ck_a = ckA;
+    scratchPad->ublox.ck_b = ckB;
+    return bytes;
+}
+
 // Read the payload
 bool sempUbloxPayload(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     // Compute the checksum over the payload
     if (scratchPad->ublox.bytesRemaining--)
@@ -93,7 +127,7 @@ bool sempUbloxPayload(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the second length byte
 bool sempUbloxLength2(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     // Calculate the checksum
     scratchPad->ublox.ck_a += data;
@@ -101,6 +135,16 @@ bool sempUbloxLength2(SEMP_PARSE_STATE *parse, uint8_t data)
 
     // Save the second length byte
     scratchPad->ublox.bytesRemaining |= ((uint16_t)data) << 8;
+
+    // Verify that the payload and checksum fit in the buffer
+    if (!sempMessageFits(parse, scratchPad->ublox.bytesRemaining + 2))
+        return sempFirstByte(parse, data);
+
+    // Skip the payload and checksum when rejected by the filter
+    if (sempFilterMessage(parse, scratchPad->ublox.message,
+                          scratchPad->ublox.bytesRemaining + 2))
+        return true;
+    parse->consumeBytes = sempUbloxConsumeBytes;
     parse->state = sempUbloxPayload;
     return true;
 }
@@ -108,7 +152,7 @@ bool sempUbloxLength2(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the first length byte
 bool sempUbloxLength1(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     // Calculate the checksum
     scratchPad->ublox.ck_a += data;
@@ -123,7 +167,7 @@ bool sempUbloxLength1(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the ID byte
 bool sempUbloxId(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     // Calculate the checksum
     scratchPad->ublox.ck_a += data;
@@ -138,7 +182,7 @@ bool sempUbloxId(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the class byte
 bool sempUbloxClass(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     // Start the checksum calculation
     scratchPad->ublox.ck_a = data;
@@ -157,9 +201,10 @@ bool sempUbloxSync2(SEMP_PARSE_STATE *parse, uint8_t data)
     if (data != 0x62)
     {
         // Display the invalid data
-        sempPrintf(parse->printDebug,
-                   "SEMP %s: UBLOX invalid second sync byte",
-                   parse->parserName);
+        sempLogEvent(parse, SEMP_EVENT_BAD_HEADER, data, 0);
+        SEMP_DEBUG_PRINTF(parse->printDebug,
+                          "SEMP %s: UBLOX invalid second sync byte",
+                          parse->parserName);
 
         // Invalid sync 2 byte, start searching for a preamble byte
         return sempFirstByte(parse, data);
@@ -178,33 +223,36 @@ bool sempUbloxPreamble(SEMP_PARSE_STATE *parse, uint8_t data)
     return true;
 }
 
+// Name the parser states, the preamble routine is first
+const SEMP_STATE_NAME sempUbloxStateNames[] =
+{
+    SEMP_STATE(sempUbloxPreamble),
+    SEMP_STATE(sempUbloxSync2),
+    SEMP_STATE(sempUbloxClass),
+    SEMP_STATE(sempUbloxId),
+    SEMP_STATE(sempUbloxLength1),
+    SEMP_STATE(sempUbloxLength2),
+    SEMP_STATE(sempUbloxPayload),
+    SEMP_STATE(sempUbloxCkA),
+    SEMP_STATE(sempUbloxCkB),
+};
+
+// State name table, see sempBeginParser
+const SEMP_STATE_TABLE sempUbloxStateTable =
+{
+    sempUbloxStateNames,
+    sizeof(sempUbloxStateNames) / sizeof(SEMP_STATE_NAME)
+};
+
 // Translates state value into an string, returns nullptr if not found
 const char * sempUbloxGetStateName(const SEMP_PARSE_STATE *parse)
 {
-    if (parse->state == sempUbloxPreamble)
-        return "sempUbloxPreamble";
-    if (parse->state == sempUbloxSync2)
-        return "sempUbloxSync2";
-    if (parse->state == sempUbloxClass)
-        return "sempUbloxClass";
-    if (parse->state == sempUbloxId)
-        return "sempUbloxId";
-    if (parse->state == sempUbloxLength1)
-        return "sempUbloxLength1";
-    if (parse->state == sempUbloxLength2)
-        return "sempUbloxLength2";
-    if (parse->state == sempUbloxPayload)
-        return "sempUbloxPayload";
-    if (parse->state == sempUbloxCkA)
-        return "sempUbloxCkA";
-    if (parse->state == sempUbloxCkB)
-        return "sempUbloxCkB";
-    return nullptr;
+    return sempFindStateName(&sempUbloxStateTable, parse->state);
 }
 
 // Get the message number
 uint16_t sempUbloxGetMessageNumber(const SEMP_PARSE_STATE *parse)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     return scratchPad->ublox.message;
 }
@@ -13,7 +13,9 @@ should need to be listed in SparkFun_Extensible_Message_Parser.h.
 License: MIT. Please see LICENSE.md for more details
 ------------------------------------------------------------------------------*/
 
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 #include "SparkFun_Extensible_Message_Parser.h"
 
 //----------------------------------------
@@ -33,13 +35,16 @@ uint32_t sempUnicoreBinaryComputeCrc(SEMP_PARSE_STATE *parse, uint8_t data)
 // Print the Unicore message header
 void sempUnicoreBinaryPrintHeader(SEMP_PARSE_STATE *parse)
 {
+    SEMP_UNICORE_HEADER headerData;
     SEMP_UNICORE_HEADER * header;
 
     Print *print = parse->printError;
     if (print)
     {
+        // The message may not be aligned when parsed in place
         sempPrintln(print, "Unicore Message Header");
-        header = (SEMP_UNICORE_HEADER *)parse->buffer;
+        memcpy(&headerData, parse->buffer, sizeof(headerData));
+        header = &headerData;
         sempPrintf(print, "      0x%02x: Sync A", header->syncA);
         sempPrintf(print, "      0x%02x: Sync B", header->syncB);
         sempPrintf(print, "      0x%02x: Sync C", header->syncC);
@@ -78,7 +83,7 @@ void sempUnicoreBinaryPrintHeader(SEMP_PARSE_STATE *parse)
 // Read the CRC
 bool sempUnicoreBinaryReadCrc(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     // Determine if the entire message was read
     if (--scratchPad->unicoreBinary.bytesRemaining)
@@ -87,21 +92,27 @@ bool sempUnicoreBinaryReadCrc(SEMP_PARSE_STATE *parse, uint8_t data)
 
     // Call the end-of-message routine with this message
     if ((!parse->crc) || (parse->badCrc && (!parse->badCrc(parse))))
-        parse->eomCallback(parse, parse->type); // Pass parser array index
+        sempDeliverMessage(parse);
     else
     {
-        sempPrintf(parse->printDebug,
-                   "SEMP: %s Unicore, bad CRC, "
-                   "received %02x %02x %02x %02x, computed: %02x %02x %02x %02x",
-                   parse->parserName,
-                   parse->buffer[parse->length - 4],
-                   parse->buffer[parse->length - 3],
-                   parse->buffer[parse->length - 2],
-                   parse->buffer[parse->length - 1],
-                   scratchPad->unicoreBinary.crc & 0xff,
-                   (scratchPad->unicoreBinary.crc >> 8) & 0xff,
-                   (scratchPad->unicoreBinary.crc >> 16) & 0xff,
-                   (scratchPad->unicoreBinary.crc >> 24) & 0xff);
+        sempLogEvent(parse, SEMP_EVENT_BAD_CRC,
+                     parse->buffer[parse->length - 4]
+                     | (parse->buffer[parse->length - 3] << 8)
+                     | (parse->buffer[parse->length - 2] << 16)
+                     | ((uint32_t)parse->buffer[parse->length - 1] << 24),
+                     scratchPad->unicoreBinary.crc);
+        SEMP_DEBUG_PRINTF(parse->printDebug,
+                          "SEMP: %s Unicore, bad CRC, "
+                          "received %02x %02x %02x %02x, computed: %02x %02x %02x %02x",
+                          parse->parserName,
+                          parse->buffer[parse->length - 4],
+                          parse->buffer[parse->length - 3],
+                          parse->buffer[parse->length - 2],
+                          parse->buffer[parse->length - 1],
+                          scratchPad->unicoreBinary.crc & 0xff,
+                          (scratchPad->unicoreBinary.crc >> 8) & 0xff,
+                          (scratchPad->unicoreBinary.crc >> 16) & 0xff,
+                          (scratchPad->unicoreBinary.crc >> 24) & 0xff);
     }
     parse->state = sempFirstByte;
     return false;
@@ -110,7 +121,7 @@ bool sempUnicoreBinaryReadCrc(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the message data
 bool sempUnicoreBinaryReadData(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     // Determine if the entire message was read
     if (!--scratchPad->unicoreBinary.bytesRemaining)
@@ -118,6 +129,7 @@ bool sempUnicoreBinaryReadData(SEMP_PARSE_STATE *parse, uint8_t data)
         // The message data is complete, read the CRC
         scratchPad->unicoreBinary.bytesRemaining = 4;
         scratchPad->unicoreBinary.crc = parse->crc;
+        parse->consumeBytes = nullptr;
         parse->state = sempUnicoreBinaryReadCrc;
     }
     return true;
@@ -143,27 +155,72 @@ bool sempUnicoreBinaryReadData(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the header
 bool sempUnicoreBinaryReadHeader(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    uint16_t messageId;
+    uint16_t messageLength;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     if (parse->length >= sizeof(SEMP_UNICORE_HEADER))
     {
-        // The header is complete, read the message data next
-        SEMP_UNICORE_HEADER *header = (SEMP_UNICORE_HEADER *)parse->buffer;
-        scratchPad->unicoreBinary.bytesRemaining = header->messageLength;
+        // The header is complete, read the message data next.  The message
+        // may not be aligned when parsed in place, read the fields by byte
+        messageId = sempReadU2Le(&parse->buffer[offsetof(SEMP_UNICORE_HEADER, messageId)]);
+        messageLength = sempReadU2Le(&parse->buffer[offsetof(SEMP_UNICORE_HEADER, messageLength)]);
+        scratchPad->unicoreBinary.bytesRemaining = messageLength;
+
+        // Verify that the message data and CRC fit in the buffer
+        if (!sempMessageFits(parse, messageLength + 4))
+            return sempFirstByte(parse, data);
+
+        // Skip the message data and CRC when rejected by the filter
+        if (sempFilterMessage(parse, messageId, messageLength + 4))
+            return true;
         parse->state = sempUnicoreBinaryReadData;
     }
     return true;
 }
 
+// Consume a run of header or message data bytes
+size_t sempUnicoreBinaryConsumeBytes(SEMP_PARSE_STATE *parse, const uint8_t *data, size_t length)
+{
+    size_t bytes;
+    size_t maximum;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
+
+    // Leave the last header byte or data byte for the state routine
+    if (parse->state == sempUnicoreBinaryReadHeader)
+    {
+        if ((parse->length + 1) >= sizeof(SEMP_UNICORE_HEADER))
+            return 0;
+        maximum = sizeof(SEMP_UNICORE_HEADER) - 1 - parse->length;
+    }
+    else
+    {
+        if (scratchPad->unicoreBinary.bytesRemaining <= 1)
+            return 0;
+        maximum = scratchPad->unicoreBinary.bytesRemaining - 1;
+    }
+
+    // Save the data bytes and update the CRC
+    bytes = sempBufferBytes(parse, data, length, maximum);
+    parse->crc = semp_crc32Buffer(parse->crc, data, bytes);
+    if (parse->state == sempUnicoreBinaryReadData)
+        scratchPad->unicoreBinary.bytesRemaining -= bytes;
+    return bytes;
+}
+
 // Read the third sync byte
 bool sempUnicoreBinaryBinarySync3(SEMP_PARSE_STATE *parse, uint8_t data)
 {
     // Verify sync byte 3
     if (data != 0xB5)
+    {
         // Invalid sync byte, start searching for a preamble byte
+        sempLogEvent(parse, SEMP_EVENT_BAD_HEADER, data, 0);
         return sempFirstByte(parse, data);
+    }
 
     // Read the header next
+    parse->consumeBytes = sempUnicoreBinaryConsumeBytes;
     parse->state = sempUnicoreBinaryReadHeader;
     return true;
 }
@@ -173,8 +230,11 @@ bool sempUnicoreBinaryBinarySync2(SEMP_PARSE_STATE *parse, uint8_t data)
 {
     // Verify sync byte 2
     if (data != 0x44)
+    {
         // Invalid sync byte, start searching for a preamble byte
+        sempLogEvent(parse, SEMP_EVENT_BAD_HEADER, data, 0);
         return sempFirstByte(parse, data);
+    }
 
     // Look for the last sync byte
     parse->state = sempUnicoreBinaryBinarySync3;
@@ -196,20 +256,26 @@ bool sempUnicoreBinaryPreamble(SEMP_PARSE_STATE *parse, uint8_t data)
     return true;
 }
 
+// Name the parser states, the preamble routine is first
+const SEMP_STATE_NAME sempUnicoreBinaryStateNames[] =
+{
+    SEMP_STATE(sempUnicoreBinaryPreamble),
+    SEMP_STATE(sempUnicoreBinaryBinarySync2),
+    SEMP_STATE(sempUnicoreBinaryBinarySync3),
+    SEMP_STATE(sempUnicoreBinaryReadHeader),
+    SEMP_STATE(sempUnicoreBinaryReadData),
+    SEMP_STATE(sempUnicoreBinaryReadCrc),
+};
+
+// State name table, see sempBeginParser
+const SEMP_STATE_TABLE sempUnicoreBinaryStateTable =
+{
+    sempUnicoreBinaryStateNames,
+    sizeof(sempUnicoreBinaryStateNames) / sizeof(SEMP_STATE_NAME)
+};
+
 // Translates state value into an string, returns nullptr if not found
 const char * sempUnicoreBinaryGetStateName(const SEMP_PARSE_STATE *parse)
 {
-    if (parse->state == sempUnicoreBinaryPreamble)
-        return "sempUnicoreBinaryPreamble";
-    if (parse->state == sempUnicoreBinaryBinarySync2)
-        return "sempUnicoreBinaryBinarySync2";
-    if (parse->state == sempUnicoreBinaryBinarySync3)
-        return "sempUnicoreBinaryBinarySync3";
-    if (parse->state == sempUnicoreBinaryReadHeader)
-        return "sempUnicoreBinaryReadHeader";
-    if (parse->state == sempUnicoreBinaryReadData)
-        return "sempUnicoreBinaryReadData";
-    if (parse->state == sempUnicoreBinaryReadCrc)
-        return "sempUnicoreBinaryReadCrc";
-    return nullptr;
+    return sempFindStateName(&sempUnicoreBinaryStateTable, parse->state);
 }
@@ -23,6 +23,85 @@ License: MIT. Please see LICENSE.md for more details
 // Save room for the carriage return, linefeed and zero termination
 #define UNICORE_HASH_BUFFER_OVERHEAD    (1 + 1 + 1)
 
+// FNV-1a hash of the sentence name
+#define UNICORE_HASH_FNV_BASIS          2166136261u
+#define UNICORE_HASH_FNV_PRIME          16777619u
+
+// Perfect hash of the FNV-1a hash, the multiplier gives each of the names
+// in sempUnicoreHashSentenceNames its own slot
+#define UNICORE_HASH_NAME_SLOT(hash)    ((uint32_t)((hash) * 0x795b929fu) >> 27)
+
+// Sentence names indexed by the sentence ID
+const char * const sempUnicoreHashSentenceNames[SEMP_UNICORE_HASH_ID_COUNT] =
+{
+    "",
+    "ADRNAVA",
+    "AGRICA",
+    "BESTNAVA",
+    "BESTNAVXYZA",
+    "BESTSATA",
+    "MODE",
+    "OBSVMA",
+    "PPPNAVA",
+    "RECTIMEA",
+    "RTKSTATUSA",
+    "SPPNAVA",
+    "STADOPA",
+    "UNIHEADINGA",
+    "VERSION",
+};
+
+// Sentence ID for each of the perfect hash slots
+const uint8_t sempUnicoreHashNameSlots[32] =
+{
+    0,                                  0,
+    SEMP_UNICORE_HASH_ID_VERSION,       0,
+    0,                                  SEMP_UNICORE_HASH_ID_BESTNAVA,
+    SEMP_UNICORE_HASH_ID_ADRNAVA,       SEMP_UNICORE_HASH_ID_AGRICA,
+    SEMP_UNICORE_HASH_ID_MODE,          SEMP_UNICORE_HASH_ID_STADOPA,
+    SEMP_UNICORE_HASH_ID_RECTIMEA,      0,
+    0,                                  0,
+    0,                                  SEMP_UNICORE_HASH_ID_PPPNAVA,
+    0,                                  SEMP_UNICORE_HASH_ID_UNIHEADINGA,
+    SEMP_UNICORE_HASH_ID_BESTSATA,      0,
+    0,                                  0,
+    0,                                  SEMP_UNICORE_HASH_ID_BESTNAVXYZA,
+    0,                                  0,
+    0,                                  SEMP_UNICORE_HASH_ID_RTKSTATUSA,
+    SEMP_UNICORE_HASH_ID_SPPNAVA,       0,
+    SEMP_UNICORE_HASH_ID_OBSVMA,        0,
+};
+
+//----------------------------------------
+// Support routines
+//----------------------------------------
+
+// Classify the sentence name, returns the sentence ID
+uint8_t sempUnicoreHashClassifySentence(const SEMP_UNICORE_HASH_VALUES *unicoreHash)
+{
+    uint8_t id;
+
+    // Look up the name, verifying the slot's name
+    id = sempUnicoreHashNameSlots[UNICORE_HASH_NAME_SLOT(unicoreHash->nameHash)];
+    if (id && (strcmp((const char *)unicoreHash->sentenceName,
+                      sempUnicoreHashSentenceNames[id]) == 0))
+        return id;
+    return SEMP_UNICORE_HASH_ID_UNKNOWN;
+}
+
+// Consume a run of sentence data bytes
+size_t sempUnicoreHashConsumeBytes(SEMP_PARSE_STATE *parse, const uint8_t *data, size_t length)
+{
+    // Leave the byte that does not fit for sempUnicoreHashFindAsterisk
+    if ((parse->length + UNICORE_HASH_BUFFER_OVERHEAD) >= parse->bufferLength)
+        return 0;
+
+    // Index the fields while buffering the sentence data
+    return sempScanSentence(parse, data, length,
+                            parse->bufferLength - UNICORE_HASH_BUFFER_OVERHEAD - parse->length,
+                            &parse->fields);
+}
+
 //----------------------------------------
 // Unicore hash (#) parse routines
 //----------------------------------------
@@ -43,19 +122,19 @@ License: MIT. Please see LICENSE.md for more details
 // One such example is the full version message
 // #VERSION,97,GPS,FINE,2282,248561000,0,0,18,676;UM980,R4.10Build7923,HRPT00-S10C-P,2310415000001-MD22B1224962616,ff3bac96f31f9bdd,2022/09/28*7432d4ed
 // CRC is calculated without the # or * characters
-void sempUnicoreHashValidatCrc(SEMP_PARSE_STATE *parse)
+void sempUnicoreHashValidatCrc(SEMP_PARSE_STATE *parse, uint32_t received)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     uint32_t crc;
     uint32_t crcRx;
+    const uint8_t *asterisk;
     const uint8_t *data;
 
     // Compute the CRC for the message
-    crc = 0;
     data = &parse->buffer[1];    // Skip over the hash '#'
-    do
-        crc = semp_crc32Table[(crc ^ *data) & 0xFF] ^ (crc >> 8);
-    while (*++data != '*');
+    asterisk = (const uint8_t *)memchr(data, '*', parse->length - 1);
+    crc = semp_crc32Buffer(0, data, asterisk - data);
+    data = asterisk;
 
     // Get the received CRC vale
     crcRx = sempAsciiToNibble(*++data) << 28;
@@ -71,12 +150,16 @@ void sempUnicoreHashValidatCrc(SEMP_PARSE_STATE *parse)
     if (crc != crcRx)
     {
         // Display the checksum error
-        sempPrintf(parse->printDebug,
-                   "SEMP: %s Unicore hash (#) %s, 0x%04x (%d) bytes, bad CRC, "
-                   "received 0x%08x, computed: 0x%08x",
-                   parse->parserName,
-                   scratchPad->unicoreHash.sentenceName,
-                   parse->length, parse->length, crcRx, crc);
+        sempLogEvent(parse, SEMP_EVENT_BAD_CRC, crcRx, crc);
+        SEMP_DEBUG_PRINTF(parse->printDebug,
+                          "SEMP: %s Unicore hash (#) %s, 0x%04x (%d) bytes, bad CRC, "
+                          "received 0x%08x, computed: 0x%08x",
+                          parse->parserName,
+                          scratchPad->unicoreHash.sentenceName,
+                          parse->length, parse->length, crcRx, crc);
+
+        // Keep the received bytes in the buffer for resync
+        parse->length = received;
         return;
     }
 
@@ -84,38 +167,41 @@ void sempUnicoreHashValidatCrc(SEMP_PARSE_STATE *parse)
     if ((uint32_t)(parse->length + UNICORE_HASH_BUFFER_OVERHEAD) > parse->bufferLength)
     {
         // Sentence too long
-        sempPrintf(parse->printDebug,
-                   "SEMP %s: Unicore hash (#) sentence too long, increase the buffer size >= %d",
-                   parse->parserName,
-                   parse->length + UNICORE_HASH_BUFFER_OVERHEAD);
+        sempLogEvent(parse, SEMP_EVENT_TOO_LONG, 0, 0);
+        SEMP_DEBUG_PRINTF(parse->printDebug,
+                          "SEMP %s: Unicore hash (#) sentence too long, increase the buffer size >= %d",
+                          parse->parserName,
+                          parse->length + UNICORE_HASH_BUFFER_OVERHEAD);
 
         // Start searching for a preamble byte
+        parse->length = received;
         parse->state = sempFirstByte;
         return;
     }
 
-    // Always add the carriage return and line feed
-    parse->buffer[parse->length++] = '\r';
-    parse->buffer[parse->length++] = '\n';
-
-    // Zero terminate the Unicore hash (#) sentence, don't count this in the length
-    parse->buffer[parse->length] = 0;
+    // Always end the sentence with a carriage return and line feed
+    sempTerminateSentence(parse, received);
 
     // Process this Unicore hash (#) sentence
-    parse->eomCallback(parse, parse->type); // Pass parser array index
+    sempDeliverMessage(parse);
 }
 
 // Validate the checksum
 void sempUnicoreHashValidateChecksum(SEMP_PARSE_STATE *parse)
 {
     uint32_t checksum;
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    uint32_t received;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
+
+    // Remove the received line termination from the length
+    received = parse->length;
+    parse->length = sempSentenceLength(parse);
 
     // Determine if a CRC was used for this message
     if (scratchPad->unicoreHash.checksumBytes > 2)
     {
         // This message is using a CRC instead of a checksum
-        sempUnicoreHashValidatCrc(parse);
+        sempUnicoreHashValidatCrc(parse, received);
         return;
     }
 
@@ -126,35 +212,34 @@ void sempUnicoreHashValidateChecksum(SEMP_PARSE_STATE *parse)
     // Validate the checksum
     if ((checksum == parse->crc) || (parse->badCrc && (!parse->badCrc(parse))))
     {
-        // Always add the carriage return and line feed
-        parse->buffer[parse->length++] = '\r';
-        parse->buffer[parse->length++] = '\n';
-
-        // Zero terminate the Unicore hash (#) sentence, don't count this in the length
-        parse->buffer[parse->length] = 0;
+        // Always end the sentence with a carriage return and line feed
+        sempTerminateSentence(parse, received);
 
         // Process this Unicore hash (#) sentence
-        parse->eomCallback(parse, parse->type); // Pass parser array index
+        sempDeliverMessage(parse);
     }
     else
+    {
         // Display the checksum error
-        sempPrintf(parse->printDebug,
-                   "SEMP: %s Unicore hash (#) %s, 0x%04x (%d) bytes, bad checksum, "
-                   "received 0x%c%c, computed: 0x%02x",
-                   parse->parserName,
-                   scratchPad->unicoreHash.sentenceName,
-                   parse->length, parse->length,
-                   parse->buffer[parse->length - 2],
-                   parse->buffer[parse->length - 1],
-                   parse->crc);
+        sempLogEvent(parse, SEMP_EVENT_BAD_CRC, checksum, parse->crc);
+        SEMP_DEBUG_PRINTF(parse->printDebug,
+                          "SEMP: %s Unicore hash (#) %s, 0x%04x (%d) bytes, bad checksum, "
+                          "received 0x%c%c, computed: 0x%02x",
+                          parse->parserName,
+                          scratchPad->unicoreHash.sentenceName,
+                          parse->length, parse->length,
+                          parse->buffer[parse->length - 2],
+                          parse->buffer[parse->length - 1],
+                          parse->crc);
+
+        // Keep the received bytes in the buffer for resync
+        parse->length = received;
+    }
 }
 
 // Read the linefeed
 bool sempUnicoreHashLineFeed(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    // Don't add the current character to the length
-    parse->length -= 1;
-
     // Process the LF
     if (data == '\n')
     {
@@ -166,6 +251,9 @@ bool sempUnicoreHashLineFeed(SEMP_PARSE_STATE *parse, uint8_t data)
         return true;
     }
 
+    // Don't add the current character to the length
+    parse->length -= 1;
+
     // Pass the sentence to the upper layer
     sempUnicoreHashValidateChecksum(parse);
 
@@ -176,9 +264,6 @@ bool sempUnicoreHashLineFeed(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the remaining carriage return
 bool sempUnicoreHashCarriageReturn(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    // Don't add the current character to the length
-    parse->length -= 1;
-
     // Process the CR
     if (data == '\r')
     {
@@ -190,6 +275,9 @@ bool sempUnicoreHashCarriageReturn(SEMP_PARSE_STATE *parse, uint8_t data)
         return true;
     }
 
+    // Don't add the current character to the length
+    parse->length -= 1;
+
     // Pass the sentence to the upper layer
     sempUnicoreHashValidateChecksum(parse);
 
@@ -197,12 +285,10 @@ bool sempUnicoreHashCarriageReturn(SEMP_PARSE_STATE *parse, uint8_t data)
     return sempFirstByte(parse, data);
 }
 
-// Read the line termination
+// Read the line termination, the received carriage return and line feed
+// remain in the buffer until the checksum is validated
 bool sempUnicoreHashLineTermination(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    // Don't add the current character to the length
-    parse->length -= 1;
-
     // Process the line termination
     if (data == '\r')
     {
@@ -215,6 +301,9 @@ bool sempUnicoreHashLineTermination(SEMP_PARSE_STATE *parse, uint8_t data)
         return true;
     }
 
+    // Don't add the current character to the length
+    parse->length -= 1;
+
     // Pass the sentence to the upper layer
     sempUnicoreHashValidateChecksum(parse);
 
@@ -225,7 +314,7 @@ bool sempUnicoreHashLineTermination(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the checksum bytes
 bool sempUnicoreHashChecksumByte(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
 
     // Account for this checksum character
     scratchPad->unicoreHash.bytesRemaining -= 1;
@@ -234,10 +323,11 @@ bool sempUnicoreHashChecksumByte(SEMP_PARSE_STATE *parse, uint8_t data)
     if (sempAsciiToNibble(parse->buffer[parse->length - 1]) < 0)
     {
         // Invalid checksum character
-        sempPrintf(parse->printDebug,
-                   "SEMP %s: Unicore hash (#) invalid checksum character %d",
-                   parse->parserName,
-                   scratchPad->unicoreHash.checksumBytes - scratchPad->unicoreHash.bytesRemaining);
+        sempLogEvent(parse, SEMP_EVENT_INVALID_DATA, parse->buffer[parse->length - 1], 0);
+        SEMP_DEBUG_PRINTF(parse->printDebug,
+                          "SEMP %s: Unicore hash (#) invalid checksum character %d",
+                          parse->parserName,
+                          scratchPad->unicoreHash.checksumBytes - scratchPad->unicoreHash.bytesRemaining);
 
         // Start searching for a preamble byte
         return sempFirstByte(parse, data);
@@ -252,25 +342,30 @@ bool sempUnicoreHashChecksumByte(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the sentence data
 bool sempUnicoreHashFindAsterisk(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     if (data == '*')
     {
+        parse->fields.end = parse->length - 1;
         scratchPad->unicoreHash.bytesRemaining = scratchPad->unicoreHash.checksumBytes;
+        parse->consumeBytes = nullptr;
         parse->state = sempUnicoreHashChecksumByte;
     }
     else
     {
         // Include this byte in the checksum
         parse->crc ^= data;
+        if ((data == ',') || (data == ';'))
+            sempSentenceAddField(&parse->fields, parse->length);
 
         // Verify that enough space exists in the buffer
         if ((uint32_t)(parse->length + UNICORE_HASH_BUFFER_OVERHEAD) > parse->bufferLength)
         {
             // sentence too long
-            sempPrintf(parse->printDebug,
-                       "SEMP %s: Unicore hash (#) sentence too long, increase the buffer size > %d",
-                       parse->parserName,
-                       parse->bufferLength);
+            sempLogEvent(parse, SEMP_EVENT_TOO_LONG, 0, 0);
+            SEMP_DEBUG_PRINTF(parse->printDebug,
+                              "SEMP %s: Unicore hash (#) sentence too long, increase the buffer size > %d",
+                              parse->parserName,
+                              parse->bufferLength);
 
             // Start searching for a preamble byte
             return sempFirstByte(parse, data);
@@ -282,7 +377,7 @@ bool sempUnicoreHashFindAsterisk(SEMP_PARSE_STATE *parse, uint8_t data)
 // Read the sentence name
 bool sempUnicoreHashFindFirstComma(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     parse->crc ^= data;
     if ((data != ',') || (scratchPad->unicoreHash.sentenceNameLength == 0))
     {
@@ -290,34 +385,51 @@ bool sempUnicoreHashFindFirstComma(SEMP_PARSE_STATE *parse, uint8_t data)
         uint8_t upper = data & ~0x20;
         if (((upper < 'A') || (upper > 'Z')) && ((data < '0') || (data > '9')))
         {
-            sempPrintf(parse->printDebug,
-                       "SEMP %s: Unicore hash (#) invalid sentence name character 0x%02x",
-                       parse->parserName, data);
+            sempLogEvent(parse, SEMP_EVENT_BAD_HEADER, data, 0);
+            SEMP_DEBUG_PRINTF(parse->printDebug,
+                              "SEMP %s: Unicore hash (#) invalid sentence name character 0x%02x",
+                              parse->parserName, data);
             return sempFirstByte(parse, data);
         }
 
         // Name too long, start searching for a preamble byte
         if (scratchPad->unicoreHash.sentenceNameLength == (sizeof(scratchPad->unicoreHash.sentenceName) - 1))
         {
-            sempPrintf(parse->printDebug,
-                       "SEMP %s: Unicore hash (#) sentence name > %ld characters",
-                       parse->parserName,
-                       sizeof(scratchPad->unicoreHash.sentenceName) - 1);
+            sempLogEvent(parse, SEMP_EVENT_BAD_HEADER, data, 0);
+            SEMP_DEBUG_PRINTF(parse->printDebug,
+                              "SEMP %s: Unicore hash (#) sentence name > %ld characters",
+                              parse->parserName,
+                              sizeof(scratchPad->unicoreHash.sentenceName) - 1);
             return sempFirstByte(parse, data);
         }
 
         // Save the sentence name
         scratchPad->unicoreHash.sentenceName[scratchPad->unicoreHash.sentenceNameLength++] = data;
+        scratchPad->unicoreHash.nameHash = (scratchPad->unicoreHash.nameHash ^ data)
+                                         * UNICORE_HASH_FNV_PRIME;
     }
     else
     {
         // Zero terminate the sentence name
         scratchPad->unicoreHash.sentenceName[scratchPad->unicoreHash.sentenceNameLength++] = 0;
 
+        // Classify the sentence
+        scratchPad->unicoreHash.sentenceId = sempUnicoreHashClassifySentence(&scratchPad->unicoreHash);
+
         // Determine the number of checksum bytes
         scratchPad->unicoreHash.checksumBytes = 2;
-        if (strstr("VERSION", (const char *)scratchPad->unicoreHash.sentenceName))
+        if (scratchPad->unicoreHash.sentenceId == SEMP_UNICORE_HASH_ID_VERSION)
             scratchPad->unicoreHash.checksumBytes = 8;
+
+        // Skip the data and checksum when rejected by the filter
+        if (sempFilterSentence(parse, scratchPad->unicoreHash.sentenceId,
+                               (const char *)scratchPad->unicoreHash.sentenceName,
+                               '*', scratchPad->unicoreHash.checksumBytes))
+            return true;
+
+        // Start the field index with the sentence name and the first field
+        sempSentenceStartFields(parse, ';');
+        parse->consumeBytes = sempUnicoreHashConsumeBytes;
         parse->state = sempUnicoreHashFindAsterisk;
     }
     return true;
@@ -326,37 +438,63 @@ bool sempUnicoreHashFindFirstComma(SEMP_PARSE_STATE *parse, uint8_t data)
 // Check for the preamble
 bool sempUnicoreHashPreamble(SEMP_PARSE_STATE *parse, uint8_t data)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     if (data != '#')
         return false;
     scratchPad->unicoreHash.sentenceNameLength = 0;
+    scratchPad->unicoreHash.sentenceId = SEMP_UNICORE_HASH_ID_UNKNOWN;
+    scratchPad->unicoreHash.nameHash = UNICORE_HASH_FNV_BASIS;
     parse->state = sempUnicoreHashFindFirstComma;
     return true;
 }
 
+// Name the parser states, the preamble routine is first
+const SEMP_STATE_NAME sempUnicoreHashStateNames[] =
+{
+    SEMP_STATE(sempUnicoreHashPreamble),
+    SEMP_STATE(sempUnicoreHashFindFirstComma),
+    SEMP_STATE(sempUnicoreHashFindAsterisk),
+    SEMP_STATE(sempUnicoreHashChecksumByte),
+    SEMP_STATE(sempUnicoreHashLineTermination),
+    SEMP_STATE(sempUnicoreHashCarriageReturn),
+    SEMP_STATE(sempUnicoreHashLineFeed),
+};
+
+// State name table, see sempBeginParser
+const SEMP_STATE_TABLE sempUnicoreHashStateTable =
+{
+    sempUnicoreHashStateNames,
+    sizeof(sempUnicoreHashStateNames) / sizeof(SEMP_STATE_NAME)
+};
+
 // Translates state value into an string, returns nullptr if not found
 const char * sempUnicoreHashGetStateName(const SEMP_PARSE_STATE *parse)
 {
-    if (parse->state == sempUnicoreHashPreamble)
-        return "sempUnicoreHashPreamble";
-    if (parse->state == sempUnicoreHashFindFirstComma)
-        return "sempUnicoreHashFindFirstComma";
-    if (parse->state == sempUnicoreHashFindAsterisk)
-        return "sempUnicoreHashFindAsterisk";
-    if (parse->state == sempUnicoreHashChecksumByte)
-        return "sempUnicoreHashChecksumByte";
-    if (parse->state == sempUnicoreHashLineTermination)
-        return "sempUnicoreHashLineTermination";
-    if (parse->state == sempUnicoreHashCarriageReturn)
-        return "sempUnicoreHashCarriageReturn";
-    if (parse->state == sempUnicoreHashLineFeed)
-        return "sempUnicoreHashLineFeed";
-    return nullptr;
+    return sempFindStateName(&sempUnicoreHashStateTable, parse->state);
 }
 
 // Return the Unicore hash (#) sentence name as a string
 const char * sempUnicoreHashGetSentenceName(const SEMP_PARSE_STATE *parse)
 {
-    SEMP_SCRATCH_PAD *scratchPad = (SEMP_SCRATCH_PAD *)parse->scratchPad;
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
     return (const char *)scratchPad->unicoreHash.sentenceName;
 }
+
+// Get the Unicore hash (#) sentence ID
+uint8_t sempUnicoreHashGetSentenceId(const SEMP_PARSE_STATE *parse)
+{
+    SEMP_SCRATCH_PAD *scratchPad = sempGetScratchPad(parse);
+    return scratchPad->unicoreHash.sentenceId;
+}
+
+// Get the number of fields in the Unicore hash (#) sentence
+uint16_t sempUnicoreHashGetFieldCount(const SEMP_PARSE_STATE *parse)
+{
+    return parse->fields.count;
+}
+
+// Get a field of the Unicore hash (#) sentence
+const char * sempUnicoreHashGetField(const SEMP_PARSE_STATE *parse, uint16_t field, size_t *length)
+{
+    return sempSentenceGetField(parse, &parse->fields, field, length);
+}
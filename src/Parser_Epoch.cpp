@@ -0,0 +1,262 @@
+/*------------------------------------------------------------------------------
+Parser_Epoch.cpp
+
+Group the messages of a receiver epoch
+
+The epoch key of each message is located using the parser that delivered
+the message: the RTCM MSM epoch time and multiple message bit, the u-blox
+NAV iTOW, the SBF TOW and the Unicore binary header secondsOfWeek.  The
+messages of the open epoch are copied into the caller's arena and passed
+to the callback routine once, as soon as the last message of the epoch
+arrives or the next epoch starts.
+
+License: MIT. Please see LICENSE.md for more details
+------------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <string.h>
+#include "SparkFun_Extensible_Message_Parser.h"
+
+//----------------------------------------
+// Constants
+//----------------------------------------
+
+// u-blox NAV class and the NAV-EOE message
+#define SEMP_EPOCH_UBLOX_NAV        0x01
+#define SEMP_EPOCH_UBLOX_NAV_EOE    0x0161
+
+// SBF TOW value when the time is not known
+#define SEMP_EPOCH_SBF_TOW_UNKNOWN  0xffffffff
+
+//----------------------------------------
+// Types
+//----------------------------------------
+
+// Epoch key of a message
+typedef struct _SEMP_EPOCH_KEY
+{
+    uint32_t id;                   // Message ID, see SEMP_MESSAGE_FILTER
+    uint32_t time;                 // Epoch time
+    bool last;                     // Last message of the epoch
+    bool timed;                    // The epoch ends when the time changes
+} SEMP_EPOCH_KEY;
+
+//----------------------------------------
+// Support routines
+//----------------------------------------
+
+// Get the epoch key of a RTCM message, returns true for a MSM message
+bool sempEpochRtcmKey(const uint8_t *message, size_t length, SEMP_EPOCH_KEY *key)
+{
+    uint64_t header;
+
+    // Message number (12), station ID (12), epoch time (30), multiple
+    // message bit (1), RTCM 10403.3 Table 3.5-78
+    if (length < (3 + 8 + 3))
+        return false;
+    header = sempReadU8Be(&message[3]);
+    key->id = (uint32_t)(header >> 52);
+    if ((key->id < 1071) || (key->id > 1137)
+        || ((key->id % 10) < 1) || ((key->id % 10) > 7))
+        return false;
+    key->time = (uint32_t)(header >> 10) & 0x3fffffff;
+    key->last = ((header >> 9) & 1) == 0;
+    key->timed = false;
+    return true;
+}
+
+// Get the epoch key of a u-blox message, returns true for a NAV message
+bool sempEpochUbloxKey(const uint8_t *message, size_t length, SEMP_EPOCH_KEY *key)
+{
+    uint16_t iTowOffset;
+
+    // Sync (2), class (1), ID (1), length (2), payload, checksum (2)
+    if ((length < (6 + 4 + 2)) || (message[2] != SEMP_EPOCH_UBLOX_NAV))
+        return false;
+    key->id = (((uint32_t)message[2]) << 8) | message[3];
+
+    // A few NAV messages start with a version field
+    switch (message[3])
+    {
+    default:
+        iTowOffset = 0;
+        break;
+    case 0x09: // NAV-ODO
+    case 0x13: // NAV-HPPOSECEF
+    case 0x14: // NAV-HPPOSLLH
+    case 0x3b: // NAV-SVIN
+    case 0x3c: // NAV-RELPOSNED
+        iTowOffset = 4;
+        break;
+    }
+    if (length < (size_t)(6 + iTowOffset + 4 + 2))
+        return false;
+    key->time = sempReadU4Le(&message[6 + iTowOffset]);
+    key->last = (key->id == SEMP_EPOCH_UBLOX_NAV_EOE);
+    key->timed = true;
+    return true;
+}
+
+// Get the epoch key of a SBF block, returns true when the TOW is known
+bool sempEpochSbfKey(const uint8_t *message, size_t length, SEMP_EPOCH_KEY *key)
+{
+    // Sync (2), CRC (2), ID (2), length (2), TOW (4), WNc (2)
+    if (length < 14)
+        return false;
+    key->id = sempReadU2Le(&message[4]) & 0x1fff;
+    key->time = sempReadU4Le(&message[8]);
+    key->last = false;
+    key->timed = true;
+    return (key->time != SEMP_EPOCH_SBF_TOW_UNKNOWN);
+}
+
+// Get the epoch key of a Unicore binary message
+bool sempEpochUnicoreBinaryKey(const uint8_t *message, size_t length, SEMP_EPOCH_KEY *key)
+{
+    // The message may not be aligned, read the header fields by byte
+    if (length < sizeof(SEMP_UNICORE_HEADER))
+        return false;
+    key->id = sempReadU2Le(&message[offsetof(SEMP_UNICORE_HEADER, messageId)]);
+    key->time = sempReadU4Le(&message[offsetof(SEMP_UNICORE_HEADER, secondsOfWeek)]);
+    key->last = false;
+    key->timed = true;
+    return true;
+}
+
+// Get the epoch key of a message, returns true when the message is part
+// of an epoch
+bool sempEpochGetKey(const SEMP_PARSE_STATE *parse,
+                     uint16_t type,
+                     const uint8_t *message,
+                     size_t length,
+                     SEMP_EPOCH_KEY *key)
+{
+    SEMP_PARSE_ROUTINE preamble;
+
+    // Locate the epoch key using the parser that found the message
+    if ((!parse) || (type >= parse->parserCount))
+        return false;
+    preamble = parse->parsers[type];
+    if (preamble == sempRtcmPreamble)
+        return sempEpochRtcmKey(message, length, key);
+    if (preamble == sempUbloxPreamble)
+        return sempEpochUbloxKey(message, length, key);
+    if (preamble == sempSbfPreamble)
+        return sempEpochSbfKey(message, length, key);
+    if (preamble == sempUnicoreBinaryPreamble)
+        return sempEpochUnicoreBinaryKey(message, length, key);
+    return false;
+}
+
+// Pass the messages of the open epoch to the callback routine
+void sempEpochEmit(SEMP_EPOCH *epoch, uint8_t status)
+{
+    if (epoch->count)
+        epoch->callback(epoch, epoch->entries, epoch->count, epoch->arena, status);
+    epoch->count = 0;
+    epoch->arenaUsed = 0;
+    if (status != SEMP_EPOCH_PARTIAL)
+        epoch->open = false;
+}
+
+//----------------------------------------
+// Epoch routines
+//----------------------------------------
+
+// Initialize the epoch state, returns true when successful
+bool sempEpochInit(SEMP_EPOCH *epoch,
+                   SEMP_BATCH_ENTRY *entries,
+                   uint16_t entryCount,
+                   uint8_t *arena,
+                   uint32_t arenaBytes,
+                   SEMP_EPOCH_CALLBACK callback,
+                   void *context)
+{
+    if ((!epoch) || (!entries) || (!entryCount)
+        || (!arena) || (!arenaBytes) || (!callback))
+        return false;
+    memset(epoch, 0, sizeof(*epoch));
+    epoch->callback = callback;
+    epoch->entries = entries;
+    epoch->entryCount = entryCount;
+    epoch->arena = arena;
+    epoch->arenaBytes = arenaBytes;
+    epoch->context = context;
+    return true;
+}
+
+// Add a valid message to its epoch
+void sempEpochAddMessage(SEMP_EPOCH *epoch,
+                         const SEMP_PARSE_STATE *parse,
+                         uint16_t type,
+                         const uint8_t *message,
+                         size_t length)
+{
+    SEMP_BATCH_ENTRY *entry;
+    SEMP_EPOCH_KEY key;
+    SEMP_BATCH_ENTRY single;
+
+    if ((!epoch) || (!message))
+        return;
+
+    // Pass the messages outside of an epoch by themselves
+    if (!sempEpochGetKey(parse, type, message, length, &key))
+    {
+        single.offset = 0;
+        single.id = parse ? parse->messageId : 0;
+        single.length = length;
+        single.type = type;
+        epoch->callback(epoch, &single, 1, message, SEMP_EPOCH_SINGLE);
+        return;
+    }
+
+    // End the open epoch when the message starts another epoch
+    if (epoch->open
+        && ((type != epoch->type) || (key.timed && (key.time != epoch->time))))
+        sempEpochEmit(epoch, SEMP_EPOCH_ENDED);
+    if (!epoch->open)
+    {
+        epoch->open = true;
+        epoch->type = type;
+        epoch->time = key.time;
+    }
+
+    // Pass the messages to the callback routine when the message does not fit
+    if ((length > (epoch->arenaBytes - epoch->arenaUsed))
+        || (epoch->count >= epoch->entryCount))
+        sempEpochEmit(epoch, SEMP_EPOCH_PARTIAL);
+
+    // Pass a message larger than the arena by itself
+    if (length > epoch->arenaBytes)
+    {
+        single.offset = 0;
+        single.id = key.id;
+        single.length = length;
+        single.type = type;
+        epoch->callback(epoch, &single, 1, message,
+                        key.last ? SEMP_EPOCH_COMPLETE : SEMP_EPOCH_PARTIAL);
+        if (key.last)
+            epoch->open = false;
+        return;
+    }
+
+    // Copy the message into the arena
+    entry = &epoch->entries[epoch->count++];
+    entry->offset = epoch->arenaUsed;
+    entry->id = key.id;
+    entry->length = length;
+    entry->type = type;
+    memcpy(&epoch->arena[entry->offset], message, length);
+    epoch->arenaUsed += length;
+
+    // Pass the epoch to the callback routine as soon as it is complete
+    if (key.last)
+        sempEpochEmit(epoch, SEMP_EPOCH_COMPLETE);
+}
+
+// Pass the messages of the open epoch to the callback routine
+void sempEpochFlush(SEMP_EPOCH *epoch)
+{
+    if (epoch)
+        sempEpochEmit(epoch, SEMP_EPOCH_ENDED);
+}
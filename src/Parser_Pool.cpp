@@ -0,0 +1,312 @@
+/*------------------------------------------------------------------------------
+Parser_Pool.cpp
+
+Parse multiple data streams using a pool of parsers
+
+Each data stream has its own parse structure and is assigned to a single
+worker, keeping the stream on the same core.  The data chunks passed to a
+worker and the messages produced by the worker flow through message rings,
+allowing the application, the workers
+and the message consumers to run in parallel without locks.
+
+License: MIT. Please see LICENSE.md for more details
+------------------------------------------------------------------------------*/
+
+#include <malloc.h>
+#include <string.h>
+#include "SparkFun_Extensible_Message_Parser.h"
+
+#if SEMP_FEATURES
+
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif  // ESP32
+
+//----------------------------------------
+// Constants
+//----------------------------------------
+
+// Minimum size of the queue storage
+#define SEMP_POOL_MINIMUM_QUEUE     SEMP_RING_MINIMUM_SIZE
+
+//----------------------------------------
+// Support routines
+//----------------------------------------
+
+// Place the message from a stream parser into the output queue
+void sempPoolEom(SEMP_PARSE_STATE *parse, uint16_t type)
+{
+    SEMP_PARSE_STATE *owner;
+    SEMP_POOL *pool;
+    SEMP_POOL_WORKER *worker;
+
+    // Parallel parsers deliver the message using their own parse structure
+    owner = parse->features->parent ? parse->features->parent : parse;
+    pool = owner->features->pool;
+    worker = &pool->workers[owner->features->poolStream % pool->workerCount];
+    if (!sempMessageRingWrite(&worker->output, owner->features->poolStream, type,
+                              parse->buffer, parse->length))
+        worker->droppedMessages += 1;
+}
+
+#ifdef ESP32
+// Run a pool worker until the pool is stopped
+void sempPoolTask(void *parameter)
+{
+    SEMP_POOL *pool;
+    SEMP_POOL_WORKER *worker;
+
+    // Parse the data as it arrives
+    worker = (SEMP_POOL_WORKER *)parameter;
+    pool = worker->pool;
+    while (!__atomic_load_n(&pool->stopTasks, __ATOMIC_ACQUIRE))
+    {
+        if (!sempPoolRunWorker(pool, worker - pool->workers))
+            vTaskDelay(1);
+    }
+
+    // Let sempStopPool know that the task is done
+    __atomic_store_n(&worker->task, nullptr, __ATOMIC_RELEASE);
+    vTaskDelete(nullptr);
+}
+#endif  // ESP32
+
+//----------------------------------------
+// Pool routines
+//----------------------------------------
+
+// Allocate and initialize a pool of parsers
+SEMP_POOL * sempBeginPool(const SEMP_PARSE_ROUTINE *parseTable,
+                          uint16_t parserCount,
+                          const char * const *parserNameTable,
+                          uint16_t parserNameCount,
+                          uint16_t scratchPadBytes,
+                          size_t bufferLength,
+                          uint16_t streamCount,
+                          uint16_t workerCount,
+                          size_t queueBytes,
+                          SEMP_POOL_CALLBACK callback,
+                          const char *name,
+                          Print *printError,
+                          const int16_t *preambleTable,
+                          const SEMP_STATE_TABLE * const *stateTables)
+{
+    size_t bytes;
+    uint8_t *data;
+    int index;
+    SEMP_PARSE_STATE *parse;
+    SEMP_POOL *pool;
+    uint32_t queueSize;
+
+    // Validate the pool parameters, the parser parameters are validated
+    // by sempBeginParser
+    if ((!streamCount) || (streamCount >= SEMP_MESSAGE_RING_WRAP))
+    {
+        SEMP_ERROR_PRINTLN(printError, "SEMP: Please specify 1 - 65534 streams for the pool");
+        return nullptr;
+    }
+    if ((!workerCount) || (workerCount > streamCount))
+    {
+        SEMP_ERROR_PRINTLN(printError, "SEMP: Please specify 1 - streamCount workers for the pool");
+        return nullptr;
+    }
+    if (!callback)
+    {
+        SEMP_ERROR_PRINTLN(printError, "SEMP: Please specify a pool callback routine");
+        return nullptr;
+    }
+    if ((!name) || (!strlen(name)))
+    {
+        SEMP_ERROR_PRINTLN(printError, "SEMP: Please provide a name for the pool");
+        return nullptr;
+    }
+
+    // The queue size is a power of two, allowing the head and tail values
+    // to wrap at 32-bits
+    queueSize = SEMP_POOL_MINIMUM_QUEUE;
+    while ((queueSize < queueBytes) && (queueSize < 0x80000000))
+        queueSize <<= 1;
+
+    // Allocate the pool, workers, parser pointers and queues
+    bytes = SEMP_ALIGN(sizeof(SEMP_POOL))
+          + SEMP_ALIGN(workerCount * sizeof(SEMP_POOL_WORKER))
+          + SEMP_ALIGN(streamCount * sizeof(SEMP_PARSE_STATE *))
+          + (2 * workerCount * (size_t)queueSize);
+    pool = (SEMP_POOL *)malloc(bytes);
+    if (!pool)
+    {
+        SEMP_ERROR_PRINTLN(printError, "SEMP: Failed to allocate the pool");
+        return nullptr;
+    }
+    memset(pool, 0, bytes - (2 * workerCount * (size_t)queueSize));
+
+    // Initialize the pool
+    data = (uint8_t *)pool + SEMP_ALIGN(sizeof(SEMP_POOL));
+    pool->workers = (SEMP_POOL_WORKER *)data;
+    data += SEMP_ALIGN(workerCount * sizeof(SEMP_POOL_WORKER));
+    pool->parsers = (SEMP_PARSE_STATE **)data;
+    data += SEMP_ALIGN(streamCount * sizeof(SEMP_PARSE_STATE *));
+    pool->callback = callback;
+    pool->name = name;
+    pool->printError = printError;
+    pool->streamCount = streamCount;
+    pool->workerCount = workerCount;
+
+    // Initialize the workers
+    for (index = 0; index < workerCount; index++)
+    {
+        pool->workers[index].pool = pool;
+        sempMessageRingInit(&pool->workers[index].input, data, queueSize);
+        data += queueSize;
+        sempMessageRingInit(&pool->workers[index].output, data, queueSize);
+        data += queueSize;
+    }
+
+    // Initialize the stream parsers
+    for (index = 0; index < streamCount; index++)
+    {
+        parse = sempBeginParser(parseTable, parserCount,
+                                parserNameTable, parserNameCount,
+                                scratchPadBytes, bufferLength,
+                                sempPoolEom, name, printError,
+                                nullptr, nullptr, preambleTable,
+                                stateTables);
+        if (!parse)
+        {
+            sempStopPool(&pool);
+            break;
+        }
+        parse->features->pool = pool;
+        parse->features->poolStream = index;
+        pool->parsers[index] = parse;
+    }
+    return pool;
+}
+
+// Queue a chunk of stream data for parsing
+bool sempPoolParse(SEMP_POOL *pool, uint16_t stream, const uint8_t *data, size_t length)
+{
+    if ((!pool) || (stream >= pool->streamCount))
+        return false;
+    return sempMessageRingWrite(&pool->workers[stream % pool->workerCount].input,
+                                stream, 0, data, length);
+}
+
+// Parse the data queued for a worker
+bool sempPoolRunWorker(SEMP_POOL *pool, uint16_t worker)
+{
+    bool parsed;
+    SEMP_MESSAGE_RING *queue;
+    const SEMP_MESSAGE_RECORD *record;
+
+    // Parse each of the chunks in the input queue
+    parsed = false;
+    if (pool && (worker < pool->workerCount))
+    {
+        queue = &pool->workers[worker].input;
+        while ((record = sempMessageRingRead(queue)))
+        {
+            sempParseBuffer(pool->parsers[record->stream],
+                            (const uint8_t *)&record[1], record->length);
+            sempMessageRingRelease(queue, record);
+            parsed = true;
+        }
+    }
+    return parsed;
+}
+
+// Pass the queued messages of a worker to the pool callback
+int sempPoolDeliverMessages(SEMP_POOL *pool, uint16_t worker)
+{
+    int messages;
+    SEMP_MESSAGE_RING *queue;
+    const SEMP_MESSAGE_RECORD *record;
+
+    // Deliver each of the messages in the output queue
+    messages = 0;
+    if (pool && (worker < pool->workerCount))
+    {
+        queue = &pool->workers[worker].output;
+        while ((record = sempMessageRingRead(queue)))
+        {
+            pool->callback(record->stream, record->type,
+                           (const uint8_t *)&record[1], record->length);
+            sempMessageRingRelease(queue, record);
+            messages += 1;
+        }
+    }
+    return messages;
+}
+
+// Get the parse structure of a stream
+SEMP_PARSE_STATE * sempPoolGetParser(SEMP_POOL *pool, uint16_t stream)
+{
+    if ((!pool) || (stream >= pool->streamCount))
+        return nullptr;
+    return pool->parsers[stream];
+}
+
+// Get the worker assigned to a stream
+uint16_t sempPoolGetWorker(const SEMP_POOL *pool, uint16_t stream)
+{
+    return stream % pool->workerCount;
+}
+
+#ifdef ESP32
+// Run each worker in a FreeRTOS task
+bool sempPoolStartTasks(SEMP_POOL *pool, uint32_t stackBytes, uint32_t priority)
+{
+    int index;
+    SEMP_POOL_WORKER *worker;
+
+    if (!pool)
+        return false;
+
+    // Pin worker n to core n modulo the number of cores
+    pool->stopTasks = false;
+    for (index = 0; index < pool->workerCount; index++)
+    {
+        worker = &pool->workers[index];
+        if (worker->task)
+            continue;
+        if (xTaskCreatePinnedToCore(sempPoolTask,
+                                    pool->name,
+                                    stackBytes,
+                                    worker,
+                                    priority,
+                                    (TaskHandle_t *)&worker->task,
+                                    index % portNUM_PROCESSORS) != pdPASS)
+        {
+            SEMP_ERROR_PRINTLN(pool->printError, "SEMP: Failed to start the pool worker task");
+            return false;
+        }
+    }
+    return true;
+}
+#endif  // ESP32
+
+// Shutdown the pool
+void sempStopPool(SEMP_POOL **pool)
+{
+    int index;
+
+    if (pool && *pool)
+    {
+#ifdef ESP32
+        // Wait for the worker tasks to exit
+        __atomic_store_n(&(*pool)->stopTasks, true, __ATOMIC_RELEASE);
+        for (index = 0; index < (*pool)->workerCount; index++)
+            while (__atomic_load_n(&(*pool)->workers[index].task, __ATOMIC_ACQUIRE))
+                vTaskDelay(1);
+#endif  // ESP32
+
+        // Free the parsers and the pool
+        for (index = 0; index < (*pool)->streamCount; index++)
+            sempStopParser(&(*pool)->parsers[index]);
+        free(*pool);
+        *pool = nullptr;
+    }
+}
+
+#endif  // SEMP_FEATURES
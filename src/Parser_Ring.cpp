@@ -0,0 +1,260 @@
+/*------------------------------------------------------------------------------
+Parser_Ring.cpp
+
+Lock-free rings passing data bytes and messages between execution contexts
+
+The byte ring passes the data from an interrupt routine, DMA or another
+task to the parser and the message ring passes the messages from the
+parser to another task.  Both rings have a single producer and a single
+consumer.  The head is only updated by the producer and the tail is only
+updated by the consumer, using acquire and release ordering so that the
+data is visible before the head or tail update.  The head and tail are
+free running 32-bit byte counts, the storage size is a power of two.
+
+License: MIT. Please see LICENSE.md for more details
+------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "SparkFun_Extensible_Message_Parser.h"
+
+//----------------------------------------
+// Support routines
+//----------------------------------------
+
+// Validate the ring storage, returns true when the storage is usable
+bool sempRingValidate(const uint8_t *storage, uint32_t size)
+{
+    return storage
+        && (size >= SEMP_RING_MINIMUM_SIZE)
+        && ((size & (size - 1)) == 0);
+}
+
+//----------------------------------------
+// Byte ring routines
+//----------------------------------------
+
+// Initialize a byte ring, returns true when successful
+bool sempByteRingInit(SEMP_BYTE_RING *ring, uint8_t *storage, uint32_t size)
+{
+    if ((!ring) || (!sempRingValidate(storage, size)))
+        return false;
+    ring->data = storage;
+    ring->size = size;
+    ring->head = 0;
+    ring->tail = 0;
+    return true;
+}
+
+// Get the address of the contiguous free space in the ring, returns the
+// number of free bytes at that address
+size_t SEMP_ISR_ATTR sempByteRingGetSpace(SEMP_BYTE_RING *ring, uint8_t **space)
+{
+    uint32_t bytes;
+    uint32_t offset;
+
+    // Determine the free space, only the consumer updates the tail
+    bytes = ring->size - (ring->head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE));
+    offset = ring->head & (ring->size - 1);
+    *space = &ring->data[offset];
+    return SEMP_MIN(bytes, ring->size - offset);
+}
+
+// Add the bytes placed in the free space to the ring
+void SEMP_ISR_ATTR sempByteRingCommit(SEMP_BYTE_RING *ring, size_t length)
+{
+    // Make the data visible to the consumer
+    __atomic_store_n(&ring->head, ring->head + (uint32_t)length, __ATOMIC_RELEASE);
+}
+
+// Add data bytes to the ring, returns the number of bytes added
+size_t SEMP_ISR_ATTR sempByteRingWrite(SEMP_BYTE_RING *ring, const uint8_t *data, size_t length)
+{
+    size_t bytes;
+    uint32_t head;
+    uint32_t offset;
+    uint32_t space;
+
+    // Determine the free space, only the consumer updates the tail
+    head = ring->head;
+    space = ring->size - (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE));
+    length = SEMP_MIN(length, space);
+
+    // Copy the data, wrapping at the end of the storage
+    offset = head & (ring->size - 1);
+    bytes = SEMP_MIN(length, ring->size - offset);
+    memcpy(&ring->data[offset], data, bytes);
+    memcpy(ring->data, &data[bytes], length - bytes);
+
+    // Make the data visible to the consumer
+    __atomic_store_n(&ring->head, head + (uint32_t)length, __ATOMIC_RELEASE);
+    return length;
+}
+
+// Add a data byte to the ring, returns true when the byte was added
+bool SEMP_ISR_ATTR sempByteRingWriteByte(SEMP_BYTE_RING *ring, uint8_t data)
+{
+    uint32_t head;
+
+    // Determine if the ring is full, only the consumer updates the tail
+    head = ring->head;
+    if ((head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)) >= ring->size)
+        return false;
+
+    // Make the data visible to the consumer
+    ring->data[head & (ring->size - 1)] = data;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Get the number of data bytes in the ring
+size_t sempByteRingAvailable(const SEMP_BYTE_RING *ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - ring->tail;
+}
+
+// Parse all of the data bytes in the ring, returns the number of bytes parsed
+size_t sempParseByteRing(SEMP_PARSE_STATE *parse, SEMP_BYTE_RING *ring)
+{
+    size_t bytes;
+    uint32_t head;
+    size_t length;
+    uint32_t offset;
+
+    if ((!parse) || (!ring))
+        return 0;
+
+    // Determine the data available, only the producer updates the head
+    head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    length = head - ring->tail;
+    if (!length)
+        return 0;
+
+    // Parse the data in at most two pieces, the data remains in place
+    // until the tail is updated so zero-copy messages are delivered from
+    // the ring storage
+    offset = ring->tail & (ring->size - 1);
+    bytes = SEMP_MIN(length, ring->size - offset);
+    sempParseBuffer(parse, &ring->data[offset], bytes);
+    if (length > bytes)
+        sempParseBuffer(parse, ring->data, length - bytes);
+
+    // Release the space to the producer
+    __atomic_store_n(&ring->tail, head, __ATOMIC_RELEASE);
+    return length;
+}
+
+//----------------------------------------
+// Message ring routines
+//----------------------------------------
+
+// Initialize a message ring, returns true when successful
+bool sempMessageRingInit(SEMP_MESSAGE_RING *ring, uint8_t *storage, uint32_t size)
+{
+    if ((!ring)
+        || (!sempRingValidate(storage, size))
+        || ((uintptr_t)storage & SEMP_ALIGNMENT_MASK))
+        return false;
+    ring->data = storage;
+    ring->size = size;
+    ring->head = 0;
+    ring->tail = 0;
+    return true;
+}
+
+// Add a message to the ring, returns false when the ring is full
+bool sempMessageRingWrite(SEMP_MESSAGE_RING *ring,
+                          uint16_t stream,
+                          uint16_t type,
+                          const uint8_t *data,
+                          size_t length)
+{
+    uint32_t bytes;
+    uint32_t head;
+    uint32_t offset;
+    SEMP_MESSAGE_RECORD *record;
+    bool restart;
+    uint32_t space;
+    uint32_t tail;
+
+    // Determine the free space, only the consumer updates the tail
+    head = ring->head;
+    tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    space = ring->size - (head - tail);
+    offset = head & (ring->size - 1);
+    if (length > (ring->size - sizeof(SEMP_MESSAGE_RECORD)))
+        return false;
+    bytes = SEMP_ALIGN(sizeof(SEMP_MESSAGE_RECORD) + length);
+
+    // Records are contiguous, skip the end of the storage when necessary
+    restart = false;
+    if (bytes > (ring->size - offset))
+    {
+        // The consumer is done with an empty ring, restart the ring at the
+        // beginning of the storage
+        if (head == tail)
+            restart = true;
+        else
+        {
+            if ((ring->size - offset + bytes) > space)
+                return false;
+            record = (SEMP_MESSAGE_RECORD *)&ring->data[offset];
+            record->stream = SEMP_MESSAGE_RING_WRAP;
+        }
+        head += ring->size - offset;
+        offset = 0;
+    }
+    else if (bytes > space)
+        return false;
+
+    // Save the record
+    record = (SEMP_MESSAGE_RECORD *)&ring->data[offset];
+    record->stream = stream;
+    record->type = type;
+    record->length = length;
+    memcpy(&record[1], data, length);
+
+    // Move the tail after saving the record, the consumer ignores a tail
+    // that is ahead of the head
+    if (restart)
+        __atomic_store_n(&ring->tail, head, __ATOMIC_RELEASE);
+
+    // Make the record visible to the consumer
+    __atomic_store_n(&ring->head, head + bytes, __ATOMIC_RELEASE);
+    return true;
+}
+
+// Get the oldest message in the ring, returns nullptr when the ring is empty
+const SEMP_MESSAGE_RECORD * sempMessageRingRead(SEMP_MESSAGE_RING *ring)
+{
+    uint32_t head;
+    uint32_t offset;
+    const SEMP_MESSAGE_RECORD *record;
+    uint32_t tail;
+
+    // Determine if a record is available, only the producer updates the
+    // head.  The tail is ahead of the head while the producer restarts
+    // an empty ring.
+    head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if ((int32_t)(head - tail) <= 0)
+        return nullptr;
+    offset = tail & (ring->size - 1);
+    record = (const SEMP_MESSAGE_RECORD *)&ring->data[offset];
+
+    // Skip the end of the storage, the next record is at the beginning
+    if (record->stream == SEMP_MESSAGE_RING_WRAP)
+    {
+        tail += ring->size - offset;
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+        record = (const SEMP_MESSAGE_RECORD *)ring->data;
+    }
+    return record;
+}
+
+// Remove the oldest message from the ring
+void sempMessageRingRelease(SEMP_MESSAGE_RING *ring, const SEMP_MESSAGE_RECORD *record)
+{
+    __atomic_store_n(&ring->tail,
+                     ring->tail + SEMP_ALIGN(sizeof(SEMP_MESSAGE_RECORD) + record->length),
+                     __ATOMIC_RELEASE);
+}
@@ -0,0 +1,348 @@
+/*------------------------------------------------------------------------------
+Parser_Splitter.cpp
+
+Parse a large block of data in chunks using multiple threads
+
+Each chunk is parsed from the beginning of the chunk by its own parser,
+searching for a preamble.  The parser continues past the end of the chunk
+until it is searching for a preamble again, the offset where the parse of
+the next chunk resumes.  When a chunk starts in the middle of a message,
+the messages found before the resume offset of the previous chunk are
+discarded when the messages are delivered.  Zero-copy locates the messages
+within the data and resync keeps the parsing lossless after a failed
+message.
+
+License: MIT. Please see LICENSE.md for more details
+------------------------------------------------------------------------------*/
+
+#include <malloc.h>
+#include <string.h>
+#include "SparkFun_Extensible_Message_Parser.h"
+
+//----------------------------------------
+// Constants
+//----------------------------------------
+
+// Initial number of entries in a chunk's message array
+#define SEMP_SPLIT_MINIMUM_SLOTS    64
+
+//----------------------------------------
+// Support routines
+//----------------------------------------
+
+// Determine the number of message bytes found at an offset in the data,
+// returns zero when the message is not there
+size_t sempSplitterMatch(const SEMP_SPLITTER *splitter,
+                         const SEMP_SPLIT_CHUNK *chunk,
+                         size_t offset,
+                         const uint8_t *message,
+                         size_t length)
+{
+    size_t bytes;
+
+    // The message follows the previous message within the data
+    if ((offset < chunk->searchOffset) || (offset >= splitter->length))
+        return 0;
+
+    // NMEA and Unicore hash sentences received without a carriage return
+    // and line feed end before the terminator added by the parser
+    length = SEMP_MIN(length, splitter->length - offset);
+    for (bytes = 0; bytes < length; bytes++)
+        if (splitter->data[offset + bytes] != message[bytes])
+            break;
+    return bytes;
+}
+
+// Save the location of a message found in a chunk
+void sempSplitterEom(SEMP_PARSE_STATE *parse, uint16_t type)
+{
+    SEMP_SPLIT_CHUNK *chunk;
+    SEMP_SPLIT_MESSAGE *messages;
+    size_t length;
+    size_t offset;
+    uint32_t slots;
+    SEMP_SPLITTER *splitter;
+
+    // The chunk address is saved in front of the parse structure
+    chunk = *(SEMP_SPLIT_CHUNK **)((uint8_t *)parse - SEMP_ALIGN(sizeof(SEMP_SPLIT_CHUNK *)));
+    splitter = chunk->splitter;
+
+    // Messages parsed in place are within the data, the parser locates
+    // the preamble of the messages copied into the parse buffer
+    if ((parse->buffer >= splitter->data)
+        && (parse->buffer < &splitter->data[splitter->length]))
+    {
+        offset = parse->buffer - splitter->data;
+        length = parse->length;
+    }
+    else
+    {
+        offset = parse->messageStart - splitter->data;
+        length = sempSplitterMatch(splitter, chunk, offset,
+                                   parse->buffer, parse->length);
+    }
+
+    // Don't save a message that was not found in the data
+    if ((!length) || (offset < chunk->searchOffset))
+    {
+        { const uint8_t*f=(const uint8_t*)memmem(splitter->data+chunk->start, splitter->length-chunk->start, parse->buffer, 8); printf("DBG off=%zu actual=%zd search=%zu len=%u chunk=%zu-%zu\n", offset, f? f-splitter->data : -1, chunk->searchOffset, parse->length, chunk->start, chunk->end);}
+        SEMP_ERROR_PRINTF(splitter->printError, "SEMP %s: Failed to locate the %s message in the data\r\n",
+                          splitter->name, sempGetTypeName(parse, type));
+        return;
+    }
+    chunk->searchOffset = offset + length;
+
+    // Grow the message array when necessary
+    if (chunk->messageCount >= chunk->messageSlots)
+    {
+        slots = chunk->messageSlots ? (chunk->messageSlots * 2) : SEMP_SPLIT_MINIMUM_SLOTS;
+        messages = (SEMP_SPLIT_MESSAGE *)realloc(chunk->messages,
+                                                 slots * sizeof(SEMP_SPLIT_MESSAGE));
+        if (!messages)
+        {
+            SEMP_ERROR_PRINTLN(splitter->printError, "SEMP: Failed to allocate the splitter messages");
+            chunk->failed = true;
+            return;
+        }
+        chunk->messages = messages;
+        chunk->messageSlots = slots;
+    }
+
+    // Save the message location
+    chunk->messages[chunk->messageCount].offset = offset;
+    chunk->messages[chunk->messageCount].length = length;
+    chunk->messages[chunk->messageCount].type = type;
+    chunk->messageCount += 1;
+}
+
+//----------------------------------------
+// Splitter routines
+//----------------------------------------
+
+// Allocate and initialize a splitter
+SEMP_SPLITTER * sempBeginSplitter(const SEMP_PARSE_ROUTINE *parseTable,
+                                  uint16_t parserCount,
+                                  const char * const *parserNameTable,
+                                  uint16_t parserNameCount,
+                                  uint16_t scratchPadBytes,
+                                  size_t bufferLength,
+                                  const uint8_t *data,
+                                  size_t length,
+                                  uint32_t chunkCount,
+                                  SEMP_SPLIT_CALLBACK callback,
+                                  const char *name,
+                                  Print *printError,
+                                  const int16_t *preambleTable)
+{
+    size_t chunkBytes;
+    uint32_t index;
+    SEMP_SPLITTER *splitter;
+
+    // Validate the splitter parameters, the parser parameters are
+    // validated by sempBeginParser
+    if (parserCount != parserNameCount)
+    {
+        SEMP_ERROR_PRINTLN(printError, "SEMP: Please fix parserTable and parserNameTable parserCount != parserNameCount");
+        return nullptr;
+    }
+    if ((!data) && length)
+    {
+        SEMP_ERROR_PRINTLN(printError, "SEMP: Please specify the data for the splitter");
+        return nullptr;
+    }
+    if (!chunkCount)
+    {
+        SEMP_ERROR_PRINTLN(printError, "SEMP: Please specify at least one chunk for the splitter");
+        return nullptr;
+    }
+    if (!callback)
+    {
+        SEMP_ERROR_PRINTLN(printError, "SEMP: Please specify a splitter callback routine");
+        return nullptr;
+    }
+    if ((!name) || (!strlen(name)))
+    {
+        SEMP_ERROR_PRINTLN(printError, "SEMP: Please provide a name for the splitter");
+        return nullptr;
+    }
+
+    // Limit the number of chunks to the number of data bytes
+    if (chunkCount > length)
+        chunkCount = length ? length : 1;
+
+    // Allocate the splitter and the chunks
+    splitter = (SEMP_SPLITTER *)malloc(SEMP_ALIGN(sizeof(SEMP_SPLITTER))
+                                       + chunkCount * sizeof(SEMP_SPLIT_CHUNK));
+    if (!splitter)
+    {
+        SEMP_ERROR_PRINTLN(printError, "SEMP: Failed to allocate the splitter");
+        return nullptr;
+    }
+    memset(splitter, 0, SEMP_ALIGN(sizeof(SEMP_SPLITTER)) + chunkCount * sizeof(SEMP_SPLIT_CHUNK));
+
+    // Initialize the splitter
+    splitter->data = data;
+    splitter->length = length;
+    splitter->chunks = (SEMP_SPLIT_CHUNK *)((uint8_t *)splitter + SEMP_ALIGN(sizeof(SEMP_SPLITTER)));
+    splitter->chunkCount = chunkCount;
+    splitter->callback = callback;
+    splitter->parsers = parseTable;
+    splitter->parserNames = parserNameTable;
+    splitter->preambleTable = preambleTable;
+    splitter->name = name;
+    splitter->printError = printError;
+    splitter->bufferLength = SEMP_MAX(bufferLength, SEMP_MINIMUM_BUFFER_LENGTH);
+    splitter->scratchPadBytes = scratchPadBytes;
+    splitter->parserCount = parserCount;
+
+    // Divide the data into chunks
+    chunkBytes = length / chunkCount;
+    for (index = 0; index < chunkCount; index++)
+    {
+        splitter->chunks[index].splitter = splitter;
+        splitter->chunks[index].start = index * chunkBytes;
+        splitter->chunks[index].end = (index + 1) * chunkBytes;
+    }
+    splitter->chunks[chunkCount - 1].end = length;
+    return splitter;
+}
+
+// Parse the next chunk
+int32_t sempSplitterParseNextChunk(SEMP_SPLITTER *splitter)
+{
+    SEMP_SPLIT_CHUNK *chunk;
+    uint32_t index;
+    size_t offset;
+    SEMP_PARSE_STATE *parse;
+    uint8_t *storage;
+    size_t storageBytes;
+
+    if (!splitter)
+        return -1;
+
+    // Select the next chunk
+    index = __atomic_fetch_add(&splitter->nextChunk, 1, __ATOMIC_RELAXED);
+    if (index >= splitter->chunkCount)
+        return -1;
+    chunk = &splitter->chunks[index];
+    chunk->searchOffset = chunk->start;
+
+    // Allocate the parser, placing the chunk address in front of the
+    // parse structure for the eomCallback routine
+    storageBytes = SEMP_PARSER_STORAGE_SIZE(splitter->scratchPadBytes, splitter->bufferLength)
+                 + SEMP_STATS_STORAGE_SIZE(splitter->parserCount)
+                 + (splitter->preambleTable ? SEMP_PREAMBLE_STORAGE_SIZE(splitter->parserCount) : 0);
+    storage = (uint8_t *)malloc(SEMP_ALIGN(sizeof(SEMP_SPLIT_CHUNK *)) + storageBytes);
+    parse = nullptr;
+    if (storage)
+    {
+        *(SEMP_SPLIT_CHUNK **)storage = chunk;
+        parse = sempBeginParserWithStorage(storage + SEMP_ALIGN(sizeof(SEMP_SPLIT_CHUNK *)),
+                                           storageBytes,
+                                           splitter->parsers,
+                                           splitter->parserCount,
+                                           splitter->parserNames,
+                                           splitter->parserCount,
+                                           splitter->scratchPadBytes,
+                                           splitter->bufferLength,
+                                           sempSplitterEom,
+                                           splitter->name,
+                                           splitter->printError,
+                                           nullptr,
+                                           nullptr,
+                                           splitter->preambleTable);
+    }
+
+    // Parse the chunk in place
+    if (parse)
+    {
+        sempEnableZeroCopy(parse);
+        sempEnableResync(parse);
+        sempParseBuffer(parse, &splitter->data[chunk->start], chunk->end - chunk->start);
+
+        // Complete the message in progress, the chunk owns the messages
+        // parsed until the parser is searching for a preamble.  Pass the
+        // bytes in place one at a time to locate the messages.
+        offset = chunk->end;
+        while ((offset < splitter->length)
+               && ((parse->state != sempFirstByte) || parse->messageStarted))
+            sempParseBuffer(parse, &splitter->data[offset++], 1);
+        chunk->resumeOffset = offset;
+        sempStopParser(&parse);
+    }
+    else
+    {
+        SEMP_ERROR_PRINTLN(splitter->printError, "SEMP: Failed to allocate the splitter parser");
+        chunk->failed = true;
+    }
+    free(storage);
+
+    // Let sempSplitterDeliverMessages know that the messages are available
+    if (chunk->failed)
+        __atomic_fetch_add(&splitter->failedChunks, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&chunk->done, true, __ATOMIC_RELEASE);
+    return index;
+}
+
+// Pass the messages of the parsed chunks to the callback routine
+size_t sempSplitterDeliverMessages(SEMP_SPLITTER *splitter)
+{
+    SEMP_SPLIT_CHUNK *chunk;
+    uint32_t index;
+    size_t messages;
+    SEMP_SPLIT_MESSAGE *message;
+
+    // Deliver the chunks in order
+    messages = 0;
+    while (splitter && (splitter->deliverChunk < splitter->chunkCount))
+    {
+        chunk = &splitter->chunks[splitter->deliverChunk];
+        if (!__atomic_load_n(&chunk->done, __ATOMIC_ACQUIRE))
+            break;
+
+        // Skip the messages found within the previous chunk or message
+        for (index = 0; index < chunk->messageCount; index++)
+        {
+            message = &chunk->messages[index];
+            if (message->offset < splitter->deliveredEnd)
+                continue;
+            splitter->deliveredEnd = message->offset + message->length;
+            splitter->callback(&splitter->data[message->offset],
+                               message->offset,
+                               message->length,
+                               message->type);
+            messages += 1;
+        }
+
+        // The next chunk starts after the parser becomes idle
+        if (splitter->deliveredEnd < chunk->resumeOffset)
+            splitter->deliveredEnd = chunk->resumeOffset;
+
+        // Done with this chunk
+        free(chunk->messages);
+        chunk->messages = nullptr;
+        splitter->deliverChunk += 1;
+    }
+    return messages;
+}
+
+// Determine if all of the chunks have been delivered
+bool sempSplitterComplete(const SEMP_SPLITTER *splitter)
+{
+    return (!splitter) || (splitter->deliverChunk >= splitter->chunkCount);
+}
+
+// Shutdown the splitter
+void sempStopSplitter(SEMP_SPLITTER **splitter)
+{
+    uint32_t index;
+
+    if (splitter && *splitter)
+    {
+        // Free the messages that were not delivered
+        for (index = 0; index < (*splitter)->chunkCount; index++)
+            free((*splitter)->chunks[index].messages);
+        free(*splitter);
+        *splitter = nullptr;
+    }
+}
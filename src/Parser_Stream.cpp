@@ -0,0 +1,128 @@
+/*------------------------------------------------------------------------------
+Parser_Stream.cpp
+
+Parse a data stream read from a file descriptor
+
+The data is read with readv directly into the free space of the stream's
+input ring and parsed from the ring, avoiding a copy and the per byte
+calls.  The messages are placed into the stream's output ring, allowing
+an event loop to read many streams and to remove the messages of each
+stream after reading it.
+
+License: MIT. Please see LICENSE.md for more details
+------------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "SparkFun_Extensible_Message_Parser.h"
+
+#if SEMP_STREAM_FD
+
+#include <errno.h>
+#include <sys/uio.h>
+
+//----------------------------------------
+// Support routines
+//----------------------------------------
+
+// Place the message into the output ring of the stream
+void sempStreamEom(SEMP_PARSE_STATE *parse, uint16_t type)
+{
+    SEMP_PARSE_STATE *owner;
+    SEMP_STREAM *stream;
+
+    // Parallel parsers deliver the message using their own parse structure
+    owner = parse->features->parent ? parse->features->parent : parse;
+    stream = owner->features->stream;
+    if (!sempMessageRingWrite(&stream->output, stream->number, type,
+                              parse->buffer, parse->length))
+        stream->droppedMessages += 1;
+}
+
+//----------------------------------------
+// Stream routines
+//----------------------------------------
+
+// Initialize a stream, returns true when successful
+bool sempStreamInit(SEMP_STREAM *stream,
+                    SEMP_PARSE_STATE *parse,
+                    int fd,
+                    uint16_t number,
+                    uint8_t *inputStorage,
+                    uint32_t inputBytes,
+                    uint8_t *outputStorage,
+                    uint32_t outputBytes)
+{
+    if ((!stream) || (!parse) || (fd < 0))
+        return false;
+    memset(stream, 0, sizeof(*stream));
+    if ((!sempByteRingInit(&stream->input, inputStorage, inputBytes))
+        || (!sempMessageRingInit(&stream->output, outputStorage, outputBytes)))
+    {
+        SEMP_ERROR_PRINTLN(parse->printError, "SEMP: Invalid stream ring storage");
+        return false;
+    }
+    stream->parse = parse;
+    stream->fd = fd;
+    stream->number = number;
+
+    // Route the messages into the output ring
+    parse->eomCallback = sempStreamEom;
+    parse->features->stream = stream;
+    return true;
+}
+
+// Read and parse the available data, returns the number of bytes read,
+// zero (0) at the end of the file or -1 upon error
+ssize_t sempStreamRead(SEMP_STREAM *stream)
+{
+    ssize_t bytes;
+    struct iovec iov[2];
+    int iovcnt;
+    uint32_t offset;
+    SEMP_BYTE_RING *ring;
+    size_t space;
+
+    if (!stream)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    // Describe the free space of the input ring, wrapping around the end
+    // of the storage
+    ring = &stream->input;
+    offset = ring->head & (ring->size - 1);
+    space = ring->size - (ring->head - ring->tail);
+    iov[0].iov_base = &ring->data[offset];
+    iov[0].iov_len = SEMP_MIN(space, ring->size - offset);
+    iov[1].iov_base = ring->data;
+    iov[1].iov_len = space - iov[0].iov_len;
+    iovcnt = iov[1].iov_len ? 2 : 1;
+
+    // Read the data directly into the input ring
+    bytes = readv(stream->fd, iov, iovcnt);
+    if (bytes <= 0)
+        return bytes;
+
+    // Parse the data in the ring, placing the messages into the output ring
+    sempByteRingCommit(ring, bytes);
+    sempParseByteRing(stream->parse, ring);
+    return bytes;
+}
+
+// Get the oldest message of the stream
+const SEMP_MESSAGE_RECORD * sempStreamNextMessage(SEMP_STREAM *stream)
+{
+    if (!stream)
+        return nullptr;
+    return sempMessageRingRead(&stream->output);
+}
+
+// Remove the oldest message of the stream
+void sempStreamRelease(SEMP_STREAM *stream, const SEMP_MESSAGE_RECORD *record)
+{
+    if (stream && record)
+        sempMessageRingRelease(&stream->output, record);
+}
+
+#endif  // SEMP_STREAM_FD
@@ -12,44 +12,53 @@ License: MIT. Please see LICENSE.md for more details
 #include "SparkFun_Extensible_Message_Parser.h"
 #include "semp_crc32.h"
 
-//----------------------------------------
-// Constants
-//----------------------------------------
-
-#define SEMP_ALIGNMENT_MASK        7
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 //----------------------------------------
-// Macros
+// Constants
 //----------------------------------------
 
-#define SEMP_ALIGN(x)   ((x + SEMP_ALIGNMENT_MASK) & (~SEMP_ALIGNMENT_MASK))
+// Maximum number of preamble bytes compared at once by the scan routine,
+// larger counts use the preamble lookup table
+#define SEMP_SCAN_BYTES_MAX        8
 
 //----------------------------------------
 // Support routines
 //----------------------------------------
 
-// Allocate the parse structure
+// Allocate the parse structure, or use the caller's storage when specified
 SEMP_PARSE_STATE * sempAllocateParseStructure(
     Print *printDebug,
+    Print *printError,
+    void *storage,
+    size_t storageBytes,
     uint16_t scratchPadBytes,
-    size_t bufferLength
+    size_t bufferLength,
+    size_t preambleBytes,
+    size_t statsBytes
     )
 {
+    size_t bytes;
     int length;
+    size_t offset;
     SEMP_PARSE_STATE *parse = nullptr;
     int parseBytes;
 
     // Print the scratchPad area size
-    sempPrintf(printDebug, "scratchPadBytes: 0x%04x (%d) bytes",
-               scratchPadBytes, scratchPadBytes);
+    SEMP_DEBUG_PRINTF(printDebug, "scratchPadBytes: 0x%04x (%d) bytes",
+                      scratchPadBytes, scratchPadBytes);
 
     // Align the scratch patch area
     if (scratchPadBytes < SEMP_ALIGN(scratchPadBytes))
     {
         scratchPadBytes = SEMP_ALIGN(scratchPadBytes);
-        sempPrintf(printDebug,
-                   "scratchPadBytes: 0x%04x (%d) bytes after alignment",
-                   scratchPadBytes, scratchPadBytes);
+        SEMP_DEBUG_PRINTF(printDebug,
+                          "scratchPadBytes: 0x%04x (%d) bytes after alignment",
+                          scratchPadBytes, scratchPadBytes);
     }
 
     // Determine the minimum length for the scratch pad
@@ -57,26 +66,39 @@ SEMP_PARSE_STATE * sempAllocateParseStructure(
     if (scratchPadBytes < length)
     {
         scratchPadBytes = length;
-        sempPrintf(printDebug,
-                   "scratchPadBytes: 0x%04x (%d) bytes after mimimum size adjustment",
-                   scratchPadBytes, scratchPadBytes);
+        SEMP_DEBUG_PRINTF(printDebug,
+                          "scratchPadBytes: 0x%04x (%d) bytes after mimimum size adjustment",
+                          scratchPadBytes, scratchPadBytes);
     }
     parseBytes = SEMP_ALIGN(sizeof(SEMP_PARSE_STATE));
-    sempPrintf(printDebug, "parseBytes: 0x%04x (%d)", parseBytes, parseBytes);
+    SEMP_DEBUG_PRINTF(printDebug, "parseBytes: 0x%04x (%d)", parseBytes, parseBytes);
 
     // Verify the minimum bufferLength
     if (bufferLength < SEMP_MINIMUM_BUFFER_LENGTH)
     {
-        sempPrintf(printDebug,
-                   "SEMP: Increasing bufferLength from %ld to %d bytes, minimum size adjustment",
-                   bufferLength, SEMP_MINIMUM_BUFFER_LENGTH);
+        SEMP_DEBUG_PRINTF(printDebug,
+                          "SEMP: Increasing bufferLength from %ld to %d bytes, minimum size adjustment",
+                          bufferLength, SEMP_MINIMUM_BUFFER_LENGTH);
         bufferLength = SEMP_MINIMUM_BUFFER_LENGTH;
     }
 
-    // Allocate the parser
+    // Allocate the parser, the feature state, preamble tables and statistics
+    // follow the buffer
     length = parseBytes + scratchPadBytes;
-    parse = (SEMP_PARSE_STATE *)malloc(length + bufferLength);
-    sempPrintf(printDebug, "parse: %p", (void *)parse);
+    offset = SEMP_ALIGN(length + bufferLength);
+    bytes = offset + SEMP_FEATURE_STORAGE_SIZE + preambleBytes + statsBytes;
+    if (!storage)
+        parse = (SEMP_PARSE_STATE *)malloc(bytes);
+
+    // Verify the caller's storage
+    else if ((uintptr_t)storage & SEMP_ALIGNMENT_MASK)
+        SEMP_ERROR_PRINTLN(printError, "SEMP: Please align the storage on an 8 byte boundary");
+    else if (storageBytes < bytes)
+        SEMP_ERROR_PRINTF(printError, "SEMP: Please increase the storage size to %ld bytes",
+                          (long)bytes);
+    else
+        parse = (SEMP_PARSE_STATE *)storage;
+    SEMP_DEBUG_PRINTF(printDebug, "parse: %p", (void *)parse);
 
     // Initialize the parse structure
     if (parse)
@@ -85,18 +107,101 @@ SEMP_PARSE_STATE * sempAllocateParseStructure(
         memset(parse, 0, length);
 
         // Set the scratch pad area address
+        parse->callerStorage = (storage != nullptr);
         parse->scratchPad = ((uint8_t *)parse) + parseBytes;
         parse->printDebug = printDebug;
-        sempPrintf(parse->printDebug, "parse->scratchPad: %p", parse->scratchPad);
+        SEMP_DEBUG_PRINTF(parse->printDebug, "parse->scratchPad: %p", parse->scratchPad);
 
         // Set the buffer address and length
         parse->bufferLength = bufferLength;
         parse->buffer = ((uint8_t *)parse->scratchPad + scratchPadBytes);
-        sempPrintf(parse->printDebug, "parse->buffer: %p", parse->buffer);
+        parse->messageBuffer = parse->buffer;
+        SEMP_DEBUG_PRINTF(parse->printDebug, "parse->buffer: %p", parse->buffer);
+
+#if SEMP_FEATURE_STATE
+        // Set the feature state address and zero the feature state
+        parse->features = (SEMP_PARSE_FEATURES *)((uint8_t *)parse + offset);
+        memset(parse->features, 0, sizeof(SEMP_PARSE_FEATURES));
+        SEMP_DEBUG_PRINTF(parse->printDebug, "parse->features: %p", (void *)parse->features);
+        offset += SEMP_FEATURE_STORAGE_SIZE;
+#endif  // SEMP_FEATURE_STATE
+
+        // Set the preamble table address
+        if (preambleBytes)
+        {
+            parse->preambles = (int16_t *)((uint8_t *)parse + offset);
+            SEMP_DEBUG_PRINTF(parse->printDebug, "parse->preambles: %p", (void *)parse->preambles);
+        }
+
+#if SEMP_STATS
+        // Set the statistics address and zero the counters
+        parse->features->stats = (SEMP_PARSER_STATS *)((uint8_t *)parse
+                               + offset + preambleBytes);
+        memset(parse->features->stats, 0, statsBytes);
+        SEMP_DEBUG_PRINTF(parse->printDebug, "parse->features->stats: %p",
+                          (void *)parse->features->stats);
+#endif  // SEMP_STATS
     }
     return parse;
 }
 
+// Build the lookup table of the first parser to call for each data byte
+void sempBuildPreambleLookup(const SEMP_PARSE_STATE *parse)
+{
+    int data;
+    int index;
+    int16_t preamble;
+
+    // Parsers that accept any byte must see every byte
+    memset(parse->preambleLookup, (uint8_t)parse->parserCount, SEMP_PREAMBLE_LOOKUP_BYTES);
+    for (index = parse->parserCount - 1; index >= 0; index--)
+    {
+        preamble = parse->preambles[index];
+        if (preamble == SEMP_PREAMBLE_ANY)
+        {
+            for (data = 0; data < SEMP_PREAMBLE_LOOKUP_BYTES; data++)
+                parse->preambleLookup[data] = index;
+        }
+        else if (preamble != SEMP_PREAMBLE_NONE)
+            parse->preambleLookup[preamble] = index;
+    }
+
+    // Build the list of preamble bytes, the scan routine is not able
+    // to skip any bytes when a parser accepts any byte
+    parse->preambleScan[0] = 0;
+    for (data = 0; data < SEMP_PREAMBLE_LOOKUP_BYTES; data++)
+    {
+        if (parse->preambleLookup[data] < parse->parserCount)
+        {
+            if (parse->preambles[parse->preambleLookup[data]] == SEMP_PREAMBLE_ANY)
+            {
+                parse->preambleScan[0] = 0;
+                break;
+            }
+            parse->preambleScan[++parse->preambleScan[0]] = data;
+        }
+    }
+}
+
+// Allow the parser to see every data byte when searching for a preamble
+void sempPreambleAcceptsAnyByte(const SEMP_PARSE_STATE *parse,
+                                SEMP_PARSE_ROUTINE preamble)
+{
+    int index;
+
+    if (parse && parse->preambles)
+    {
+        for (index = 0; index < parse->parserCount; index++)
+        {
+            if (parse->parsers[index] == preamble)
+            {
+                parse->preambles[index] = SEMP_PREAMBLE_ANY;
+                sempBuildPreambleLookup(parse);
+            }
+        }
+    }
+}
+
 // Convert nibble to ASCII
 int sempAsciiToNibble(int data)
 {
@@ -138,7 +243,12 @@ void sempPrintParserConfiguration(SEMP_PARSE_STATE *parse, Print *print)
         sempPrintf(print, "    printDebug: %p", parse->printDebug);
         sempPrintf(print, "    Scratch Pad: %p (%ld bytes)",
                    (void *)parse->scratchPad, parse->buffer - (uint8_t *)parse->scratchPad);
+        sempPrintf(print, "    preambles: %p", (void *)parse->preambles);
+        sempPrintf(print, "    preambleLookup: %p", (void *)parse->preambleLookup);
+        sempPrintf(print, "    preambleScan: %p (%d bytes)", (void *)parse->preambleScan,
+                   parse->preambleScan ? parse->preambleScan[0] : 0);
         sempPrintf(print, "    computeCrc: %p", (void *)parse->computeCrc);
+        sempPrintf(print, "    consumeBytes: %p", (void *)parse->consumeBytes);
         sempPrintf(print, "    crc: 0x%08x", parse->crc);
         sempPrintf(print, "    State: %p%s", (void *)parse->state,
                    (parse->state == sempFirstByte) ? " (sempFirstByte)" : "");
@@ -147,6 +257,11 @@ void sempPrintParserConfiguration(SEMP_PARSE_STATE *parse, Print *print)
                    (void *)parse->buffer, parse->bufferLength);
         sempPrintf(print, "    length: %d message bytes", parse->length);
         sempPrintf(print, "    type: %d (%s)", parse->type, sempGetTypeName(parse, parse->type));
+        sempPrintf(print, "    resync: %s", parse->resync ? "Enabled" : "Disabled");
+        sempPrintf(print, "    zeroCopy: %s", parse->zeroCopy ? "Enabled" : "Disabled");
+#if SEMP_FEATURES
+        sempPrintf(print, "    parallelParsers: %p", (void *)parse->features->parallelParsers);
+#endif  // SEMP_FEATURES
     }
 }
 
@@ -187,11 +302,203 @@ void sempPrintln(Print *print, const char *string)
 // Translates state value into an ASCII state name
 const char * sempGetStateName(const SEMP_PARSE_STATE *parse)
 {
+    const char *name;
+
     if (parse && (parse->state == sempFirstByte))
         return "sempFirstByte";
+#if SEMP_FEATURES
+    if (parse && parse->features->parallelParsers)
+        return "sempParallelParse";
+#endif  // SEMP_FEATURES
+
+    // Name the state using the state table of the active parser
+    if (parse && parse->stateTables && (parse->type < parse->parserCount))
+    {
+        name = sempFindStateName(parse->stateTables[parse->type], parse->state);
+        if (name)
+            return name;
+    }
     return "Unknown state";
 }
 
+// Locate the name of a state routine in a state table
+const char * sempFindStateName(const SEMP_STATE_TABLE *table, SEMP_PARSE_ROUTINE state)
+{
+    const SEMP_STATE_NAME *end;
+    const SEMP_STATE_NAME *entry;
+
+    // The tables are a handful of entries, a scan of the contiguous
+    // routine addresses is faster than a search
+    if (table)
+    {
+        end = &table->states[table->stateCount];
+        for (entry = table->states; entry < end; entry++)
+            if (entry->state == state)
+                return entry->name;
+    }
+    return nullptr;
+}
+
+// Get the upper limit of a latency histogram bucket
+uint32_t sempGetLatencyBucketLimit(int bucket)
+{
+    if ((bucket < 0) || (bucket >= (SEMP_LATENCY_BUCKETS - 1)))
+        return 0;
+    return ((uint32_t)1) << bucket;
+}
+
+// Get the number of data bytes that no parser accepted as a preamble
+uint32_t sempGetDiscardedBytes(const SEMP_PARSE_STATE *parse)
+{
+#if SEMP_STATS
+    if (parse)
+        return parse->features->discardedBytes;
+#else   // SEMP_STATS
+    (void)parse;
+#endif  // SEMP_STATS
+    return 0;
+}
+
+// Get the statistics counters for a parser
+const SEMP_PARSER_STATS * sempGetStats(const SEMP_PARSE_STATE *parse, uint16_t type)
+{
+#if SEMP_STATS
+    if (parse && (type < parse->parserCount))
+        return &parse->features->stats[type];
+#else   // SEMP_STATS
+    (void)parse;
+    (void)type;
+#endif  // SEMP_STATS
+    return nullptr;
+}
+
+// Zero the statistics counters
+void sempResetStats(SEMP_PARSE_STATE *parse)
+{
+#if SEMP_STATS
+    if (parse)
+    {
+        memset(parse->features->stats, 0, parse->parserCount * sizeof(SEMP_PARSER_STATS));
+        parse->features->discardedBytes = 0;
+    }
+#else   // SEMP_STATS
+    (void)parse;
+#endif  // SEMP_STATS
+}
+
+#if SEMP_FEATURES
+// Disable batch delivery
+void sempDisableBatchDelivery(SEMP_PARSE_STATE *parse)
+{
+    if (parse && parse->features->batchCallback)
+    {
+        // Deliver the batched messages
+        sempFlushBatch(parse);
+        parse->features->batchCallback = nullptr;
+        parse->features->batchEntries = nullptr;
+        parse->features->batchArena = nullptr;
+    }
+}
+
+// Enable batch delivery
+void sempEnableBatchDelivery(SEMP_PARSE_STATE *parse,
+                             SEMP_BATCH_ENTRY *entries,
+                             uint16_t entryCount,
+                             uint8_t *arena,
+                             uint32_t arenaBytes,
+                             SEMP_BATCH_CALLBACK callback,
+                             bool eachBuffer)
+{
+    SEMP_PARSE_FEATURES *features;
+
+    if (parse && entries && entryCount && arena && arenaBytes && callback)
+    {
+        sempDisableBatchDelivery(parse);
+        features = parse->features;
+        features->batchEntries = entries;
+        features->batchEntryCount = entryCount;
+        features->batchArena = arena;
+        features->batchArenaBytes = arenaBytes;
+        features->batchArenaUsed = 0;
+        features->batchCount = 0;
+        features->batchEachBuffer = eachBuffer;
+        features->batchCallback = callback;
+    }
+}
+
+// Disable the binary log
+void sempDisableBinaryLog(SEMP_PARSE_STATE *parse)
+{
+    if (parse)
+    {
+        parse->features->logEntries = nullptr;
+        parse->features->logEntryCount = 0;
+    }
+}
+
+// Enable the binary log
+void sempEnableBinaryLog(SEMP_PARSE_STATE *parse,
+                         SEMP_LOG_ENTRY *entries,
+                         uint16_t entryCount)
+{
+    SEMP_PARSE_FEATURES *features;
+
+    if (parse && entries && entryCount)
+    {
+        features = parse->features;
+        features->logHead = 0;
+        features->logTail = 0;
+        features->logDropped = 0;
+        features->logEntryCount = entryCount;
+        features->logEntries = entries;
+    }
+}
+
+// Disable forwarding
+void sempDisableForwarding(SEMP_PARSE_STATE *parse)
+{
+    if (parse)
+    {
+        // Abort the message being forwarded
+        if (parse->forwardSink && parse->forwardOffset && parse->forwardSink->end)
+            parse->forwardSink->end(parse, parse->forwardSink->context, false);
+        parse->forwardSink = nullptr;
+        parse->features->forwardSinks = nullptr;
+    }
+}
+
+// Enable forwarding
+void sempEnableForwarding(SEMP_PARSE_STATE *parse,
+                          const SEMP_FORWARD_SINK *sinkTable)
+{
+    if (parse && sinkTable)
+        parse->features->forwardSinks = sinkTable;
+}
+
+// Disable the message filters
+void sempDisableMessageFilter(SEMP_PARSE_STATE *parse)
+{
+    if (parse)
+    {
+        parse->features->filters = nullptr;
+        parse->validateFiltered = false;
+    }
+}
+
+// Enable the message filters
+void sempEnableMessageFilter(SEMP_PARSE_STATE *parse,
+                             const SEMP_MESSAGE_FILTER *filterTable,
+                             bool validate)
+{
+    if (parse && filterTable)
+    {
+        parse->validateFiltered = validate;
+        parse->features->filters = filterTable;
+    }
+}
+
+#endif  // SEMP_FEATURES
+
 // Disable debug output
 void sempDisableDebugOutput(SEMP_PARSE_STATE *parse)
 {
@@ -206,6 +513,34 @@ void sempEnableDebugOutput(SEMP_PARSE_STATE *parse, Print *print)
         parse->printDebug = print;
 }
 
+// Disable resynchronization
+void sempDisableResync(SEMP_PARSE_STATE *parse)
+{
+    if (parse)
+        parse->resync = false;
+}
+
+// Enable resynchronization
+void sempEnableResync(SEMP_PARSE_STATE *parse)
+{
+    if (parse)
+        parse->resync = true;
+}
+
+// Disable zero-copy parsing
+void sempDisableZeroCopy(SEMP_PARSE_STATE *parse)
+{
+    if (parse)
+        parse->zeroCopy = false;
+}
+
+// Enable zero-copy parsing
+void sempEnableZeroCopy(SEMP_PARSE_STATE *parse)
+{
+    if (parse)
+        parse->zeroCopy = true;
+}
+
 // Disable error output
 void sempDisableErrorOutput(SEMP_PARSE_STATE *parse)
 {
@@ -224,8 +559,12 @@ void sempEnableErrorOutput(SEMP_PARSE_STATE *parse, Print *print)
 // Parse routines
 //----------------------------------------
 
-// Initialize the parser
-SEMP_PARSE_STATE *sempBeginParser(
+// Initialize the parser in the caller's storage, allocate it when nullptr.
+// The parallel parsers specify zero (0) statsBytes and share the statistics
+// of their parent.
+SEMP_PARSE_STATE *sempInitializeParser(
+    void *storage,
+    size_t storageBytes,
     const SEMP_PARSE_ROUTINE *parserTable,
     uint16_t parserCount,
     const char * const *parserNameTable,
@@ -236,60 +575,90 @@ SEMP_PARSE_STATE *sempBeginParser(
     const char *parserName,
     Print *printError,
     Print *printDebug,
-    SEMP_BAD_CRC_CALLBACK badCrc
+    SEMP_BAD_CRC_CALLBACK badCrc,
+    const int16_t *preambleTable,
+    const SEMP_STATE_TABLE * const *stateTables,
+    size_t statsBytes
     )
 {
+    int index;
     SEMP_PARSE_STATE *parse = nullptr;
+    size_t preambleBytes;
 
     do
     {
         // Validate the parse type names table
         if (parserCount != parserNameCount)
         {
-            sempPrintln(printError, "SEMP: Please fix parserTable and parserNameTable parserCount != parserNameCount");
+            SEMP_ERROR_PRINTLN(printError, "SEMP: Please fix parserTable and parserNameTable parserCount != parserNameCount");
             break;
         }
 
         // Validate the parserTable address is not nullptr
         if (!parserTable)
         {
-            sempPrintln(printError, "SEMP: Please specify a parserTable data structure");
+            SEMP_ERROR_PRINTLN(printError, "SEMP: Please specify a parserTable data structure");
             break;
         }
 
         // Validate the parserNameTable address is not nullptr
         if (!parserNameTable)
         {
-            sempPrintln(printError, "SEMP: Please specify a parserNameTable data structure");
+            SEMP_ERROR_PRINTLN(printError, "SEMP: Please specify a parserNameTable data structure");
             break;
         }
 
         // Validate the end-of-message callback routine address is not nullptr
         if (!eomCallback)
         {
-            sempPrintln(printError, "SEMP: Please specify an eomCallback routine");
+            SEMP_ERROR_PRINTLN(printError, "SEMP: Please specify an eomCallback routine");
             break;
         }
 
         // Verify the parser name
         if ((!parserName) || (!strlen(parserName)))
         {
-            sempPrintln(printError, "SEMP: Please provide a name for the parser");
+            SEMP_ERROR_PRINTLN(printError, "SEMP: Please provide a name for the parser");
             break;
         }
 
         // Verify that there is at least one parser in the table
         if (!parserCount)
         {
-            sempPrintln(printError, "SEMP: Please provide at least one parser in parserTable");
+            SEMP_ERROR_PRINTLN(printError, "SEMP: Please provide at least one parser in parserTable");
             break;
         }
 
+        // Validate the preamble table
+        preambleBytes = 0;
+        if (preambleTable)
+        {
+            // The lookup table holds a parser index in a byte
+            if (parserCount >= 0xff)
+            {
+                SEMP_ERROR_PRINTLN(printError, "SEMP: Please reduce parserCount to less than 255 when using a preambleTable");
+                break;
+            }
+            for (index = 0; index < parserCount; index++)
+                if ((preambleTable[index] != SEMP_PREAMBLE_ANY)
+                    && (preambleTable[index] != SEMP_PREAMBLE_NONE)
+                    && ((preambleTable[index] < 0) || (preambleTable[index] > 0xff)))
+                    break;
+            if (index < parserCount)
+            {
+                SEMP_ERROR_PRINTLN(printError, "SEMP: Please fix preambleTable, entries must be SEMP_PREAMBLE_ANY, SEMP_PREAMBLE_NONE or 0 - 255");
+                break;
+            }
+            preambleBytes = SEMP_PREAMBLE_STORAGE_SIZE(parserCount);
+        }
+
         // Validate the parser address is not nullptr
-        parse = sempAllocateParseStructure(printDebug, scratchPadBytes, bufferLength);
+        parse = sempAllocateParseStructure(printDebug, printError, storage, storageBytes,
+                                           scratchPadBytes, bufferLength, preambleBytes,
+                                           statsBytes);
         if (!parse)
         {
-            sempPrintln(printError, "SEMP: Failed to allocate the parse structure");
+            SEMP_ERROR_PRINTLN(printError, "SEMP: Failed to allocate the parse structure");
             break;
         }
 
@@ -302,84 +671,1471 @@ SEMP_PARSE_STATE *sempBeginParser(
         parse->eomCallback = eomCallback;
         parse->parserName = parserName;
         parse->badCrc = badCrc;
+        parse->stateTables = stateTables;
+
+        // Build the preamble lookup table
+        if (preambleTable)
+        {
+            memcpy(parse->preambles, preambleTable, parserCount * sizeof(int16_t));
+            parse->preambleLookup = ((uint8_t *)parse->preambles)
+                                  + SEMP_ALIGN(parserCount * sizeof(int16_t));
+            parse->preambleScan = parse->preambleLookup + SEMP_PREAMBLE_LOOKUP_BYTES;
+            sempBuildPreambleLookup(parse);
+        }
 
         // Display the parser configuration
-        sempPrintParserConfiguration(parse, parse->printDebug);
+        if (SEMP_LOG_LEVEL >= SEMP_LOG_LEVEL_DEBUG)
+            sempPrintParserConfiguration(parse, parse->printDebug);
     } while (0);
 
     // Return the parse structure address
     return parse;
 }
 
-// Wait for the first byte in the GPS message
-bool sempFirstByte(SEMP_PARSE_STATE *parse, uint8_t data)
+// Initialize the parser in the caller's storage, allocate it when nullptr
+SEMP_PARSE_STATE *sempBeginParserWithStorage(
+    void *storage,
+    size_t storageBytes,
+    const SEMP_PARSE_ROUTINE *parserTable,
+    uint16_t parserCount,
+    const char * const *parserNameTable,
+    uint16_t parserNameCount,
+    uint16_t scratchPadBytes,
+    size_t bufferLength,
+    SEMP_EOM_CALLBACK eomCallback,
+    const char *parserName,
+    Print *printError,
+    Print *printDebug,
+    SEMP_BAD_CRC_CALLBACK badCrc,
+    const int16_t *preambleTable,
+    const SEMP_STATE_TABLE * const *stateTables
+    )
 {
-    int index;
-    SEMP_PARSE_ROUTINE parseRoutine;
+    return sempInitializeParser(storage, storageBytes, parserTable, parserCount,
+                                parserNameTable, parserNameCount,
+                                scratchPadBytes, bufferLength,
+                                eomCallback, parserName, printError,
+                                printDebug, badCrc, preambleTable,
+                                stateTables, SEMP_STATS_STORAGE_SIZE(parserCount));
+}
 
-    if (parse)
+// Allocate and initialize the parser
+SEMP_PARSE_STATE *sempBeginParser(
+    const SEMP_PARSE_ROUTINE *parserTable,
+    uint16_t parserCount,
+    const char * const *parserNameTable,
+    uint16_t parserNameCount,
+    uint16_t scratchPadBytes,
+    size_t bufferLength,
+    SEMP_EOM_CALLBACK eomCallback,
+    const char *parserName,
+    Print *printError,
+    Print *printDebug,
+    SEMP_BAD_CRC_CALLBACK badCrc,
+    const int16_t *preambleTable,
+    const SEMP_STATE_TABLE * const *stateTables
+    )
+{
+    return sempInitializeParser(nullptr, 0, parserTable, parserCount,
+                                parserNameTable, parserNameCount,
+                                scratchPadBytes, bufferLength,
+                                eomCallback, parserName, printError,
+                                printDebug, badCrc, preambleTable,
+                                stateTables, SEMP_STATS_STORAGE_SIZE(parserCount));
+}
+
+#if SEMP_LATENCY
+// Count a time in a latency histogram
+void sempLatencyRecord(uint32_t *histogram, uint32_t ticks)
+{
+    int bucket;
+
+    // Bucket n counts the times less than 2^n ticks
+    bucket = 0;
+    while (ticks && (bucket < (SEMP_LATENCY_BUCKETS - 1)))
     {
-        // Add this byte to the buffer
-        parse->crc = 0;
-        parse->computeCrc = nullptr;
-        parse->length = 0;
-        parse->type = parse->parserCount;
-        parse->buffer[parse->length++] = data;
+        ticks >>= 1;
+        bucket++;
+    }
+    histogram[bucket] += 1;
+}
+#endif  // SEMP_LATENCY
 
-        // Walk through the parse table
-        for (index = 0; index < parse->parserCount; index++)
-        {
-            parseRoutine = parse->parsers[index];
-            if (parseRoutine(parse, data))
-            {
-                parse->type = index;
-                return true;
-            }
-        }
+#if SEMP_FEATURES
+// Pass the message bytes not yet forwarded to the forward sink
+void sempForwardWrite(SEMP_PARSE_STATE *parse)
+{
+    if (parse->length > parse->forwardOffset)
+    {
+        parse->forwardSink->write(parse,
+                                  parse->forwardSink->context,
+                                  &parse->buffer[parse->forwardOffset],
+                                  parse->length - parse->forwardOffset);
+        parse->forwardOffset = parse->length;
+    }
+}
 
-        // Preamble byte not found, continue searching for a preamble byte
-        parse->state = sempFirstByte;
+// Pass the message bytes parsed so far to the forward sink
+void sempForwardFlush(SEMP_PARSE_STATE *parse)
+{
+    // The parallel parsers only forward the valid messages
+    if (parse->forwardSink && (!parse->features->parent))
+        sempForwardWrite(parse);
+}
+
+// Select the forward sink for the message starting with the preamble
+void sempForwardStart(SEMP_PARSE_STATE *parse)
+{
+    const SEMP_FORWARD_SINK *sink;
+    const SEMP_PARSE_STATE *owner;
+
+    // The parallel parsers use the sinks of their parent
+    owner = parse->features->parent ? parse->features->parent : parse;
+    parse->forwardSink = nullptr;
+    parse->forwardOffset = 0;
+    if (owner->features->forwardSinks)
+    {
+        sink = &owner->features->forwardSinks[parse->type];
+        if (sink->write)
+            parse->forwardSink = sink;
     }
-    return false;
 }
 
-// Parse the next byte
-void sempParseNextByte(SEMP_PARSE_STATE *parse, uint8_t data)
+// Commit or abort the message being forwarded
+void sempForwardEnd(SEMP_PARSE_STATE *parse, bool valid)
 {
-    if (parse)
+    const SEMP_FORWARD_SINK *sink;
+
+    // Write the rest of the valid message
+    sink = parse->forwardSink;
+    if (valid)
+        sempForwardWrite(parse);
+    parse->forwardSink = nullptr;
+
+    // Only the messages with bytes written to the sink are ended
+    if (sink->end && (valid || parse->forwardOffset))
+        sink->end(parse, sink->context, valid);
+}
+
+// Pass the batched messages to the batch callback routine
+void sempFlushBatch(SEMP_PARSE_STATE *parse)
+{
+    SEMP_PARSE_FEATURES *features;
+
+    if (parse && parse->features->batchCount)
     {
-        // Verify that enough space exists in the buffer
-        if (parse->length >= parse->bufferLength)
-        {
-            // Message too long
-            sempPrintf(parse->printError, "SEMP %s: Message too long, increase the buffer size > %d\r\n",
-                       parse->parserName,
-                       parse->bufferLength);
+        features = parse->features;
+        features->batchCallback(parse, features->batchEntries, features->batchCount, features->batchArena);
+        features->batchCount = 0;
+        features->batchArenaUsed = 0;
+    }
+}
 
-            // Start searching for a preamble byte
-            sempFirstByte(parse, data);
-            return;
-        }
+// Add a valid message to the batch
+void sempBatchMessage(SEMP_PARSE_STATE *batch, const SEMP_PARSE_STATE *parse, uint16_t type)
+{
+    SEMP_BATCH_ENTRY *entry;
+    SEMP_PARSE_FEATURES *features;
+    SEMP_BATCH_ENTRY single;
 
-        // Save the data byte
-        parse->buffer[parse->length++] = data;
+    // Deliver the batch when the arena is too full for the message
+    features = batch->features;
+    if (parse->length > (features->batchArenaBytes - features->batchArenaUsed))
+        sempFlushBatch(batch);
 
-        // Compute the CRC value for the message
-        if (parse->computeCrc)
-            parse->crc = parse->computeCrc(parse, data);
+    // Deliver a message larger than the arena by itself
+    if (parse->length > features->batchArenaBytes)
+    {
+        single.offset = 0;
+        single.id = parse->messageId;
+        single.length = parse->length;
+        single.type = type;
+        features->batchCallback(batch, &single, 1, parse->buffer);
+        return;
+    }
 
-        // Update the parser state based on the incoming byte
-        parse->state(parse, data);
+    // Copy the message into the arena
+    entry = &features->batchEntries[features->batchCount++];
+    entry->offset = features->batchArenaUsed;
+    entry->id = parse->messageId;
+    entry->length = parse->length;
+    entry->type = type;
+    memcpy(&features->batchArena[entry->offset], parse->buffer, parse->length);
+    features->batchArenaUsed += parse->length;
+
+    // Deliver the batch when all of the entries are in use
+    if (features->batchCount >= features->batchEntryCount)
+        sempFlushBatch(batch);
+}
+
+#endif  // SEMP_FEATURES
+
+// Pass a valid message to the end-of-message callback routine
+void sempDeliverMessage(SEMP_PARSE_STATE *parse)
+{
+#if SEMP_LATENCY
+    uint32_t start;
+    SEMP_PARSER_STATS *stats = nullptr;
+
+    // Record the time to parse the message
+    start = SEMP_TIMESTAMP();
+    if (parse->type < parse->parserCount)
+    {
+        stats = &parse->features->stats[parse->type];
+        sempLatencyRecord(stats->messageTime, start - parse->features->preambleTime);
+        sempLatencyRecord(stats->latency, start - parse->features->receiveTime);
+    }
+#endif  // SEMP_LATENCY
+
+#if SEMP_FEATURES
+    // Complete the message being forwarded
+    if (parse->forwardSink)
+        sempForwardEnd(parse, !parse->messageRejected);
+
+    // Drop the validated message rejected by the message filter
+    if (parse->messageRejected)
+    {
+        SEMP_STATS_ADD(parse, filtered, 1);
+        parse->messageStarted = false;
+        return;
     }
+#endif  // SEMP_FEATURES
+
+    SEMP_STATS_ADD(parse, messages, 1);
+    SEMP_STATS_ADD(parse, bytes, parse->length);
+    parse->messageStarted = false;
+#if SEMP_FEATURES
+    if (parse->features->batchCallback)
+        sempBatchMessage(parse, parse, parse->type);
+    else
+#endif  // SEMP_FEATURES
+        parse->eomCallback(parse, parse->type); // Pass parser array index
+
+#if SEMP_LATENCY
+    // Record the time spent in the callback
+    if (stats)
+        sempLatencyRecord(stats->callbackTime, SEMP_TIMESTAMP() - start);
+#endif  // SEMP_LATENCY
+}
+
+// Start searching for a preamble byte
+void sempResetParser(SEMP_PARSE_STATE *parse)
+{
+#if SEMP_FEATURES
+    parse->forwardSink = nullptr;
+#endif  // SEMP_FEATURES
+    parse->crc = 0;
+    parse->computeCrc = nullptr;
+    parse->consumeBytes = nullptr;
+    parse->length = 0;
+    parse->type = parse->parserCount;
+    parse->state = sempFirstByte;
+}
+
+// Move the message being parsed in place into the parse buffer
+void sempCopyInPlaceMessage(SEMP_PARSE_STATE *parse, uint32_t length)
+{
+    memcpy(parse->messageBuffer, parse->buffer, length);
+    parse->buffer = parse->messageBuffer;
+    parse->inPlace = false;
 }
 
+// Parse the bytes of a failed message again, starting after the preamble
+bool sempResync(SEMP_PARSE_STATE *parse, uint8_t data)
+{
+    uint8_t byte;
+    uint8_t next[2];
+    uint32_t tail;
+
+    // Count the rescan against the failed parser
+    SEMP_STATS_ADD(parse, resyncs, 1);
+
+    // The caller's buffer is not modified, rescan from the parse buffer
+    if (parse->inPlace)
+        sempCopyInPlaceMessage(parse, parse->dataIndex + 1);
+
+    // The current data byte is the last byte of the failed message
+    parse->messageStarted = false;
+    parse->buffer[parse->dataIndex] = data;
+
+    // Already rescanning, place the bytes remaining to be rescanned after
+    // the bytes of the failed message and continue in the rescan loop
+    if (parse->resyncEnd)
+    {
+        tail = parse->resyncEnd - parse->resyncCursor;
+        memmove(&parse->buffer[parse->dataIndex + 1],
+                &parse->buffer[parse->resyncCursor],
+                tail);
+        parse->resyncCursor = 1;
+        parse->resyncEnd = parse->dataIndex + 1 + tail;
+        sempResetParser(parse);
+        return false;
+    }
+
+    // The bytes are read from the buffer ahead of where the message
+    // bytes are saved, so the bytes are parsed in place
+    parse->resyncCursor = 1;
+    parse->resyncEnd = parse->dataIndex + 1;
+    sempResetParser(parse);
+    while (parse->resyncCursor < parse->resyncEnd)
+    {
+        byte = parse->buffer[parse->resyncCursor++];
+
+        // The ASCII parsers replace the line termination with a carriage
+        // return and line feed and zero terminate the sentence, which may
+        // overwrite the next two bytes
+        tail = SEMP_MIN(parse->resyncEnd - parse->resyncCursor, sizeof(next));
+        memcpy(next, &parse->buffer[parse->resyncCursor], tail);
+
+        // Save the data byte
+        parse->dataIndex = parse->length;
+        parse->buffer[parse->length++] = byte;
+
+        // Compute the CRC value for the message
+        if (parse->computeCrc)
+            parse->crc = parse->computeCrc(parse, byte);
+
+        // Update the parser state based on the incoming byte
+        parse->state(parse, byte);
+
+        // Restore the next bytes unless the remaining bytes were moved
+        if (parse->resyncCursor != 1)
+            memcpy(&parse->buffer[parse->resyncCursor], next, tail);
+    }
+    parse->resyncEnd = 0;
+    return parse->messageStarted;
+}
+
+// Wait for the first byte in the GPS message
+bool sempFirstByte(SEMP_PARSE_STATE *parse, uint8_t data)
+{
+    int index;
+    SEMP_PARSE_ROUTINE parseRoutine;
+
+    if (parse)
+    {
+        // A parser that passes the message to parse->eomCallback directly
+        // returns to this state without reporting a failure, the message
+        // is complete and must not be parsed again
+        if (parse->messageStarted && (parse->state == sempFirstByte) && (!parse->messageFailed))
+            parse->messageStarted = false;
+
+#if SEMP_FEATURES
+        // Abort the failed message being forwarded
+        if (parse->forwardSink)
+            sempForwardEnd(parse, false);
+#endif  // SEMP_FEATURES
+
+        // Parse the bytes of the failed message again
+        if (parse->resync && parse->messageStarted && parse->dataIndex)
+            return sempResync(parse, data);
+        parse->messageStarted = false;
+#if SEMP_FEATURES
+        parse->messageRejected = false;
+#endif  // SEMP_FEATURES
+        parse->messageFailed = false;
+        parse->messageId = 0;
+
+        // Add this byte to the buffer
+        parse->crc = 0;
+        parse->computeCrc = nullptr;
+        parse->consumeBytes = nullptr;
+        parse->length = 0;
+        parse->type = parse->parserCount;
+        if (parse->inPlace)
+        {
+            // Start the message at this byte in the caller's buffer
+            parse->buffer = parse->inPlaceData;
+            parse->length++;
+        }
+        else
+            parse->buffer[parse->length++] = data;
+
+        // Determine the first parser that may accept this byte
+        index = 0;
+        if (parse->preambleLookup)
+            index = parse->preambleLookup[data];
+
+        // Walk through the parse table
+        for (; index < parse->parserCount; index++)
+        {
+            // Skip the parsers that don't accept this byte as a preamble
+            if (parse->preambles
+                && (parse->preambles[index] != data)
+                && (parse->preambles[index] != SEMP_PREAMBLE_ANY))
+                continue;
+
+            parseRoutine = parse->parsers[index];
+            if (parseRoutine(parse, data))
+            {
+#if SEMP_LATENCY
+                parse->features->preambleTime = SEMP_TIMESTAMP();
+#endif  // SEMP_LATENCY
+                parse->type = index;
+                parse->messageStarted = true;
+
+                // Locate the preamble in the caller's buffer, the bytes
+                // remaining to rescan and any pending data byte follow it
+                if (parse->zeroCopy)
+                    parse->messageStart = parse->inPlaceData - parse->resyncPending
+                                        - (parse->resyncEnd ? (parse->resyncEnd - parse->resyncCursor) : 0);
+#if SEMP_FEATURES
+                if (parse->features->forwardSinks || parse->features->parent)
+                    sempForwardStart(parse);
+#endif  // SEMP_FEATURES
+                return true;
+            }
+        }
+
+        // Preamble byte not found, continue searching for a preamble byte
+        SEMP_STATS_DISCARD(parse, 1);
+        parse->state = sempFirstByte;
+    }
+    return false;
+}
+
+// Record a failed message in the binary log
+void sempLogEvent(SEMP_PARSE_STATE *parse,
+                  uint8_t event,
+                  uint32_t received,
+                  uint32_t computed)
+{
+#if SEMP_FEATURES
+    SEMP_LOG_ENTRY *entry;
+    SEMP_PARSE_FEATURES *features;
+    uint16_t head;
+
+    // Abort the failed message being forwarded
+    if (parse->forwardSink)
+        sempForwardEnd(parse, false);
+#endif  // SEMP_FEATURES
+
+    // Don't treat the failed message as delivered by the parser
+    parse->messageFailed = true;
+
+    // Count the failure
+    switch (event)
+    {
+    case SEMP_EVENT_BAD_CRC:
+        SEMP_STATS_ADD(parse, badCrc, 1);
+        break;
+    case SEMP_EVENT_INVALID_DATA:
+        SEMP_STATS_ADD(parse, invalidData, 1);
+        break;
+    case SEMP_EVENT_TOO_LONG:
+        SEMP_STATS_ADD(parse, tooLong, 1);
+        break;
+    case SEMP_EVENT_BAD_HEADER:
+        SEMP_STATS_ADD(parse, badHeader, 1);
+        break;
+    }
+
+#if SEMP_FEATURES
+    // Record the failure in the binary log
+    features = parse->features;
+    if (features->logEntries)
+    {
+        // Save the event
+        entry = &features->logEntries[features->logHead];
+        entry->received = received;
+        entry->computed = computed;
+        entry->length = (uint16_t)SEMP_MIN(parse->length, 0xffff);
+        entry->event = event;
+        entry->type = parse->type;
+
+        // Overwrite the oldest entry when the ring buffer is full
+        head = features->logHead + 1;
+        if (head >= features->logEntryCount)
+            head = 0;
+        if (head == features->logTail)
+        {
+            features->logTail = head + 1;
+            if (features->logTail >= features->logEntryCount)
+                features->logTail = 0;
+            features->logDropped += 1;
+        }
+        features->logHead = head;
+    }
+#else   // SEMP_FEATURES
+    (void)received;
+    (void)computed;
+#endif  // SEMP_FEATURES
+}
+
+#if SEMP_FEATURES
+// Remove the oldest entry from the binary log
+bool sempReadBinaryLog(SEMP_PARSE_STATE *parse, SEMP_LOG_ENTRY *entry)
+{
+    SEMP_PARSE_FEATURES *features;
+
+    // Determine if an entry is available
+    if (!parse)
+        return false;
+    features = parse->features;
+    if ((!features->logEntries) || (features->logTail == features->logHead))
+        return false;
+
+    // Return the oldest entry
+    *entry = features->logEntries[features->logTail];
+    features->logTail += 1;
+    if (features->logTail >= features->logEntryCount)
+        features->logTail = 0;
+    return true;
+}
+#endif  // SEMP_FEATURES
+
+// Copy a run of data bytes into the buffer
+size_t sempBufferBytes(SEMP_PARSE_STATE *parse, const uint8_t *data,
+                       size_t length, size_t maximum)
+{
+    size_t bytes;
+
+    // Limit the copy to the bytes the parser state accepts
+    bytes = length;
+    if (bytes > maximum)
+        bytes = maximum;
+
+    // Limit the copy to the space remaining in the buffer
+    if (bytes > (parse->bufferLength - parse->length))
+        bytes = parse->bufferLength - parse->length;
+
+    // Save the data bytes, when parsing in place they are already there
+    if (!parse->inPlace)
+        memcpy(&parse->buffer[parse->length], data, bytes);
+    parse->length += bytes;
+    return bytes;
+}
+
+// Set the high bit of each byte in the word that matches the character
+uint64_t sempSwarMatch(uint64_t word, uint8_t character)
+{
+    uint64_t value;
+
+    // A byte of value is zero when the character matches, adding 0x7f to
+    // the low seven bits sets the high bit of the nonzero bytes without
+    // carrying into the next byte
+    value = word ^ (0x0101010101010101ull * character);
+    return ~(((value & 0x7f7f7f7f7f7f7f7full) + 0x7f7f7f7f7f7f7f7full)
+             | value | 0x7f7f7f7f7f7f7f7full);
+}
+
+// Start the field index of a sentence once the sentence name is received
+void sempSentenceStartFields(SEMP_PARSE_STATE *parse, uint8_t separator)
+{
+    parse->fields.count = 0;
+    parse->fields.indexed = 0;
+    parse->fields.separator = separator;
+    sempSentenceAddField(&parse->fields, 1);
+    sempSentenceAddField(&parse->fields, parse->length);
+}
+
+// Add a field to the field index of a sentence
+void sempSentenceAddField(SEMP_SENTENCE_FIELDS *fields, size_t offset)
+{
+#if SEMP_SENTENCE_FIELD_OFFSETS
+    // Save the offsets until a field does not fit, the following fields
+    // are found by scanning
+    if ((fields->indexed == fields->count)
+        && (fields->indexed < SEMP_SENTENCE_FIELD_OFFSETS)
+        && (offset <= 0xff))
+        fields->offset[fields->indexed++] = offset;
+#else
+    (void)offset;
+#endif  // SEMP_SENTENCE_FIELD_OFFSETS
+    fields->count += 1;
+}
+
+// Buffer the sentence data before the asterisk, computing the checksum and
+// indexing the fields in a single pass
+size_t sempScanSentence(SEMP_PARSE_STATE *parse,
+                        const uint8_t *data,
+                        size_t length,
+                        size_t maximum,
+                        SEMP_SENTENCE_FIELDS *fields)
+{
+    uint8_t byte;
+    uint64_t checksum;
+    size_t offset;
+    uint64_t separators;
+    uint64_t word;
+
+    // Scan eight bytes at a time until reaching the word with the asterisk
+    if (length > maximum)
+        length = maximum;
+    checksum = 0;
+    offset = 0;
+    while ((length - offset) >= sizeof(word))
+    {
+        word = sempReadU8Le(&data[offset]);
+        if (sempSwarMatch(word, '*'))
+            break;
+        checksum ^= word;
+
+        // Add a field after each of the separators
+        if (fields)
+        {
+            separators = sempSwarMatch(word, ',');
+            if (fields->separator != ',')
+                separators |= sempSwarMatch(word, fields->separator);
+            while (separators)
+            {
+                sempSentenceAddField(fields, parse->length + offset
+                                             + (__builtin_ctzll(separators) >> 3) + 1);
+                separators &= separators - 1;
+            }
+        }
+        offset += sizeof(word);
+    }
+
+    // Scan the remaining bytes one at a time, leaving the asterisk for
+    // the parser state
+    for (; offset < length; offset++)
+    {
+        byte = data[offset];
+        if (byte == '*')
+            break;
+        checksum ^= byte;
+        if (fields && ((byte == ',') || (byte == fields->separator)))
+            sempSentenceAddField(fields, parse->length + offset + 1);
+    }
+
+    // Fold the checksum bytes together
+    checksum ^= checksum >> 32;
+    checksum ^= checksum >> 16;
+    checksum ^= checksum >> 8;
+    parse->crc ^= (uint8_t)checksum;
+    return sempBufferBytes(parse, data, offset, offset);
+}
+
+// Determine the length of the sentence without the line termination
+uint32_t sempSentenceLength(const SEMP_PARSE_STATE *parse)
+{
+    uint32_t length;
+
+    // The checksum characters precede the carriage return and line feed
+    length = parse->length;
+    while (length && ((parse->buffer[length - 1] == '\r')
+                      || (parse->buffer[length - 1] == '\n')))
+        length -= 1;
+    return length;
+}
+
+// End a valid sentence with a carriage return and line feed
+void sempTerminateSentence(SEMP_PARSE_STATE *parse, uint32_t received)
+{
+    // Keep the line termination when the sentence was received with a
+    // carriage return followed by a line feed
+    if ((received == (parse->length + 2)) && (parse->buffer[parse->length] == '\r'))
+        parse->length = received;
+    else
+    {
+        // The caller's buffer must not be modified
+        if (parse->inPlace)
+            sempCopyInPlaceMessage(parse, parse->length);
+        parse->buffer[parse->length++] = '\r';
+        parse->buffer[parse->length++] = '\n';
+    }
+
+    // Zero terminate the sentence in the parse buffer when space remains,
+    // don't count this in the length
+    if ((!parse->inPlace) && (parse->length < parse->bufferLength))
+        parse->buffer[parse->length] = 0;
+}
+
+// Count the fields of the sentence in the buffer and locate the asterisk
+void sempSentenceCountFields(const SEMP_PARSE_STATE *parse,
+                             SEMP_SENTENCE_FIELDS *fields,
+                             uint8_t separator)
+{
+    uint8_t byte;
+    uint32_t offset;
+
+    // The sentence name starts after the preamble
+    fields->count = 1;
+    fields->indexed = 0;
+    fields->separator = separator;
+    for (offset = 1; offset < parse->length; offset++)
+    {
+        byte = parse->buffer[offset];
+        if (byte == '*')
+            break;
+        if ((byte == ',') || (byte == separator))
+            fields->count += 1;
+    }
+    fields->end = offset;
+}
+
+// Get a field of the sentence in the buffer using the field index
+const char * sempSentenceGetField(const SEMP_PARSE_STATE *parse,
+                                  const SEMP_SENTENCE_FIELDS *fields,
+                                  uint16_t field,
+                                  size_t *length)
+{
+    const uint8_t *data;
+    const uint8_t *end;
+    uint16_t index;
+    const uint8_t *start;
+
+    if (field >= fields->count)
+        return nullptr;
+
+    // Locate the start of the field, scanning past the last offset in the
+    // index when necessary
+    end = &parse->buffer[fields->end];
+    index = 0;
+    start = &parse->buffer[1];
+#if SEMP_SENTENCE_FIELD_OFFSETS
+    if (fields->indexed)
+    {
+        index = SEMP_MIN(field, fields->indexed - 1);
+        start = &parse->buffer[fields->offset[index]];
+    }
+#endif  // SEMP_SENTENCE_FIELD_OFFSETS
+    for (; index < field; index++)
+    {
+        while ((*start != ',') && (*start != fields->separator))
+            start++;
+        start++;
+    }
+
+    // Locate the end of the field
+    if ((field + 1) >= fields->count)
+        data = end;
+#if SEMP_SENTENCE_FIELD_OFFSETS
+    else if ((field + 1) < fields->indexed)
+        data = &parse->buffer[fields->offset[field + 1] - 1];
+#endif  // SEMP_SENTENCE_FIELD_OFFSETS
+    else
+    {
+        data = start;
+        while ((*data != ',') && (*data != fields->separator))
+            data++;
+    }
+    if (length)
+        *length = data - start;
+    return (const char *)start;
+}
+
+#if SEMP_FEATURES
+// Determine if the message filter rejects the message
+bool sempMessageRejected(const SEMP_PARSE_STATE *parse, uint32_t id, const char *name)
+{
+    const SEMP_MESSAGE_FILTER *filter;
+    int index;
+    bool listed;
+    const SEMP_PARSE_STATE *owner;
+
+    // The parallel parsers use the filters of their parent
+    owner = parse->features->parent ? parse->features->parent : parse;
+    if ((!owner->features->filters) || (parse->type >= parse->parserCount))
+        return false;
+    filter = &owner->features->filters[parse->type];
+
+    // Determine if the message is listed in the filter, the sentences
+    // use the bitmap when no names are listed
+    listed = false;
+    if (name && filter->nameCount)
+    {
+        for (index = 0; index < filter->nameCount; index++)
+            if (strcmp(name, filter->names[index]) == 0)
+            {
+                listed = true;
+                break;
+            }
+    }
+    else if (filter->bitmap && (id < filter->idCount))
+        listed = (filter->bitmap[id >> 3] >> (id & 7)) & 1;
+    return (listed != filter->accept);
+}
+
+// Done skipping the rejected message
+bool sempSkipDone(SEMP_PARSE_STATE *parse)
+{
+    // Start searching for a preamble byte, don't parse the message again
+    parse->consumeBytes = nullptr;
+    parse->messageStarted = false;
+    parse->state = sempFirstByte;
+    return true;
+}
+
+// Skip the bytes of a rejected message
+bool sempSkipBytes(SEMP_PARSE_STATE *parse, uint8_t data)
+{
+    SEMP_PARSE_FEATURES *features;
+
+    // Don't save the data byte
+    parse->length -= 1;
+
+    // Skip the text through the terminator
+    features = parse->features;
+    if (features->skipTerminator >= 0)
+    {
+        if (data == features->skipTerminator)
+        {
+            features->skipTerminator = -1;
+            features->skipRemaining = features->skipTrailer;
+            return features->skipRemaining ? true : sempSkipDone(parse);
+        }
+
+        // The text would not have fit in the buffer
+        if (--features->skipRemaining == 0)
+        {
+            sempLogEvent(parse, SEMP_EVENT_TOO_LONG, 0, 0);
+            SEMP_ERROR_PRINTF(parse->printError, "SEMP %s: Message too long, increase the buffer size > %d\r\n",
+                              parse->parserName,
+                              parse->bufferLength);
+            parse->messageStarted = false;
+            return sempFirstByte(parse, data);
+        }
+        return true;
+    }
+
+    // Skip the bytes
+    if (--features->skipRemaining)
+        return true;
+    return sempSkipDone(parse);
+}
+
+// Skip a run of bytes of a rejected message
+size_t sempSkipConsume(SEMP_PARSE_STATE *parse, const uint8_t *data, size_t length)
+{
+    size_t bytes;
+    SEMP_PARSE_FEATURES *features;
+    const uint8_t *terminator;
+
+    // Leave the last byte for sempSkipBytes
+    features = parse->features;
+    if (features->skipRemaining <= 1)
+        return 0;
+    bytes = SEMP_MIN(length, features->skipRemaining - 1);
+
+    // Stop at the terminator, sempSkipBytes handles it
+    if (features->skipTerminator >= 0)
+    {
+        terminator = (const uint8_t *)memchr(data, features->skipTerminator, bytes);
+        if (terminator)
+            bytes = terminator - data;
+    }
+    features->skipRemaining -= bytes;
+    return bytes;
+}
+
+// Skip the rest of a message rejected by the message filter
+bool sempRejectMessage(SEMP_PARSE_STATE *parse,
+                       uint32_t bytesRemaining,
+                       int16_t terminator,
+                       uint16_t trailerBytes)
+{
+    SEMP_PARSE_FEATURES *features;
+    const SEMP_PARSE_STATE *owner;
+
+    // Parse the rejected message, sempDeliverMessage drops it
+    owner = parse->features->parent ? parse->features->parent : parse;
+    if (owner->validateFiltered)
+    {
+        parse->messageRejected = true;
+        return false;
+    }
+
+    // A message length that does not fit in the buffer is likely a
+    // corrupted header, let the parser fail the message
+    if (terminator < 0)
+    {
+        if ((parse->length + bytesRemaining) > parse->bufferLength)
+            return false;
+    }
+    else if (!bytesRemaining)
+        return false;
+
+    // Skip the rest of the message, it is not forwarded
+    if (parse->forwardSink)
+        sempForwardEnd(parse, false);
+    SEMP_STATS_ADD(parse, filtered, 1);
+    SEMP_DEBUG_PRINTF(parse->printDebug, "SEMP %s: %s message rejected by the filter\r\n",
+                      parse->parserName,
+                      parse->parserNames[parse->type]);
+    parse->computeCrc = nullptr;
+    features = parse->features;
+    features->skipTerminator = terminator;
+    features->skipTrailer = trailerBytes;
+    features->skipRemaining = bytesRemaining;
+    if (!features->skipRemaining)
+        return sempSkipDone(parse);
+    parse->consumeBytes = sempSkipConsume;
+    parse->state = sempSkipBytes;
+    return true;
+}
+
+#endif  // SEMP_FEATURES
+
+// Verify that the rest of the message fits in the buffer
+bool sempMessageFits(SEMP_PARSE_STATE *parse, uint32_t bytesRemaining)
+{
+    // Without resync the message fails when it fills the buffer
+    if ((!parse->resync) || ((parse->length + bytesRemaining) <= parse->bufferLength))
+        return true;
+
+    // The length is likely from a corrupted header or a false preamble,
+    // fail the header instead of filling the buffer with the data bytes
+    sempLogEvent(parse, SEMP_EVENT_TOO_LONG, 0, 0);
+    SEMP_ERROR_PRINTF(parse->printError, "SEMP %s: Message too long, increase the buffer size > %d\r\n",
+                      parse->parserName,
+                      parse->bufferLength);
+    return false;
+}
+
+// Skip a binary message rejected by the message filter
+bool sempFilterMessage(SEMP_PARSE_STATE *parse, uint32_t id, uint32_t bytesRemaining)
+{
+    parse->messageId = id;
+#if SEMP_FEATURES
+    if (!sempMessageRejected(parse, id, nullptr))
+        return false;
+    return sempRejectMessage(parse, bytesRemaining, -1, 0);
+#else   // SEMP_FEATURES
+    (void)bytesRemaining;
+    return false;
+#endif  // SEMP_FEATURES
+}
+
+// Skip a sentence rejected by the message filter
+bool sempFilterSentence(SEMP_PARSE_STATE *parse,
+                        uint32_t id,
+                        const char *name,
+                        uint8_t terminator,
+                        uint16_t trailerBytes)
+{
+    parse->messageId = id;
+#if SEMP_FEATURES
+    if (!sempMessageRejected(parse, id, name))
+        return false;
+
+    // Limit the skipped text to the space remaining in the buffer
+    return sempRejectMessage(parse, parse->bufferLength - parse->length,
+                             terminator, trailerBytes);
+#else   // SEMP_FEATURES
+    (void)name;
+    (void)terminator;
+    (void)trailerBytes;
+    return false;
+#endif  // SEMP_FEATURES
+}
+
+// Discard a message that does not fit in the buffer
+void sempMessageTooLong(SEMP_PARSE_STATE *parse, uint8_t data)
+{
+    // Message too long, unless the message failed with its last byte
+    if (parse->state != sempFirstByte)
+    {
+        sempLogEvent(parse, SEMP_EVENT_TOO_LONG, 0, 0);
+        SEMP_ERROR_PRINTF(parse->printError, "SEMP %s: Message too long, increase the buffer size > %d\r\n",
+                          parse->parserName,
+                          parse->bufferLength);
+    }
+
+    // The discarded message filled the buffer, parse it again using its
+    // last byte, then parse the data byte since the preamble was removed.
+    // A message passed to parse->eomCallback by the parser is complete.
+    if (parse->resync && parse->messageStarted
+        && ((parse->state != sempFirstByte) || parse->messageFailed))
+    {
+        parse->dataIndex = parse->length - 1;
+        parse->resyncPending = true;
+        sempFirstByte(parse, parse->buffer[parse->dataIndex]);
+        parse->resyncPending = false;
+
+        // Save the data byte
+        parse->dataIndex = parse->length;
+        parse->buffer[parse->length++] = data;
+
+        // Compute the CRC value for the message
+        if (parse->computeCrc)
+            parse->crc = parse->computeCrc(parse, data);
+
+        // Update the parser state based on the incoming byte
+        parse->state(parse, data);
+        return;
+    }
+
+    // Start searching for a preamble byte, don't parse the message again
+    parse->messageStarted = false;
+    sempFirstByte(parse, data);
+}
+
+// Parse the next byte
+void sempParseNextByte(SEMP_PARSE_STATE *parse, uint8_t data)
+{
+    if (parse)
+    {
+#if SEMP_LATENCY
+        parse->features->receiveTime = SEMP_TIMESTAMP();
+#endif  // SEMP_LATENCY
+
+        // Verify that enough space exists in the buffer
+        if (parse->length >= parse->bufferLength)
+        {
+            sempMessageTooLong(parse, data);
+            return;
+        }
+
+        // Save the data byte
+        parse->dataIndex = parse->length;
+        parse->buffer[parse->length++] = data;
+
+        // Compute the CRC value for the message
+        if (parse->computeCrc)
+            parse->crc = parse->computeCrc(parse, data);
+
+        // Update the parser state based on the incoming byte
+        parse->state(parse, data);
+
+#if SEMP_FEATURES
+        // Forward the data byte
+        if (parse->forwardSink)
+            sempForwardFlush(parse);
+#endif  // SEMP_FEATURES
+    }
+}
+
+// Locate the next data byte that is a preamble for one of the parsers
+const uint8_t * sempScanForPreamble(const SEMP_PARSE_STATE *parse,
+                                    const uint8_t *data,
+                                    const uint8_t *end)
+{
+    int count;
+    int index;
+
+    count = parse->preambleScan[0];
+    if (count <= SEMP_SCAN_BYTES_MAX)
+    {
+#if defined(__AVX2__)
+        // Compare 32 data bytes at a time with each of the preamble bytes
+        __m256i block;
+        uint32_t found;
+        __m256i match;
+        __m256i preamble[SEMP_SCAN_BYTES_MAX];
+
+        for (index = 0; index < count; index++)
+            preamble[index] = _mm256_set1_epi8((char)parse->preambleScan[index + 1]);
+        while ((end - data) >= 32)
+        {
+            block = _mm256_loadu_si256((const __m256i *)data);
+            match = _mm256_cmpeq_epi8(block, preamble[0]);
+            for (index = 1; index < count; index++)
+                match = _mm256_or_si256(match, _mm256_cmpeq_epi8(block, preamble[index]));
+            found = (uint32_t)_mm256_movemask_epi8(match);
+            if (found)
+                return data + __builtin_ctz(found);
+            data += 32;
+        }
+#elif defined(__SSE2__)
+        // Compare 16 data bytes at a time with each of the preamble bytes
+        __m128i block;
+        uint32_t found;
+        __m128i match;
+        __m128i preamble[SEMP_SCAN_BYTES_MAX];
+
+        for (index = 0; index < count; index++)
+            preamble[index] = _mm_set1_epi8((char)parse->preambleScan[index + 1]);
+        while ((end - data) >= 16)
+        {
+            block = _mm_loadu_si128((const __m128i *)data);
+            match = _mm_cmpeq_epi8(block, preamble[0]);
+            for (index = 1; index < count; index++)
+                match = _mm_or_si128(match, _mm_cmpeq_epi8(block, preamble[index]));
+            found = (uint32_t)_mm_movemask_epi8(match);
+            if (found)
+                return data + __builtin_ctz(found);
+            data += 16;
+        }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+        // Compare 16 data bytes at a time with each of the preamble bytes
+        uint8x16_t block;
+        uint8x16_t match;
+        uint8x16_t preamble[SEMP_SCAN_BYTES_MAX];
+
+        for (index = 0; index < count; index++)
+            preamble[index] = vdupq_n_u8(parse->preambleScan[index + 1]);
+        while ((end - data) >= 16)
+        {
+            block = vld1q_u8(data);
+            match = vceqq_u8(block, preamble[0]);
+            for (index = 1; index < count; index++)
+                match = vorrq_u8(match, vceqq_u8(block, preamble[index]));
+            if (vmaxvq_u8(match))
+                break;
+            data += 16;
+        }
+#else
+        // Compare 4 data bytes at a time with each of the preamble bytes,
+        // a zero byte in x indicates a match
+        uint32_t found;
+        uint32_t word;
+        uint32_t x;
+
+        while ((end - data) >= 4)
+        {
+            memcpy(&word, data, sizeof(word));
+            found = 0;
+            for (index = 1; index <= count; index++)
+            {
+                x = word ^ (parse->preambleScan[index] * 0x01010101U);
+                found |= (x - 0x01010101) & ~x & 0x80808080;
+            }
+            if (found)
+                break;
+            data += 4;
+        }
+#endif  // __AVX2__
+    }
+
+    // Locate the preamble byte using the lookup table
+    while ((data < end) && (parse->preambleLookup[*data] >= parse->parserCount))
+        data++;
+    return data;
+}
+
+// Parse a buffer of data bytes in place
+void sempParseInPlace(SEMP_PARSE_STATE *parse, const uint8_t *data, size_t length)
+{
+    uint8_t byte;
+    size_t bytes;
+    const uint8_t *end;
+    const uint8_t *start;
+
+    // Pass each of the data bytes to the parser
+    end = &data[length];
+    while (data < end)
+    {
+        if (parse->state == sempFirstByte)
+        {
+            // Skip the data bytes that are not a preamble for any parser
+            if ((!parse->messageStarted) && parse->preambleScan && parse->preambleScan[0])
+            {
+                start = data;
+                data = sempScanForPreamble(parse, data, end);
+
+                // Pass the last skipped byte to sempFirstByte to leave the
+                // parser in the same state as parsing each of the bytes
+                if (data > start)
+                    data--;
+                SEMP_STATS_DISCARD(parse, data - start);
+            }
+
+            // Start the next message in the caller's buffer, unless the
+            // data byte is needed in the parse buffer for a rescan
+            if (!(parse->resync && parse->messageStarted))
+                parse->inPlace = true;
+        }
+
+        // Let the parser state consume a run of bytes when possible
+        if (parse->consumeBytes)
+        {
+            bytes = parse->consumeBytes(parse, data, end - data);
+            data += bytes;
+            if (data >= end)
+                break;
+        }
+
+        parse->inPlaceData = (uint8_t *)data;
+        byte = *data++;
+
+        // Verify that enough space exists in the buffer
+        if (parse->length >= parse->bufferLength)
+        {
+            sempMessageTooLong(parse, byte);
+            continue;
+        }
+
+        // Save the data byte, when parsing in place it is already there
+        parse->dataIndex = parse->length;
+        if (parse->inPlace)
+            parse->length++;
+        else
+            parse->buffer[parse->length++] = byte;
+
+        // Compute the CRC value for the message
+        if (parse->computeCrc)
+            parse->crc = parse->computeCrc(parse, byte);
+
+        // Update the parser state based on the incoming byte
+        parse->state(parse, byte);
+    }
+
+#if SEMP_FEATURES
+    // Forward the partial message before the caller reuses its buffer
+    if (parse->forwardSink)
+        sempForwardFlush(parse);
+#endif  // SEMP_FEATURES
+
+    // The caller may reuse its buffer, move the partial message into
+    // the parse buffer
+    if (parse->inPlace)
+    {
+        if ((parse->state == sempFirstByte) && (!parse->messageStarted))
+        {
+            parse->buffer = parse->messageBuffer;
+            parse->inPlace = false;
+        }
+        else
+            sempCopyInPlaceMessage(parse, parse->length);
+    }
+}
+
+// Parse a buffer of data bytes
+void sempParseBuffer(SEMP_PARSE_STATE *parse, const uint8_t *data, size_t length)
+{
+    uint8_t *buffer;
+    uint32_t bufferLength;
+    uint8_t byte;
+    size_t bytes;
+    const uint8_t *end;
+    const uint8_t *start;
+
+#if SEMP_LATENCY
+    if (parse)
+        parse->features->receiveTime = SEMP_TIMESTAMP();
+#endif  // SEMP_LATENCY
+
+    // Parse the messages in the caller's buffer
+    if (parse && data && parse->zeroCopy
+#if SEMP_FEATURES
+        && (!parse->features->parallelParsers)
+#endif  // SEMP_FEATURES
+        )
+        sempParseInPlace(parse, data, length);
+
+    else if (parse && data)
+    {
+        // The buffer does not move while parsing, keep it in locals
+        buffer = parse->buffer;
+        bufferLength = parse->bufferLength;
+
+        // Pass each of the data bytes to the parser
+        end = &data[length];
+        while (data < end)
+        {
+            // Skip the data bytes that are not a preamble for any parser
+            if ((parse->state == sempFirstByte) && (!parse->messageStarted)
+                && parse->preambleScan && parse->preambleScan[0])
+            {
+                start = data;
+                data = sempScanForPreamble(parse, data, end);
+
+                // Pass the last skipped byte to sempFirstByte to leave the
+                // parser in the same state as parsing each of the bytes
+                if (data > start)
+                    data--;
+                SEMP_STATS_DISCARD(parse, data - start);
+            }
+
+            // Let the parser state consume a run of bytes when possible
+            if (parse->consumeBytes)
+            {
+                bytes = parse->consumeBytes(parse, data, end - data);
+                data += bytes;
+                if (data >= end)
+                    break;
+            }
+
+            byte = *data++;
+
+            // Verify that enough space exists in the buffer
+            if (parse->length >= bufferLength)
+            {
+                sempMessageTooLong(parse, byte);
+                continue;
+            }
+
+            // Save the data byte
+            parse->dataIndex = parse->length;
+            buffer[parse->length++] = byte;
+
+            // Compute the CRC value for the message
+            if (parse->computeCrc)
+                parse->crc = parse->computeCrc(parse, byte);
+
+            // Update the parser state based on the incoming byte
+            parse->state(parse, byte);
+        }
+
+#if SEMP_FEATURES
+        // Forward the partial message
+        if (parse->forwardSink)
+            sempForwardFlush(parse);
+#endif  // SEMP_FEATURES
+    }
+
+#if SEMP_FEATURES
+    // Deliver the messages batched while parsing the buffer
+    if (parse && parse->features->batchEachBuffer)
+        sempFlushBatch(parse);
+#endif  // SEMP_FEATURES
+}
+
+#if SEMP_FEATURES
+// Pass the message from a parallel parser to the application
+void sempParallelEom(SEMP_PARSE_STATE *parse, uint16_t type)
+{
+    SEMP_PARSE_STATE *parent;
+
+    // Let sempParallelParse know which parser delivered the message
+    parent = parse->features->parent;
+    parent->type = type;
+    if (parent->features->batchCallback)
+        sempBatchMessage(parent, parse, type);
+    else
+        parent->eomCallback(parse, type);
+}
+
+// Pass the data byte to each of the parallel parsers
+bool sempParallelParse(SEMP_PARSE_STATE *parse, uint8_t data)
+{
+    SEMP_PARSE_STATE *child;
+    int index;
+
+    // The parallel parsers save the data bytes in their own buffers
+    parse->length = 0;
+    parse->type = parse->parserCount;
+    for (index = 0; index < parse->parserCount; index++)
+        sempParseNextByte(parse->features->parallelParsers[index], data);
+
+    // The parser delivering a message wins, reset the other parsers.  The
+    // ASCII parsers may deliver the message upon receiving the next byte,
+    // so keep the messages that start with this data byte.
+    if (parse->type < parse->parserCount)
+    {
+        for (index = 0; index < parse->parserCount; index++)
+        {
+            child = parse->features->parallelParsers[index];
+            if ((index != parse->type) && (child->length > 1))
+            {
+                sempResetParser(child);
+                child->messageStarted = false;
+            }
+        }
+    }
+    return true;
+}
+
+// Stop parsing in parallel
+void sempDisableParallelParsing(SEMP_PARSE_STATE *parse)
+{
+    int index;
+
+    if (parse && parse->features->parallelParsers)
+    {
+        // Free the parallel parsers
+        for (index = 0; index < parse->parserCount; index++)
+            sempStopParser(&parse->features->parallelParsers[index]);
+        free(parse->features->parallelParsers);
+        parse->features->parallelParsers = nullptr;
+
+        // Start searching for a preamble byte
+        sempResetParser(parse);
+        parse->messageStarted = false;
+    }
+}
+
+// Start parsing in parallel
+bool sempEnableParallelParsing(SEMP_PARSE_STATE *parse)
+{
+    SEMP_PARSE_STATE *child;
+    int index;
+    int16_t *preambleTable;
+
+    if (!parse)
+        return false;
+    if (parse->features->parallelParsers)
+        return true;
+
+    // The parallel parsers use a preamble table to select their parser
+    if (parse->parserCount >= 0xff)
+    {
+        SEMP_ERROR_PRINTLN(parse->printError, "SEMP: Please reduce parserCount to less than 255 for parallel parsing");
+        return false;
+    }
+
+    // Allocate the parallel parser array and the preamble table
+    parse->features->parallelParsers = (SEMP_PARSE_STATE **)malloc(parse->parserCount
+                                                                  * sizeof(SEMP_PARSE_STATE *));
+    preambleTable = (int16_t *)malloc(parse->parserCount * sizeof(int16_t));
+    if ((!parse->features->parallelParsers) || (!preambleTable))
+    {
+        SEMP_ERROR_PRINTLN(parse->printError, "SEMP: Failed to allocate the parallel parsers");
+        free(parse->features->parallelParsers);
+        free(preambleTable);
+        parse->features->parallelParsers = nullptr;
+        return false;
+    }
+    memset(parse->features->parallelParsers, 0, parse->parserCount * sizeof(SEMP_PARSE_STATE *));
+
+    // Each parallel parser only calls its own preamble routine
+    for (index = 0; index < parse->parserCount; index++)
+        preambleTable[index] = SEMP_PREAMBLE_NONE;
+    for (index = 0; index < parse->parserCount; index++)
+    {
+        preambleTable[index] = parse->preambles ? parse->preambles[index] : SEMP_PREAMBLE_ANY;
+        child = sempInitializeParser(nullptr,
+                                     0,
+                                     parse->parsers,
+                                     parse->parserCount,
+                                     parse->parserNames,
+                                     parse->parserCount,
+                                     parse->buffer - (uint8_t *)parse->scratchPad,
+                                     parse->bufferLength,
+                                     sempParallelEom,
+                                     parse->parserName,
+                                     parse->printError,
+                                     nullptr,
+                                     parse->badCrc,
+                                     preambleTable,
+                                     parse->stateTables,
+                                     0);
+        preambleTable[index] = SEMP_PREAMBLE_NONE;
+        if (!child)
+            break;
+
+        // Use the same settings and statistics as the parent
+        child->features->parent = parse;
+#if SEMP_STATS
+        child->features->stats = parse->features->stats;
+#endif  // SEMP_STATS
+        child->printDebug = parse->printDebug;
+        child->resync = parse->resync;
+        parse->features->parallelParsers[index] = child;
+    }
+    free(preambleTable);
+
+    // Free the parallel parsers when an allocation fails
+    if (index < parse->parserCount)
+    {
+        sempDisableParallelParsing(parse);
+        return false;
+    }
+
+    // Pass the data bytes to the parallel parsers
+    sempResetParser(parse);
+    parse->messageStarted = false;
+    parse->state = sempParallelParse;
+    return true;
+}
+
+#endif  // SEMP_FEATURES
+
 // Shutdown the parser
 void sempStopParser(SEMP_PARSE_STATE **parse)
 {
     // Free the parse structure if it was specified
     if (parse && *parse)
     {
-        free(*parse);
+#if SEMP_FEATURES
+        // Deliver the batched messages and free the parallel parsers
+        sempDisableBatchDelivery(*parse);
+        sempDisableParallelParsing(*parse);
+#endif  // SEMP_FEATURES
+        if (!(*parse)->callerStorage)
+            free(*parse);
         *parse = nullptr;
     }
 }
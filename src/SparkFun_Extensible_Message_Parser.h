@@ -10,13 +10,352 @@ License: MIT. Please see LICENSE.md for more details
 #define __SPARKFUN_EXTENSIBLE_MESSAGE_PARSER_H__
 
 #include <Arduino.h>
+#include <string.h>
 
 //----------------------------------------
 // Constants
 //----------------------------------------
 
+#define SEMP_ALIGNMENT_MASK             7
 #define SEMP_MINIMUM_BUFFER_LENGTH      32
 
+// Minimum storage size for a byte ring or message ring
+#define SEMP_RING_MINIMUM_SIZE          64
+
+// Message ring record stream value that skips the end of the ring storage
+#define SEMP_MESSAGE_RING_WRAP          0xffff
+
+// Preamble table value for a parser that must see every data byte
+#define SEMP_PREAMBLE_ANY               -1
+
+// Preamble table value for a parser that is never called
+#define SEMP_PREAMBLE_NONE              -2
+
+// Number of entries in the preamble lookup table, one per data byte value
+#define SEMP_PREAMBLE_LOOKUP_BYTES      256
+
+// Number of data bytes processed per step by the CRC buffer routines.
+// Slice-by-4 and slice-by-8 use additional lookup tables, the byte tables
+// are always used by the single byte routines and for the remaining bytes.
+#ifndef SEMP_CRC_SLICE_BY
+#ifdef __AVR__
+#define SEMP_CRC_SLICE_BY               1   // Save flash on small processors
+#else
+#define SEMP_CRC_SLICE_BY               8
+#endif  // __AVR__
+#endif  // SEMP_CRC_SLICE_BY
+
+#if (SEMP_CRC_SLICE_BY != 1) && (SEMP_CRC_SLICE_BY != 4) && (SEMP_CRC_SLICE_BY != 8)
+#error "SEMP_CRC_SLICE_BY must be 1, 4 or 8"
+#endif
+
+// Compile time log level, the output above this level is removed from
+// the build including the argument evaluation
+#define SEMP_LOG_LEVEL_NONE             0   // No error or debug output
+#define SEMP_LOG_LEVEL_ERROR            1   // Error output only
+#define SEMP_LOG_LEVEL_DEBUG            2   // Error and debug output
+
+#ifndef SEMP_LOG_LEVEL
+#define SEMP_LOG_LEVEL                  SEMP_LOG_LEVEL_DEBUG
+#endif  // SEMP_LOG_LEVEL
+
+// Binary log events
+#define SEMP_EVENT_BAD_CRC              1   // Bad CRC or checksum
+#define SEMP_EVENT_INVALID_DATA         2   // Invalid data byte in the message
+#define SEMP_EVENT_TOO_LONG             3   // Message too long for the buffer
+#define SEMP_EVENT_BAD_HEADER           4   // Invalid message header
+
+// Include the optional parse features, set to 1 to add the message
+// filters, forwarding, batch delivery, the binary log, parallel parsing,
+// the parser pool and the file descriptor stream.  Without them each
+// parse structure is smaller and no feature state is allocated.
+#ifndef SEMP_FEATURES
+#define SEMP_FEATURES                   0
+#endif  // SEMP_FEATURES
+
+// Maintain the per-parser statistics counters, set to 1 to add them
+#ifndef SEMP_STATS
+#define SEMP_STATS                      0
+#endif  // SEMP_STATS
+
+// The optional features and the statistics keep their state in a block
+// following the parse buffer
+#define SEMP_FEATURE_STATE              (SEMP_FEATURES || SEMP_STATS)
+
+// Record the message latency histograms in the statistics, set to 1 to
+// add the timestamps.  Define SEMP_TIMESTAMP to use a different time
+// source, such as a cycle counter, returning an unsigned 32-bit value.
+#ifndef SEMP_LATENCY
+#define SEMP_LATENCY                    0
+#endif  // SEMP_LATENCY
+
+#if SEMP_LATENCY && !SEMP_STATS
+#error "SEMP_LATENCY requires SEMP_STATS"
+#endif
+
+#ifndef SEMP_TIMESTAMP
+#ifdef ESP32
+#define SEMP_TIMESTAMP()                ((uint32_t)ESP.getCycleCount())
+#else
+#define SEMP_TIMESTAMP()                ((uint32_t)micros())
+#endif  // ESP32
+#endif  // SEMP_TIMESTAMP
+
+// Number of power of two buckets in each latency histogram, bucket n
+// counts the times less than 2^n timestamp ticks, the last bucket
+// counts the longer times
+#define SEMP_LATENCY_BUCKETS            24
+
+// Include the file descriptor stream routines on hosts providing readv
+// when the optional features are included, set to 0 to remove them
+#ifndef SEMP_STREAM_FD
+#if SEMP_FEATURES && (defined(__linux__) || defined(__APPLE__))
+#define SEMP_STREAM_FD                  1
+#else
+#define SEMP_STREAM_FD                  0
+#endif
+#endif  // SEMP_STREAM_FD
+
+#if SEMP_STREAM_FD
+#include <sys/types.h>
+#endif  // SEMP_STREAM_FD
+
+//----------------------------------------
+// Macros
+//----------------------------------------
+
+// Output wrappers for the parsers, removed when above SEMP_LOG_LEVEL
+#define SEMP_DEBUG_PRINTF(print, ...)                                       \
+    do { if ((SEMP_LOG_LEVEL >= SEMP_LOG_LEVEL_DEBUG) && (print))           \
+             sempPrintf(print, __VA_ARGS__); } while (0)
+#define SEMP_DEBUG_PRINTLN(print, string)                                   \
+    do { if ((SEMP_LOG_LEVEL >= SEMP_LOG_LEVEL_DEBUG) && (print))           \
+             sempPrintln(print, string); } while (0)
+#define SEMP_ERROR_PRINTF(print, ...)                                       \
+    do { if ((SEMP_LOG_LEVEL >= SEMP_LOG_LEVEL_ERROR) && (print))           \
+             sempPrintf(print, __VA_ARGS__); } while (0)
+#define SEMP_ERROR_PRINTLN(print, string)                                   \
+    do { if ((SEMP_LOG_LEVEL >= SEMP_LOG_LEVEL_ERROR) && (print))           \
+             sempPrintln(print, string); } while (0)
+
+#define SEMP_ALIGN(x)   (((x) + SEMP_ALIGNMENT_MASK) & (~SEMP_ALIGNMENT_MASK))
+#define SEMP_MAX(a, b)  (((a) > (b)) ? (a) : (b))
+#define SEMP_MIN(a, b)  (((a) < (b)) ? (a) : (b))
+
+// Place the routines called by interrupt routines in RAM on the ESP32
+#ifdef ESP32
+#define SEMP_ISR_ATTR   IRAM_ATTR
+#else
+#define SEMP_ISR_ATTR
+#endif  // ESP32
+
+// Byte order of the processor
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define SEMP_BIG_ENDIAN_HOST    1
+#else
+#define SEMP_BIG_ENDIAN_HOST    0
+#endif  // __BYTE_ORDER__
+
+// Number of bitmap bytes needed to filter message IDs 0 - (idCount - 1)
+#define SEMP_FILTER_BITMAP_BYTES(idCount)   (((idCount) + 7) >> 3)
+
+// List a message ID in a message filter bitmap
+#define SEMP_FILTER_SET_ID(bitmap, id)                                      \
+    do { (bitmap)[(id) >> 3] |= 1 << ((id) & 7); } while (0)
+
+// Number of storage bytes needed by sempBeginParserWithStorage, matching
+// the layout computed by sempBeginParser, including the state of the
+// optional features when compiled.  Add SEMP_STATS_STORAGE_SIZE for the
+// statistics tables and SEMP_PREAMBLE_STORAGE_SIZE when a preambleTable
+// is specified.
+#define SEMP_PARSER_STORAGE_SIZE(scratchPadBytes, bufferLength)             \
+    (SEMP_ALIGN(SEMP_ALIGN(sizeof(SEMP_PARSE_STATE))                        \
+                + SEMP_MAX((size_t)SEMP_ALIGN(scratchPadBytes),             \
+                           (size_t)SEMP_ALIGN(sizeof(SEMP_SCRATCH_PAD)))    \
+                + SEMP_MAX((size_t)(bufferLength),                          \
+                           (size_t)SEMP_MINIMUM_BUFFER_LENGTH))             \
+     + SEMP_FEATURE_STORAGE_SIZE)
+
+// Number of storage bytes needed for the state of the optional features
+#if SEMP_FEATURE_STATE
+#define SEMP_FEATURE_STORAGE_SIZE   SEMP_ALIGN(sizeof(SEMP_PARSE_FEATURES))
+#else
+#define SEMP_FEATURE_STORAGE_SIZE   0
+#endif  // SEMP_FEATURE_STATE
+
+// Number of storage bytes needed for the preamble tables
+#define SEMP_PREAMBLE_STORAGE_SIZE(parserCount)                             \
+    SEMP_ALIGN(SEMP_ALIGN((parserCount) * sizeof(int16_t))                  \
+               + SEMP_PREAMBLE_LOOKUP_BYTES + 1 + (parserCount))
+
+// Number of storage bytes needed for the statistics counters
+#if SEMP_STATS
+#define SEMP_STATS_STORAGE_SIZE(parserCount)                                \
+    SEMP_ALIGN((parserCount) * sizeof(SEMP_PARSER_STATS))
+#else
+#define SEMP_STATS_STORAGE_SIZE(parserCount)    0
+#endif  // SEMP_STATS
+
+// Update a statistics counter for the active parser
+#if SEMP_STATS
+#define SEMP_STATS_ADD(parse, counter, value)                               \
+    do { if ((parse)->type < (parse)->parserCount)                          \
+             (parse)->features->stats[(parse)->type].counter += (value); } while (0)
+
+// Count the data bytes discarded while searching for a preamble
+#define SEMP_STATS_DISCARD(parse, count)                                    \
+    do { (parse)->features->discardedBytes += (count); } while (0)
+#else
+#define SEMP_STATS_ADD(parse, counter, value)   do { } while (0)
+#define SEMP_STATS_DISCARD(parse, count)        do { } while (0)
+#endif  // SEMP_STATS
+
+//----------------------------------------
+// Field accessors
+//----------------------------------------
+
+// Read the little-endian (Le) and big-endian (Be) fields of a message at
+// any alignment.  The fixed size memcpy compiles to a single load on the
+// processors supporting unaligned loads and to byte loads on the others,
+// the byte swap is only done when the byte order differs from the host.
+
+// Read an 8-bit unsigned value
+inline uint8_t sempReadU1(const uint8_t *data)
+{
+    return *data;
+}
+
+// Read a 16-bit little-endian unsigned value
+inline uint16_t sempReadU2Le(const uint8_t *data)
+{
+    uint16_t value;
+
+    memcpy(&value, data, sizeof(value));
+#if SEMP_BIG_ENDIAN_HOST
+    value = __builtin_bswap16(value);
+#endif  // SEMP_BIG_ENDIAN_HOST
+    return value;
+}
+
+// Read a 32-bit little-endian unsigned value
+inline uint32_t sempReadU4Le(const uint8_t *data)
+{
+    uint32_t value;
+
+    memcpy(&value, data, sizeof(value));
+#if SEMP_BIG_ENDIAN_HOST
+    value = __builtin_bswap32(value);
+#endif  // SEMP_BIG_ENDIAN_HOST
+    return value;
+}
+
+// Read a 64-bit little-endian unsigned value
+inline uint64_t sempReadU8Le(const uint8_t *data)
+{
+    uint64_t value;
+
+    memcpy(&value, data, sizeof(value));
+#if SEMP_BIG_ENDIAN_HOST
+    value = __builtin_bswap64(value);
+#endif  // SEMP_BIG_ENDIAN_HOST
+    return value;
+}
+
+// Read a 16-bit big-endian unsigned value
+inline uint16_t sempReadU2Be(const uint8_t *data)
+{
+    uint16_t value;
+
+    memcpy(&value, data, sizeof(value));
+#if !SEMP_BIG_ENDIAN_HOST
+    value = __builtin_bswap16(value);
+#endif  // SEMP_BIG_ENDIAN_HOST
+    return value;
+}
+
+// Read a 24-bit big-endian unsigned value, such as the RTCM CRC
+inline uint32_t sempReadU3Be(const uint8_t *data)
+{
+    return (((uint32_t)data[0]) << 16) | sempReadU2Be(&data[1]);
+}
+
+// Read a 32-bit big-endian unsigned value
+inline uint32_t sempReadU4Be(const uint8_t *data)
+{
+    uint32_t value;
+
+    memcpy(&value, data, sizeof(value));
+#if !SEMP_BIG_ENDIAN_HOST
+    value = __builtin_bswap32(value);
+#endif  // SEMP_BIG_ENDIAN_HOST
+    return value;
+}
+
+// Read a 64-bit big-endian unsigned value
+inline uint64_t sempReadU8Be(const uint8_t *data)
+{
+    uint64_t value;
+
+    memcpy(&value, data, sizeof(value));
+#if !SEMP_BIG_ENDIAN_HOST
+    value = __builtin_bswap64(value);
+#endif  // SEMP_BIG_ENDIAN_HOST
+    return value;
+}
+
+// Read the signed values
+inline int8_t sempReadI1(const uint8_t *data)
+{
+    return (int8_t)*data;
+}
+
+inline int16_t sempReadI2Le(const uint8_t *data)
+{
+    return (int16_t)sempReadU2Le(data);
+}
+
+inline int32_t sempReadI4Le(const uint8_t *data)
+{
+    return (int32_t)sempReadU4Le(data);
+}
+
+inline int64_t sempReadI8Le(const uint8_t *data)
+{
+    return (int64_t)sempReadU8Le(data);
+}
+
+inline int16_t sempReadI2Be(const uint8_t *data)
+{
+    return (int16_t)sempReadU2Be(data);
+}
+
+inline int32_t sempReadI4Be(const uint8_t *data)
+{
+    return (int32_t)sempReadU4Be(data);
+}
+
+// Read a little-endian IEEE-754 single precision value
+inline float sempReadF4Le(const uint8_t *data)
+{
+    float value;
+    uint32_t word;
+
+    word = sempReadU4Le(data);
+    memcpy(&value, &word, sizeof(value));
+    return value;
+}
+
+// Read a little-endian IEEE-754 double precision value
+inline double sempReadF8Le(const uint8_t *data)
+{
+    double value;
+    uint64_t word;
+
+    word = sempReadU8Le(data);
+    memcpy(&value, &word, sizeof(value));
+    return value;
+}
+
 //----------------------------------------
 // Externals
 //----------------------------------------
@@ -28,6 +367,13 @@ extern const uint8_t semp_u8Crc8Table[];
 extern const uint16_t semp_u16Crc16Table[];
 extern const uint32_t semp_u32Crc24Table[];
 extern const uint32_t semp_u32Crc32Table[];
+#if SEMP_CRC_SLICE_BY > 1
+extern const uint32_t semp_crc24qSliceTable[SEMP_CRC_SLICE_BY - 1][256];
+extern const uint32_t semp_crc32SliceTable[SEMP_CRC_SLICE_BY - 1][256];
+extern const uint16_t semp_ccitt_crc_slice_table[SEMP_CRC_SLICE_BY - 1][256];
+extern const uint8_t semp_u8Crc8SliceTable[SEMP_CRC_SLICE_BY - 1][256];
+extern const uint32_t semp_u32Crc32SliceTable[SEMP_CRC_SLICE_BY - 1][256];
+#endif  // SEMP_CRC_SLICE_BY > 1
 
 //----------------------------------------
 // Types
@@ -35,8 +381,23 @@ extern const uint32_t semp_u32Crc32Table[];
 
 // Forward type declaration
 typedef struct _SEMP_PARSE_STATE *P_SEMP_PARSE_STATE;
+typedef struct _SEMP_POOL *P_SEMP_POOL;
+typedef struct _SEMP_SPLITTER *P_SEMP_SPLITTER;
+typedef struct _SEMP_EPOCH *P_SEMP_EPOCH;
+typedef struct _SEMP_STREAM *P_SEMP_STREAM;
 
 // Parse routine
+//
+// The preamble routine listed in the parser table and the state routines
+// it selects return true while the data byte is part of a message.  A
+// state routine passes each valid message to sempDeliverMessage and
+// returns to sempFirstByte when the message fails.  Parsers written for
+// earlier releases of this library call parse->eomCallback directly and
+// then set parse->state to sempFirstByte.  These messages are still
+// delivered, the next byte completes the message, but they bypass the
+// message statistics, batching and message forwarding.  The failures of
+// these parsers are only parsed again by resync when the parser calls
+// sempFirstByte or reports the failure with sempLogEvent.
 typedef bool (*SEMP_PARSE_ROUTINE)(P_SEMP_PARSE_STATE parse, // Parser state
                                    uint8_t data); // Incoming data byte
 
@@ -44,6 +405,19 @@ typedef bool (*SEMP_PARSE_ROUTINE)(P_SEMP_PARSE_STATE parse, // Parser state
 typedef uint32_t (*SEMP_COMPUTE_CRC)(P_SEMP_PARSE_STATE parse, // Parser state
                                      uint8_t dataByte); // Data byte
 
+// Bulk consume routine
+// Normally this routine pointer is set to nullptr.  A parser sets this
+// routine pointer when entering a state that is able to accept a run of
+// data bytes, such as a payload with a known length.  sempParseBuffer
+// calls this routine to let the parser place multiple data bytes into the
+// buffer and update its CRC or checksum over the span in a single call.
+// The routine returns the number of data bytes consumed, which may be
+// zero (0).  The routine must not consume the byte that completes the
+// state, that byte is always passed to the parser state routine.
+typedef size_t (*SEMP_CONSUME_BYTES)(P_SEMP_PARSE_STATE parse, // Parser state
+                                     const uint8_t *data, // Data bytes
+                                     size_t length); // Number of data bytes
+
 // Normally this routine pointer is set to nullptr.  The parser calls
 // the badCrcCallback routine when the default CRC or checksum calculation
 // fails.  This allows an upper layer to adjust the CRC calculation if
@@ -63,6 +437,36 @@ typedef bool (*SEMP_BAD_CRC_CALLBACK)(P_SEMP_PARSE_STATE parse); // Parser state
 typedef void (*SEMP_EOM_CALLBACK)(P_SEMP_PARSE_STATE parse, // Parser state
                                   uint16_t type); // Index into parseTable
 
+// Forward write routine, receives the bytes of the message as they are
+// parsed, before the CRC or checksum is verified
+typedef void (*SEMP_FORWARD_WRITE)(P_SEMP_PARSE_STATE parse, // Parser state
+                                   void *context, // Context from the forward sink
+                                   const uint8_t *data, // Next bytes of the message
+                                   size_t length); // Number of bytes
+
+// Forward end routine, called at the end of each message passed to the
+// forward write routine.  The valid value is true when the message was
+// verified and false when the bytes already written must be discarded.
+typedef void (*SEMP_FORWARD_END)(P_SEMP_PARSE_STATE parse, // Parser state
+                                 void *context, // Context from the forward sink
+                                 bool valid); // true: commit, false: abort
+
+// Batch descriptor of a message in the batch arena
+typedef struct _SEMP_BATCH_ENTRY
+{
+    uint32_t offset;               // Offset of the message in the arena
+    uint32_t id;                   // Message ID, see SEMP_MESSAGE_FILTER
+    uint32_t length;               // Message length in bytes
+    uint16_t type;                 // Index into parseTable
+} SEMP_BATCH_ENTRY;
+
+// Batch callback routine, receives the messages batched since the previous
+// call.  The messages remain in the arena until the routine returns.
+typedef void (*SEMP_BATCH_CALLBACK)(P_SEMP_PARSE_STATE parse, // Parser state
+                                    const SEMP_BATCH_ENTRY *entries, // Message descriptors
+                                    uint16_t count, // Number of messages
+                                    const uint8_t *arena); // Message data
+
 // Invalid data callback:
 // This is parser-specific and should be added to the parser scrtachpad if
 // needed. Normally this routine pointer is set to nullptr. The parser calls
@@ -73,14 +477,80 @@ typedef void (*SEMP_EOM_CALLBACK)(P_SEMP_PARSE_STATE parse, // Parser state
 // to a separate SPARTN parser via this callback.
 typedef void (*SEMP_INVALID_DATA_CALLBACK)(P_SEMP_PARSE_STATE parse); // Parser state
 
+// Name of a parser state routine
+typedef struct _SEMP_STATE_NAME
+{
+    SEMP_PARSE_ROUTINE state;      // Parser state routine
+    const char *name;              // Name of the state routine
+} SEMP_STATE_NAME;
+
+// Describe a state routine using its own name
+#define SEMP_STATE(routine)     {routine, #routine}
+
+// State names of a parser, such as sempNmeaStateTable
+typedef struct _SEMP_STATE_TABLE
+{
+    const SEMP_STATE_NAME *states; // State routines and their names
+    uint16_t stateCount;           // Number of states
+} SEMP_STATE_TABLE;
+
+// Number of field offsets saved for a NMEA or Unicore hash (#) sentence
+// while the sentence is received.  Only the fields starting within the
+// first 255 bytes of the sentence are saved, the other fields are found
+// by scanning forward from the last saved field.  Define a value up to
+// 255, such as 32, when the eomCallback gets many fields of each sentence
+// or 0 to scan the sentence for each field.
+#ifndef SEMP_SENTENCE_FIELD_OFFSETS
+#define SEMP_SENTENCE_FIELD_OFFSETS     8
+#endif  // SEMP_SENTENCE_FIELD_OFFSETS
+#if SEMP_SENTENCE_FIELD_OFFSETS > 255
+#error "SEMP_SENTENCE_FIELD_OFFSETS must be 255 or less"
+#endif  // SEMP_SENTENCE_FIELD_OFFSETS
+
+// Field index of a NMEA or Unicore hash (#) sentence.  The offsets are
+// from the start of the buffer, keeping the index valid when a zero-copy
+// sentence is moved into the parse buffer.
+typedef struct _SEMP_SENTENCE_FIELDS
+{
+#if SEMP_SENTENCE_FIELD_OFFSETS
+    uint8_t offset[SEMP_SENTENCE_FIELD_OFFSETS]; // Offset of each field
+#endif  // SEMP_SENTENCE_FIELD_OFFSETS
+    uint16_t count;             // Number of fields including the name
+    uint16_t end;               // Offset of the asterisk
+    uint8_t indexed;            // Number of offsets saved
+    uint8_t separator;          // Field separator in addition to comma
+} SEMP_SENTENCE_FIELDS;
+
 // Length of the sentence name array
 #define SEMP_NMEA_SENTENCE_NAME_BYTES    16
 
+// NMEA sentence IDs returned by sempNmeaGetSentenceId.  The talker ID is
+// not part of the sentence ID, GPGGA and GNGGA are both SEMP_NMEA_ID_GGA.
+#define SEMP_NMEA_ID_UNKNOWN            0   // Proprietary or unlisted sentence
+#define SEMP_NMEA_ID_DTM                1   // Datum reference
+#define SEMP_NMEA_ID_GBS                2   // Satellite fault detection
+#define SEMP_NMEA_ID_GGA                3   // Fix data
+#define SEMP_NMEA_ID_GLL                4   // Latitude and longitude
+#define SEMP_NMEA_ID_GNS                5   // Fix data, multiple constellations
+#define SEMP_NMEA_ID_GRS                6   // Range residuals
+#define SEMP_NMEA_ID_GSA                7   // DOP and active satellites
+#define SEMP_NMEA_ID_GST                8   // Pseudorange error statistics
+#define SEMP_NMEA_ID_GSV                9   // Satellites in view
+#define SEMP_NMEA_ID_HDT                10  // True heading
+#define SEMP_NMEA_ID_RMC                11  // Recommended minimum data
+#define SEMP_NMEA_ID_THS                12  // True heading and status
+#define SEMP_NMEA_ID_TXT                13  // Text transmission
+#define SEMP_NMEA_ID_VTG                14  // Course and speed over ground
+#define SEMP_NMEA_ID_ZDA                15  // Time and date
+#define SEMP_NMEA_ID_COUNT              16
+
 // NMEA parser scratch area
 typedef struct _SEMP_NMEA_VALUES
 {
     uint8_t sentenceName[SEMP_NMEA_SENTENCE_NAME_BYTES]; // Sentence name
     uint8_t sentenceNameLength; // Length of the sentence name
+    uint8_t sentenceId;         // SEMP_NMEA_ID_* value
+    uint32_t nameCode;          // Last four sentence name characters
 } SEMP_NMEA_VALUES;
 
 // RTCM parser scratch area
@@ -104,12 +574,30 @@ typedef struct _SEMP_UBLOX_VALUES
 typedef struct _SEMP_UNICORE_BINARY_VALUES
 {
     uint32_t crc;            // Copy of CRC calculation before CRC bytes
-    uint16_t bytesRemaining; // Bytes remaining in RTCM CRC calculation
+    uint32_t bytesRemaining; // Bytes remaining in RTCM CRC calculation
 } SEMP_UNICORE_BINARY_VALUES;
 
 // Length of the sentence name array
 #define SEMP_UNICORE_HASH_SENTENCE_NAME_BYTES    16
 
+// Unicore hash (#) sentence IDs returned by sempUnicoreHashGetSentenceId
+#define SEMP_UNICORE_HASH_ID_UNKNOWN    0   // Unlisted sentence
+#define SEMP_UNICORE_HASH_ID_ADRNAVA    1
+#define SEMP_UNICORE_HASH_ID_AGRICA     2
+#define SEMP_UNICORE_HASH_ID_BESTNAVA   3
+#define SEMP_UNICORE_HASH_ID_BESTNAVXYZA 4
+#define SEMP_UNICORE_HASH_ID_BESTSATA   5
+#define SEMP_UNICORE_HASH_ID_MODE       6
+#define SEMP_UNICORE_HASH_ID_OBSVMA     7
+#define SEMP_UNICORE_HASH_ID_PPPNAVA    8
+#define SEMP_UNICORE_HASH_ID_RECTIMEA   9
+#define SEMP_UNICORE_HASH_ID_RTKSTATUSA 10
+#define SEMP_UNICORE_HASH_ID_SPPNAVA    11
+#define SEMP_UNICORE_HASH_ID_STADOPA    12
+#define SEMP_UNICORE_HASH_ID_UNIHEADINGA 13
+#define SEMP_UNICORE_HASH_ID_VERSION    14
+#define SEMP_UNICORE_HASH_ID_COUNT      15
+
 // Unicore hash (#) parser scratch area
 typedef struct _SEMP_UNICORE_HASH_VALUES
 {
@@ -117,6 +605,8 @@ typedef struct _SEMP_UNICORE_HASH_VALUES
     uint8_t checksumBytes;      // Number of checksum bytes
     uint8_t sentenceName[SEMP_UNICORE_HASH_SENTENCE_NAME_BYTES]; // Sentence name
     uint8_t sentenceNameLength; // Length of the sentence name
+    uint8_t sentenceId;         // SEMP_UNICORE_HASH_ID_* value
+    uint32_t nameHash;          // FNV-1a hash of the sentence name
 } SEMP_UNICORE_HASH_VALUES;
 
 // SPARTN parser scratch area
@@ -125,16 +615,16 @@ typedef struct _SEMP_SPARTN_VALUES
     uint16_t frameCount;
     uint16_t crcBytes;
     uint16_t TF007toTF016;
-
-    uint8_t messageType;
     uint16_t payloadLength;
     uint16_t EAF;
-    uint8_t crcType;
-    uint8_t frameCRC;
-    uint8_t messageSubtype;
     uint16_t timeTagType;
     uint16_t authenticationIndicator;
     uint16_t embeddedApplicationLengthBytes;
+
+    uint8_t messageType;
+    uint8_t crcType;
+    uint8_t frameCRC;
+    uint8_t messageSubtype;
 } SEMP_SPARTN_VALUES;
 
 // SBF parser scratch area
@@ -162,29 +652,330 @@ typedef union
     SEMP_SBF_VALUES sbf;         // SBF specific values
 } SEMP_SCRATCH_PAD;
 
+// Binary log entry, recorded without formatting
+typedef struct _SEMP_LOG_ENTRY
+{
+    uint32_t received;             // Received CRC or checksum, or the data byte
+    uint32_t computed;             // Computed CRC or checksum
+    uint16_t length;               // Message length in bytes
+    uint8_t event;                 // SEMP_EVENT_* value
+    uint8_t type;                  // Index into the parse table
+} SEMP_LOG_ENTRY;
+
+// Statistics counters for a parser in the parse table
+typedef struct _SEMP_PARSER_STATS
+{
+    uint32_t messages;             // Valid messages delivered
+    uint32_t bytes;                // Bytes in the delivered messages
+    uint32_t badCrc;               // Messages with a bad CRC or checksum
+    uint32_t badHeader;            // Messages rejected due to the header
+    uint32_t invalidData;          // Messages rejected due to a data byte
+    uint32_t tooLong;              // Messages too long for the buffer
+    uint32_t resyncs;              // Failed messages parsed again
+    uint32_t filtered;             // Messages rejected by the message filter
+#if SEMP_LATENCY
+    uint32_t messageTime[SEMP_LATENCY_BUCKETS];  // Preamble to eomCallback
+    uint32_t latency[SEMP_LATENCY_BUCKETS];      // Parse call with the last byte to eomCallback
+    uint32_t callbackTime[SEMP_LATENCY_BUCKETS]; // Time spent in eomCallback
+#endif  // SEMP_LATENCY
+} SEMP_PARSER_STATS;
+
+// Message filter for a parser in the parse table.  The binary parsers
+// look up the message ID in the bitmap: the RTCM message number, the
+// u-blox class and ID (sempUbloxGetMessageNumber), the SBF block number,
+// the SPARTN message type and the Unicore binary message ID.  The NMEA
+// and Unicore hash parsers compare the sentence name with the names.
+// When no names are listed, the NMEA and Unicore hash parsers look up the
+// sentence ID (SEMP_NMEA_ID_*, SEMP_UNICORE_HASH_ID_*) in the bitmap
+// instead.  A zeroed filter accepts all of the messages.
+typedef struct _SEMP_MESSAGE_FILTER
+{
+    const uint8_t *bitmap;         // Bit (id & 7) of byte (id >> 3) set for each listed ID
+    uint32_t idCount;              // Number of message IDs covered by the bitmap
+    const char * const *names;     // Listed sentence names
+    uint16_t nameCount;            // Number of sentence names
+    bool accept;                   // true: accept only the listed messages,
+                                   // false: reject the listed messages
+} SEMP_MESSAGE_FILTER;
+
+// Forward sink for a parser in the parse table, the messages are not
+// forwarded when the write routine is nullptr
+typedef struct _SEMP_FORWARD_SINK
+{
+    SEMP_FORWARD_WRITE write;      // Receives the message bytes as they are parsed
+    SEMP_FORWARD_END end;          // Commits or aborts the message when set
+    void *context;                 // Passed to the write and end routines
+} SEMP_FORWARD_SINK;
+
+#if SEMP_FEATURE_STATE
+// State of the optional features and statistics of a parse structure.
+// The state is placed after the parse buffer, keeping it out of the cache
+// lines used to parse each data byte.
+typedef struct _SEMP_PARSE_FEATURES
+{
+#if SEMP_FEATURES
+    const SEMP_MESSAGE_FILTER *filters; // Message filter for each parser when set
+    const SEMP_FORWARD_SINK *forwardSinks; // Forward sink for each parser when set
+    SEMP_BATCH_CALLBACK batchCallback; // Receives the batched messages when set
+    SEMP_BATCH_ENTRY *batchEntries; // Descriptors of the batched messages
+    uint8_t *batchArena;           // Storage of the batched messages
+    SEMP_LOG_ENTRY *logEntries;    // Binary log ring buffer when set
+    P_SEMP_PARSE_STATE *parallelParsers; // Parser states when parsing in parallel
+    P_SEMP_PARSE_STATE parent;     // Parse structure owning this parallel parser
+    P_SEMP_POOL pool;              // Pool owning this parser when set
+    P_SEMP_STREAM stream;          // Stream owning this parser when set
+    uint32_t skipRemaining;        // Bytes remaining to skip in a rejected message
+    uint32_t batchArenaBytes;      // Size of the arena in bytes
+    uint32_t batchArenaUsed;       // Bytes of the arena in use
+    uint32_t logDropped;           // Number of entries overwritten before read
+    int16_t skipTerminator;        // Byte ending the skipped text, -1 when counting bytes
+    uint16_t skipTrailer;          // Bytes skipped after skipTerminator
+    uint16_t batchEntryCount;      // Number of descriptors
+    uint16_t batchCount;           // Number of batched messages
+    uint16_t logEntryCount;        // Number of entries in the binary log
+    uint16_t logHead;              // Index of the next entry to write
+    uint16_t logTail;              // Index of the next entry to read
+    uint16_t poolStream;           // Stream number within the pool
+    bool batchEachBuffer;          // Deliver the batch at the end of sempParseBuffer
+#endif  // SEMP_FEATURES
+#if SEMP_STATS
+    SEMP_PARSER_STATS *stats;      // Statistics for each parser in the parse table
+    uint32_t discardedBytes;       // Bytes not accepted as a preamble
+#endif  // SEMP_STATS
+#if SEMP_LATENCY
+    uint32_t preambleTime;         // Timestamp of the preamble byte
+    uint32_t receiveTime;          // Timestamp of the parse call
+#endif  // SEMP_LATENCY
+} SEMP_PARSE_FEATURES;
+#endif  // SEMP_FEATURE_STATE
+
 // Maintain the operating state of one or more parsers processing a raw
-// data stream.
+// data stream.  The fields used for every data byte are placed first and
+// fit in a 64 byte cache line, followed by the fields used once per
+// message and the configuration.  The state of the optional features is
+// located with the features pointer.  The fields are ordered by size
+// within each group to avoid padding.
 typedef struct _SEMP_PARSE_STATE
 {
-    const SEMP_PARSE_ROUTINE *parsers; // Table of parsers
-    const char * const *parserNames;   // Table of parser names
+    // Fields used for each data byte
     SEMP_PARSE_ROUTINE state;      // Parser state routine
-    SEMP_EOM_CALLBACK eomCallback; // End of message callback routine
-    SEMP_BAD_CRC_CALLBACK badCrc;  // Bad CRC callback routine
+    SEMP_CONSUME_BYTES consumeBytes; // Routine to consume a run of bytes when set
     SEMP_COMPUTE_CRC computeCrc;   // Routine to compute the CRC when set
-    const char *parserName;        // Name of parser
-    void *scratchPad;              // Parser scratchpad area
-    Print *printError;             // Class to use for error output
-    Print *printDebug;             // Class to use for debug output
-    uint32_t crc;                  // RTCM computed CRC
     uint8_t *buffer;               // Buffer containing the message
+    uint8_t *inPlaceData;          // Address of the current data byte when parsing in place
+    uint32_t crc;                  // RTCM computed CRC
+    uint32_t length;               // Message length including line termination
+    uint32_t dataIndex;            // Buffer offset of the current data byte
     uint32_t bufferLength;         // Length of the buffer in bytes
-    uint16_t parserCount;          // Number of parsers
-    uint16_t length;               // Message length including line termination
     uint16_t type;                 // Active parser type, a value of
                                    // parserCount means searching for preamble
+    uint16_t parserCount;          // Number of parsers
+    bool messageStarted;           // Preamble found, message not yet delivered
+    bool inPlace;                  // Buffer points into the caller's buffer
+    bool zeroCopy;                 // Parse the messages in the caller's buffer
+    bool resync;                   // Rescan the message bytes after a failure
+
+    // Fields used for each message
+    SEMP_EOM_CALLBACK eomCallback; // End of message callback, called by sempDeliverMessage
+    SEMP_BAD_CRC_CALLBACK badCrc;  // Bad CRC callback routine
+    uint8_t *preambleLookup;       // First parser index for each data byte
+    uint8_t *preambleScan;         // Count followed by the preamble bytes
+    uint8_t *messageBuffer;        // Parser owned buffer, used when not parsing in place
+    const uint8_t *messageStart;   // Address of the preamble in the caller's buffer when parsing in place
+#if SEMP_FEATURE_STATE
+    SEMP_PARSE_FEATURES *features; // State of the optional features, follows the buffer
+#endif  // SEMP_FEATURE_STATE
+#if SEMP_FEATURES
+    const SEMP_FORWARD_SINK *forwardSink;  // Sink receiving the message in progress
+    uint32_t forwardOffset;        // Buffer offset of the next byte to forward
+#endif  // SEMP_FEATURES
+    uint32_t resyncCursor;         // Buffer offset of the next byte to rescan
+    uint32_t resyncEnd;            // End of the bytes to rescan, zero when not rescanning
+    uint32_t messageId;            // ID of the message in progress, see SEMP_MESSAGE_FILTER
+    SEMP_SENTENCE_FIELDS fields;   // Field index of the NMEA or Unicore hash (#) sentence
+#if SEMP_FEATURES
+    bool messageRejected;          // Message in progress is not delivered
+    bool validateFiltered;         // Parse the rejected messages before dropping them
+#endif  // SEMP_FEATURES
+    bool callerStorage;            // Storage supplied by the caller, don't free
+    bool resyncPending;            // Data byte follows the bytes being rescanned
+    bool messageFailed;            // Failure of the message in progress reported by sempLogEvent
+
+    // Configuration
+    const SEMP_PARSE_ROUTINE *parsers; // Table of parsers
+    const char * const *parserNames;   // Table of parser names
+    const char *parserName;        // Name of parser
+    void *scratchPad;              // Parser scratchpad area, see sempGetScratchPad
+    Print *printError;             // Class to use for error output
+    Print *printDebug;             // Class to use for debug output
+    int16_t *preambles;            // Preamble byte for each parser when set
+    const SEMP_STATE_TABLE * const *stateTables; // State names for each parser when set
 } SEMP_PARSE_STATE;
 
+// Locate the scratch pad of a parser.  The scratch pad follows the parse
+// structure, computing the address avoids loading the scratchPad pointer
+// in each parser state routine.
+inline SEMP_SCRATCH_PAD * sempGetScratchPad(const SEMP_PARSE_STATE *parse)
+{
+    return (SEMP_SCRATCH_PAD *)((uint8_t *)parse + SEMP_ALIGN(sizeof(SEMP_PARSE_STATE)));
+}
+
+// Single producer, single consumer ring of data bytes, such as the bytes
+// received by a UART interrupt routine or DMA.  The head is only updated
+// by the producer and the tail is only updated by the consumer.
+typedef struct _SEMP_BYTE_RING
+{
+    uint8_t *data;                 // Ring storage
+    uint32_t size;                 // Storage size in bytes, a power of two
+    uint32_t head;                 // Bytes written by the producer
+    uint32_t tail;                 // Bytes read by the consumer
+} SEMP_BYTE_RING;
+
+// Header of each record in a message ring, the data bytes follow the header
+typedef struct _SEMP_MESSAGE_RECORD
+{
+    uint16_t stream;               // Stream number, zero (0) when not using a pool
+    uint16_t type;                 // Index into parseTable
+    uint32_t length;               // Number of data bytes
+} SEMP_MESSAGE_RECORD;
+
+// Single producer, single consumer ring of records, such as the messages
+// delivered by the eomCallback routine.  Each record is contiguous in the
+// ring storage.  The head is only updated by the producer and the tail is
+// only updated by the consumer.
+typedef struct _SEMP_MESSAGE_RING
+{
+    uint8_t *data;                 // Record storage
+    uint32_t size;                 // Storage size in bytes, a power of two
+    uint32_t head;                 // Bytes written by the producer
+    uint32_t tail;                 // Bytes read by the consumer
+} SEMP_MESSAGE_RING;
+
+// Pool message callback routine, called by sempPoolDeliverMessages for
+// each message removed from the output queue of a worker
+typedef void (*SEMP_POOL_CALLBACK)(uint16_t stream,         // Stream number
+                                   uint16_t type,           // Index into parseTable
+                                   const uint8_t *message,  // Message bytes
+                                   size_t length);          // Message length in bytes
+
+// Pool worker, parses the streams assigned to it
+typedef struct _SEMP_POOL_WORKER
+{
+    SEMP_MESSAGE_RING input;       // Data chunks waiting to be parsed
+    SEMP_MESSAGE_RING output;      // Messages waiting to be delivered
+    uint32_t droppedMessages;      // Messages lost when the output queue was full
+    P_SEMP_POOL pool;              // Pool owning this worker
+    void *task;                    // Task running this worker when set
+} SEMP_POOL_WORKER;
+
+// Pool of parsers, one parser for each data stream
+typedef struct _SEMP_POOL
+{
+    SEMP_PARSE_STATE **parsers;    // Parse structure for each stream
+    SEMP_POOL_WORKER *workers;     // Workers parsing the streams
+    SEMP_POOL_CALLBACK callback;   // Routine receiving the messages
+    const char *name;              // Name of the pool
+    Print *printError;             // Class to use for error output
+    uint16_t streamCount;          // Number of streams
+    uint16_t workerCount;          // Number of workers
+    bool stopTasks;                // Request the worker tasks to exit
+} SEMP_POOL;
+
+// Splitter message callback routine, called by sempSplitterDeliverMessages
+// for each message in the order of the messages in the data
+typedef void (*SEMP_SPLIT_CALLBACK)(const uint8_t *message, // Message bytes
+                                    size_t offset,          // Offset of the message in the data
+                                    size_t length,          // Message length in bytes
+                                    uint16_t type);         // Index into parseTable
+
+// Location of a message found by the splitter
+typedef struct _SEMP_SPLIT_MESSAGE
+{
+    size_t offset;                 // Offset of the message in the data
+    uint32_t length;               // Message length in bytes
+    uint16_t type;                 // Index into parseTable
+} SEMP_SPLIT_MESSAGE;
+
+// Portion of the data parsed by one call to sempSplitterParseNextChunk
+typedef struct _SEMP_SPLIT_CHUNK
+{
+    P_SEMP_SPLITTER splitter;      // Splitter owning this chunk
+    SEMP_SPLIT_MESSAGE *messages;  // Messages starting within the chunk
+    uint32_t messageCount;         // Number of messages found
+    uint32_t messageSlots;         // Number of entries in the messages array
+    size_t start;                  // Offset of the first byte of the chunk
+    size_t end;                    // Offset of the first byte of the next chunk
+    size_t searchOffset;           // Offset following the previous message
+    size_t resumeOffset;           // Offset where the parser was idle after the chunk
+    bool done;                     // Chunk parsed, set after the messages are saved
+    bool failed;                   // Chunk not parsed, allocation failure
+} SEMP_SPLIT_CHUNK;
+
+// Split a block of data, such as a memory mapped log file, into chunks
+// that are parsed in parallel
+typedef struct _SEMP_SPLITTER
+{
+    const uint8_t *data;           // Data to parse
+    size_t length;                 // Number of data bytes
+    SEMP_SPLIT_CHUNK *chunks;      // Chunks of the data
+    uint32_t chunkCount;           // Number of chunks
+    uint32_t nextChunk;            // Next chunk to parse
+    uint32_t deliverChunk;         // Next chunk to deliver
+    size_t deliveredEnd;           // Offset following the last delivered message
+    uint32_t failedChunks;         // Number of chunks that were not parsed
+    SEMP_SPLIT_CALLBACK callback;  // Routine receiving the messages
+    const SEMP_PARSE_ROUTINE *parsers; // Table of parsers
+    const char * const *parserNames;   // Table of parser names
+    const int16_t *preambleTable;  // Preamble byte for each parser when set
+    const char *name;              // Name of the splitter
+    Print *printError;             // Class to use for error output
+    size_t bufferLength;           // Length of the parse buffer in bytes
+    uint16_t scratchPadBytes;      // Size of the scratch pad in bytes
+    uint16_t parserCount;          // Number of parsers
+} SEMP_SPLITTER;
+
+// Epoch callback status values
+#define SEMP_EPOCH_SINGLE       0   // Message is not part of an epoch
+#define SEMP_EPOCH_COMPLETE     1   // The last message of the epoch arrived
+#define SEMP_EPOCH_ENDED        2   // A later epoch started or sempEpochFlush was called
+#define SEMP_EPOCH_PARTIAL      3   // Entries or arena full, the epoch continues
+
+// Epoch callback routine, receives the messages of an epoch.  The messages
+// remain in the arena until the routine returns.
+typedef void (*SEMP_EPOCH_CALLBACK)(P_SEMP_EPOCH epoch, // Epoch state
+                                    const SEMP_BATCH_ENTRY *entries, // Message descriptors
+                                    uint16_t count, // Number of messages
+                                    const uint8_t *arena, // Message data
+                                    uint8_t status); // SEMP_EPOCH_* value
+
+// Group the messages of a receiver epoch, such as the MSM messages of an
+// observation epoch, in the caller's arena
+typedef struct _SEMP_EPOCH
+{
+    SEMP_EPOCH_CALLBACK callback;  // Routine receiving the epochs
+    SEMP_BATCH_ENTRY *entries;     // Descriptors of the epoch messages
+    uint8_t *arena;                // Copies of the epoch messages
+    void *context;                 // Application data for the callback routine
+    uint32_t arenaBytes;           // Size of the arena in bytes
+    uint32_t arenaUsed;            // Bytes of the arena in use
+    uint32_t time;                 // Epoch time of the open epoch
+    uint16_t entryCount;           // Number of entries
+    uint16_t count;                // Number of messages in the open epoch
+    uint16_t type;                 // Index into parseTable of the open epoch
+    bool open;                     // An epoch is waiting for its last message
+} SEMP_EPOCH;
+
+// Data stream read from a file descriptor, such as a socket or serial port
+typedef struct _SEMP_STREAM
+{
+    SEMP_BYTE_RING input;          // Data bytes read from the file descriptor
+    SEMP_MESSAGE_RING output;      // Messages waiting for the application
+    SEMP_PARSE_STATE *parse;       // Parser for the data stream
+    uint32_t droppedMessages;      // Messages lost when the output ring was full
+    int fd;                        // Non-blocking file descriptor
+    uint16_t number;               // Stream number placed in the message records
+} SEMP_STREAM;
+
 //----------------------------------------
 // Protocol specific types
 //----------------------------------------
@@ -210,11 +1001,113 @@ typedef struct _SEMP_UNICORE_HEADER
     uint16_t outputDelayMSec; // Output delay time, ms
 } SEMP_UNICORE_HEADER;
 
+// Read the bit fields of a RTCM payload, most significant bit first.
+// The bits are loaded 64 bits at a time into a left aligned buffer.
+typedef struct _SEMP_RTCM_BIT_READER
+{
+    const uint8_t *data;           // Next payload byte to load
+    const uint8_t *end;            // End of the payload
+    uint64_t bits;                 // Bits not yet read, starting at bit 63
+    int count;                     // Number of bits not yet read in bits
+    bool overrun;                  // A field extended past the end of the payload
+} SEMP_RTCM_BIT_READER;
+
+// Maximum width of a field read by sempRtcmGetBits
+#define SEMP_RTCM_MAX_FIELD_BITS        56
+
+// Maximum number of satellites, signals and cells in a MSM message
+#define SEMP_RTCM_MSM_SATELLITES        64
+#define SEMP_RTCM_MSM_SIGNALS           32
+#define SEMP_RTCM_MSM_CELLS             64
+
+// MSM satellite data, the fields not present in the MSM type are zero.
+// The values are in the units of the RTCM data fields.
+typedef struct _SEMP_RTCM_MSM_SATELLITE
+{
+    uint8_t id;                    // Satellite ID, 1 - 64
+    uint8_t roughRangeMs;          // DF397, integer ms, 255 when invalid
+    uint8_t extendedInfo;          // DF419 for GLONASS, MSM5 and MSM7
+    uint16_t roughRangeModMs;      // DF398, 2^-10 ms
+    int16_t roughPhaseRangeRate;   // DF399, m/s, MSM5 and MSM7
+} SEMP_RTCM_MSM_SATELLITE;
+
+// MSM signal (cell) data, the fields not present in the MSM type are zero.
+// The values are in the units of the RTCM data fields.
+typedef struct _SEMP_RTCM_MSM_CELL
+{
+    int32_t finePseudorange;       // DF400 2^-24 ms (MSM4, MSM5), DF405 2^-29 ms (MSM6, MSM7)
+    int32_t finePhaseRange;        // DF401 2^-29 ms (MSM4, MSM5), DF406 2^-31 ms (MSM6, MSM7)
+    int16_t finePhaseRangeRate;    // DF404, 0.0001 m/s, MSM5 and MSM7
+    uint16_t lockTime;             // DF402 (MSM4, MSM5), DF407 (MSM6, MSM7)
+    uint16_t cnr;                  // DF403 1 dBHz (MSM4, MSM5), DF408 0.0625 dBHz (MSM6, MSM7)
+    uint8_t halfCycle;             // DF420, half-cycle ambiguity indicator
+    uint8_t satellite;             // Index into the satellites array
+    uint8_t signalId;              // Signal ID, 1 - 32
+} SEMP_RTCM_MSM_CELL;
+
+// Decoded MSM4, MSM5, MSM6 or MSM7 message
+typedef struct _SEMP_RTCM_MSM
+{
+    uint16_t messageNumber;        // DF002
+    uint16_t stationId;            // DF003
+    uint32_t epochTime;            // DF004, DF416 + DF034 or DF427, GNSS specific
+    uint8_t msmType;               // 4 - 7
+    uint8_t gnss;                  // Tens digit of the message number, 7: GPS,
+                                   // 8: GLONASS, 9: Galileo, 10: SBAS, 11: QZSS,
+                                   // 12: BeiDou, 13: NavIC
+    bool multipleMessage;          // DF393, more messages follow for this epoch
+    uint8_t iods;                  // DF409, issue of data station
+    uint8_t clockSteering;         // DF411
+    uint8_t externalClock;         // DF412
+    bool smoothing;                // DF417, divergence-free smoothing
+    uint8_t smoothingInterval;     // DF418
+    uint8_t satelliteCount;        // Number of satellites in the satellite mask
+    uint8_t signalCount;           // Number of signals in the signal mask
+    uint8_t cellCount;             // Number of cells in the cell mask
+    uint8_t signalIds[SEMP_RTCM_MSM_SIGNALS]; // Signal ID of each signal
+    SEMP_RTCM_MSM_SATELLITE satellites[SEMP_RTCM_MSM_SATELLITES];
+    SEMP_RTCM_MSM_CELL cells[SEMP_RTCM_MSM_CELLS];
+} SEMP_RTCM_MSM;
+
+// Decoded 1005 or 1006 stationary antenna reference point message
+typedef struct _SEMP_RTCM_1005
+{
+    uint16_t messageNumber;        // DF002, 1005 or 1006
+    uint16_t stationId;            // DF003
+    uint8_t itrfYear;              // DF021, ITRF realization year
+    bool gps;                      // DF022, GPS service supported
+    bool glonass;                  // DF023, GLONASS service supported
+    bool galileo;                  // DF024, Galileo service supported
+    bool referenceStation;         // DF141, physical (false) or non-physical (true)
+    bool singleOscillator;         // DF142, single receiver oscillator
+    uint8_t quarterCycle;          // DF364, quarter cycle indicator
+    int64_t ecefX;                 // DF025, 0.0001 m
+    int64_t ecefY;                 // DF026, 0.0001 m
+    int64_t ecefZ;                 // DF027, 0.0001 m
+    uint16_t antennaHeight;        // DF028, 0.0001 m, 1006 only
+} SEMP_RTCM_1005;
+
+// Length of the 1033 description strings including the zero termination
+#define SEMP_RTCM_1033_STRING_BYTES     32
+
+// Decoded 1033 receiver and antenna descriptors message
+typedef struct _SEMP_RTCM_1033
+{
+    uint16_t stationId;            // DF003
+    uint8_t antennaSetupId;        // DF031
+    char antennaDescriptor[SEMP_RTCM_1033_STRING_BYTES];    // DF030
+    char antennaSerialNumber[SEMP_RTCM_1033_STRING_BYTES];  // DF033
+    char receiverType[SEMP_RTCM_1033_STRING_BYTES];         // DF228
+    char receiverFirmware[SEMP_RTCM_1033_STRING_BYTES];     // DF230
+    char receiverSerialNumber[SEMP_RTCM_1033_STRING_BYTES]; // DF232
+} SEMP_RTCM_1033;
+
 //----------------------------------------
 // Support routines
 //----------------------------------------
 
 int sempAsciiToNibble(int data);
+uint32_t semp_crc32Buffer(uint32_t crc, const uint8_t *data, size_t length);
 
 //----------------------------------------
 // Public routines - Called by the application
@@ -262,6 +1155,23 @@ int sempAsciiToNibble(int data);
 // possible to call sempSetPrintError later to enable or disable error
 // output.
 //
+// The optional preambleTable contains the first byte of the messages
+// for each of the parsers in parseTable, such as SEMP_NMEA_PREAMBLE.
+// Use SEMP_PREAMBLE_ANY for parsers that must see every data byte and
+// SEMP_PREAMBLE_NONE for parsers that should not be called.
+// When specified, sempFirstByte only calls the preamble routines that
+// accept the data byte, skipping bytes that no parser accepts.  A
+// nullptr value calls each of the preamble routines for every byte.
+// The routine sempParseBuffer also uses the preambleTable to scan past
+// the data bytes that no parser accepts, unless one of the parsers
+// accepts any byte.
+//
+// The optional stateTables contains the address of the state name table
+// for each of the parsers in parseTable, such as &sempNmeaStateTable, or
+// nullptr for a parser without a table.  sempGetStateName uses the table
+// of the active parser to name the state.  The array and the tables must
+// remain valid until sempStopParser is called.
+//
 // Allocate and initialize a parse data structure
 SEMP_PARSE_STATE * sempBeginParser(const SEMP_PARSE_ROUTINE *parseTable, \
                                    uint16_t parserCount, \
@@ -273,7 +1183,38 @@ SEMP_PARSE_STATE * sempBeginParser(const SEMP_PARSE_ROUTINE *parseTable, \
                                    const char *name, \
                                    Print *printError = &Serial,
                                    Print *printDebug = (Print *)nullptr,
-                                   SEMP_BAD_CRC_CALLBACK badCrcCallback = (SEMP_BAD_CRC_CALLBACK)nullptr);
+                                   SEMP_BAD_CRC_CALLBACK badCrcCallback = (SEMP_BAD_CRC_CALLBACK)nullptr,
+                                   const int16_t *preambleTable = (const int16_t *)nullptr,
+                                   const SEMP_STATE_TABLE * const *stateTables = (const SEMP_STATE_TABLE * const *)nullptr);
+
+// The routine sempBeginParserWithStorage initializes the parse data
+// structure in a block of storage supplied by the caller instead of
+// allocating it, such as a static array or a block from an arena.  The
+// storage must be aligned for a pointer, such as a uint64_t array, and
+// contain at least SEMP_PARSER_STORAGE_SIZE(scratchPadBytes, bufferLength)
+// plus SEMP_STATS_STORAGE_SIZE(parserCount) bytes, and an additional
+// SEMP_PREAMBLE_STORAGE_SIZE(parserCount) bytes when a preambleTable is
+// specified.  The remaining parameters are the same as
+// for sempBeginParser.  sempStopParser does not free the storage, which
+// may be reused after the call to sempStopParser.  Parallel parsing
+// still allocates the parallel parsers.
+//
+// Initialize a parse data structure in the caller's storage
+SEMP_PARSE_STATE * sempBeginParserWithStorage(void *storage,
+                                              size_t storageBytes,
+                                              const SEMP_PARSE_ROUTINE *parseTable,
+                                              uint16_t parserCount,
+                                              const char * const *parserNameTable,
+                                              uint16_t parserNameCount,
+                                              uint16_t scratchPadBytes,
+                                              size_t bufferLength,
+                                              SEMP_EOM_CALLBACK eomCallback,
+                                              const char *name,
+                                              Print *printError = &Serial,
+                                              Print *printDebug = (Print *)nullptr,
+                                              SEMP_BAD_CRC_CALLBACK badCrcCallback = (SEMP_BAD_CRC_CALLBACK)nullptr,
+                                              const int16_t *preambleTable = (const int16_t *)nullptr,
+                                              const SEMP_STATE_TABLE * const *stateTables = (const SEMP_STATE_TABLE * const *)nullptr);
 
 // Only parsers should call the routine sempFirstByte when an unexpected
 // byte is found in the data stream.  Parsers will also set the state
@@ -284,13 +1225,137 @@ SEMP_PARSE_STATE * sempBeginParser(const SEMP_PARSE_ROUTINE *parseTable, \
 // returning true is the parser that gets called for the following data.
 bool sempFirstByte(SEMP_PARSE_STATE *parse, uint8_t data);
 
+// Only parser front ends, such as SEMP_PARSER_SET, should call
+// sempScanForPreamble and sempMessageTooLong.  sempScanForPreamble
+// returns the address of the next data byte that is a preamble for one
+// of the parsers, or the end address when none is found.  It requires a
+// preambleTable.  sempMessageTooLong handles a data byte that does not
+// fit in the buffer.
+const uint8_t * sempScanForPreamble(const SEMP_PARSE_STATE *parse,
+                                    const uint8_t *data,
+                                    const uint8_t *end);
+void sempMessageTooLong(SEMP_PARSE_STATE *parse, uint8_t data);
+
+#if SEMP_FEATURES
+// Only parser front ends should call sempForwardStart and sempForwardFlush.
+// sempForwardStart selects the forward sink when a preamble is accepted
+// and sempForwardFlush passes the bytes parsed so far to the sink at the
+// end of each parse call.
+void sempForwardStart(SEMP_PARSE_STATE *parse);
+void sempForwardFlush(SEMP_PARSE_STATE *parse);
+#endif  // SEMP_FEATURES
+
+// Only parsers should call sempDeliverMessage.  This routine passes a
+// valid message to the eomCallback routine or the batch callback.
+// Parsers should use this routine instead of calling eomCallback
+// directly, see SEMP_PARSE_ROUTINE.
+void sempDeliverMessage(SEMP_PARSE_STATE *parse);
+
+// Only parsers should call sempFilterMessage and sempFilterSentence,
+// once the message ID or sentence name and ID are known.  The routines
+// save the ID in parse->messageId for the batch descriptor.  When the message filter
+// rejects the message, the routine switches the parser to a state that
+// skips the rest of the message without buffering the bytes or computing
+// the CRC and returns true.  sempFilterMessage skips bytesRemaining bytes.
+// sempFilterSentence skips the bytes through the terminator followed by
+// trailerBytes bytes.  The routines return false when the message is parsed
+// normally, including a rejected message when validating the rejected
+// messages or when the message would not fit in the buffer.  Without
+// SEMP_FEATURES the routines only save the ID and return false.
+bool sempFilterMessage(SEMP_PARSE_STATE *parse, uint32_t id, uint32_t bytesRemaining);
+bool sempFilterSentence(SEMP_PARSE_STATE *parse,
+                        uint32_t id,
+                        const char *name,
+                        uint8_t terminator,
+                        uint16_t trailerBytes);
+
+// Only parsers should call sempMessageFits, once the message length is
+// read from the header.  The routine returns true when the rest of the
+// message, bytesRemaining bytes, fits in the buffer or when resync is
+// disabled.  Otherwise the parser fails the header, like any other invalid
+// header, so that resync parses the bytes following a false preamble again
+// instead of the length filling the buffer.  Without resync the message
+// fails as too long once it fills the buffer.
+bool sempMessageFits(SEMP_PARSE_STATE *parse, uint32_t bytesRemaining);
+
+// Only parsers should call sempPreambleAcceptsAnyByte.  This routine
+// causes sempFirstByte to pass every data byte to the preamble routine
+// when a preambleTable was specified, such as when the parser forwards
+// the invalid data to another parser.
+void sempPreambleAcceptsAnyByte(const SEMP_PARSE_STATE *parse,
+                                SEMP_PARSE_ROUTINE preamble);
+
+// Only parsers should call sempLogEvent.  This routine counts a failed
+// message in the statistics and records it in the binary log when enabled.
+void sempLogEvent(SEMP_PARSE_STATE *parse,
+                  uint8_t event,
+                  uint32_t received,
+                  uint32_t computed);
+
+// Only parser consume routines should call sempBufferBytes.  This routine
+// copies a run of data bytes into the buffer, limited by the maximum
+// number of bytes the parser state is able to accept and the space
+// remaining in the buffer.  The routine returns the number of bytes copied.
+size_t sempBufferBytes(SEMP_PARSE_STATE *parse, const uint8_t *data,
+                       size_t length, size_t maximum);
+
+// Only the NMEA and Unicore hash (#) parsers should call
+// sempSentenceStartFields, sempSentenceAddField and sempScanSentence.
+// sempSentenceStartFields starts parse->fields with the sentence name and
+// the field starting at the end of the buffer once the name is received.
+// sempSentenceAddField adds the field starting at offset to the field
+// index.  sempScanSentence buffers the sentence data
+// bytes before the asterisk, eight bytes at a time, computing the XOR
+// checksum and adding the fields to the field index in the same pass,
+// unless fields is nullptr.  The routine returns the number of bytes
+// buffered, at most maximum.
+void sempSentenceStartFields(SEMP_PARSE_STATE *parse, uint8_t separator);
+void sempSentenceAddField(SEMP_SENTENCE_FIELDS *fields, size_t offset);
+size_t sempScanSentence(SEMP_PARSE_STATE *parse,
+                        const uint8_t *data,
+                        size_t length,
+                        size_t maximum,
+                        SEMP_SENTENCE_FIELDS *fields);
+
+// Only the NMEA and Unicore hash (#) parsers should call sempSentenceLength
+// and sempTerminateSentence.  sempSentenceLength returns the length of the
+// sentence in the buffer without the received line termination.
+// sempTerminateSentence ends the valid sentence in the buffer with a
+// carriage return and line feed before the sentence is delivered, where
+// received is the length including the received line termination.  The
+// sentence received with a carriage return followed by a line feed is
+// delivered as received, otherwise the line termination is replaced and
+// a sentence parsed in place is moved into the parse buffer.
+uint32_t sempSentenceLength(const SEMP_PARSE_STATE *parse);
+void sempTerminateSentence(SEMP_PARSE_STATE *parse, uint32_t received);
+
+// Count the fields of the sentence in the buffer and locate the asterisk,
+// building a field index without offsets for sempSentenceGetField
+void sempSentenceCountFields(const SEMP_PARSE_STATE *parse,
+                             SEMP_SENTENCE_FIELDS *fields,
+                             uint8_t separator);
+
+// Get a field of the sentence in the buffer using the field index, returns
+// nullptr when the field is not present.  Field 0 is the sentence name.
+const char * sempSentenceGetField(const SEMP_PARSE_STATE *parse,
+                                  const SEMP_SENTENCE_FIELDS *fields,
+                                  uint16_t field,
+                                  size_t *length);
+
 // The routine sempParseNextByte is used to parse the next data byte
 // from a raw data stream.
 void sempParseNextByte(SEMP_PARSE_STATE *parse, uint8_t data);
 
+// The routine sempParseBuffer is used to parse a block of data bytes,
+// such as a UART, DMA or TCP chunk, from a raw data stream.  The
+// parser produces exactly the same callbacks as passing each of the
+// data bytes to sempParseNextByte, but avoids the per-byte call overhead.
+void sempParseBuffer(SEMP_PARSE_STATE *parse, const uint8_t *data, size_t length);
+
 // The routine sempStopParser frees the parse data structure and sets
 // the pointer value to nullptr to prevent future references to the
-// freed structure.
+// freed structure.  Storage supplied by the caller is not freed.  The
+// batched messages are delivered before the structure is freed.
 void sempStopParser(SEMP_PARSE_STATE **parse);
 
 // Print the contents of the parser data structure
@@ -302,9 +1367,14 @@ void sempPrintf(Print *print, const char *format, ...);
 // Print a line of text
 void sempPrintln(Print *print, const char *string = "");
 
-// Translates state value into an ASCII state name
+// Translates state value into an ASCII state name.  The states of the
+// active parser are named using its state table, see sempBeginParser.
 const char * sempGetStateName(const SEMP_PARSE_STATE *parse);
 
+// Locate the name of a state routine in a state table, returns nullptr
+// if not found
+const char * sempFindStateName(const SEMP_STATE_TABLE *table, SEMP_PARSE_ROUTINE state);
+
 // Translate the type value into an ASCII type name
 const char * sempGetTypeName(SEMP_PARSE_STATE *parse, uint16_t type);
 
@@ -316,6 +1386,437 @@ void sempDisableDebugOutput(SEMP_PARSE_STATE *parse);
 void sempEnableErrorOutput(SEMP_PARSE_STATE *parse, Print *print = &Serial);
 void sempDisableErrorOutput(SEMP_PARSE_STATE *parse);
 
+// Enable or disable resynchronization.  When enabled and a parser
+// fails to parse a message, the bytes following the preamble are parsed
+// again from the parse buffer, allowing a valid message that starts
+// within the failed message to be found.  Messages that are too long
+// for the buffer are not parsed again.  Resync should not be used with
+// sempSbfSetInvalidDataCallback since the invalid data callback would
+// receive the data bytes multiple times.
+void sempEnableResync(SEMP_PARSE_STATE *parse);
+void sempDisableResync(SEMP_PARSE_STATE *parse);
+
+// Enable or disable zero-copy parsing.  When enabled, sempParseBuffer
+// parses the messages in the caller's buffer, such as a DMA ring buffer
+// segment or a memory mapped file, without copying the bytes into the
+// parse buffer.  During the eomCallback routine parse->buffer points at
+// the message within the caller's buffer and the offset of the message
+// is parse->buffer minus the address passed to sempParseBuffer.  Only
+// a message that is still incomplete at the end of the caller's buffer
+// is copied into the parse buffer, so a message wrapping around a ring
+// buffer is delivered contiguously from the parse buffer once the next
+// segment is passed to sempParseBuffer.  The caller's buffer is never
+// modified.  The NMEA and Unicore hash sentences always end with a
+// carriage return and line feed included in the length, wherever they
+// are delivered from.  A sentence received with a different line
+// termination is delivered from the parse buffer, and only the sentences
+// delivered from the parse buffer are zero terminated.  Change the
+// zero-copy mode only between calls to sempParseBuffer.  sempParseNextByte and parallel parsing always copy.
+void sempEnableZeroCopy(SEMP_PARSE_STATE *parse);
+void sempDisableZeroCopy(SEMP_PARSE_STATE *parse);
+
+#if SEMP_FEATURES
+// Enable or disable the message filters.  The filterTable contains a
+// SEMP_MESSAGE_FILTER for each parser in the parse table and remains in
+// use until the filters are disabled.  The parsers drop the messages
+// rejected by the filter as soon as the message ID or sentence name is
+// known, skipping the rest of the message without buffering it or
+// computing the CRC.  The rejected messages are counted in the filtered
+// statistics counter instead of being delivered.  Skipping trusts the
+// message length in the header, set validate to true to parse the rejected
+// messages and check their CRC before dropping them, which keeps the
+// parser from losing the following messages after a corrupted length.  The
+// parallel parsers use the filters of the parse structure passed to
+// sempEnableParallelParsing.
+void sempEnableMessageFilter(SEMP_PARSE_STATE *parse,
+                             const SEMP_MESSAGE_FILTER *filterTable,
+                             bool validate = false);
+void sempDisableMessageFilter(SEMP_PARSE_STATE *parse);
+
+// Enable or disable forwarding.  The sinkTable contains a
+// SEMP_FORWARD_SINK for each parser in the parse table and remains in use
+// until forwarding is disabled.  The message bytes are passed to the
+// write routine as they are parsed, at the end of each sempParseBuffer or
+// sempParseNextByte call, so forwarding starts before the message is
+// complete.  Once the CRC or checksum is verified the rest of the message
+// is written and the end routine is called with valid set to true, before
+// the eomCallback routine is called.  When the message fails after some
+// of its bytes were written, the end routine is called with valid set to
+// false, allowing the sink to roll back or flag the partial message.  The
+// messages rejected by the message filter are not forwarded.  The parallel
+// parsers use the sinks of the parse structure passed to
+// sempEnableParallelParsing and only forward the valid messages.
+void sempEnableForwarding(SEMP_PARSE_STATE *parse,
+                          const SEMP_FORWARD_SINK *sinkTable);
+void sempDisableForwarding(SEMP_PARSE_STATE *parse);
+
+// Enable or disable batch delivery.  When enabled, the valid messages are
+// copied into the caller's arena and described by the caller's array of
+// entries instead of being passed to the eomCallback routine.  The
+// callback routine receives the batch when the entries or the arena are
+// full, at the end of each sempParseBuffer call when eachBuffer is true,
+// and when sempFlushBatch is called.  This replaces a callback for each
+// message with a callback for each batch, amortizing the locking and
+// cache misses of the application's message handling.  The messages in
+// the arena are not zero terminated.  A message larger than the arena is
+// delivered by itself from the parse buffer.  The parallel parsers batch
+// into the parse structure passed to sempEnableParallelParsing.
+// sempDisableBatchDelivery delivers the batched messages before returning.
+void sempEnableBatchDelivery(SEMP_PARSE_STATE *parse,
+                             SEMP_BATCH_ENTRY *entries,
+                             uint16_t entryCount,
+                             uint8_t *arena,
+                             uint32_t arenaBytes,
+                             SEMP_BATCH_CALLBACK callback,
+                             bool eachBuffer = true);
+void sempDisableBatchDelivery(SEMP_PARSE_STATE *parse);
+
+// Pass the batched messages to the batch callback routine, such as after
+// a series of sempParseNextByte calls
+void sempFlushBatch(SEMP_PARSE_STATE *parse);
+
+// Enable or disable the binary log.  When enabled, the parsers record
+// each failed message in the caller's array of log entries without any
+// formatting, allowing the failures to be monitored in the field where
+// the debug output is too slow.  The array is used as a ring buffer
+// holding up to entryCount - 1 entries.  When the ring buffer is full
+// the oldest entry is overwritten and counted in logDropped.  The binary
+// log is independent of SEMP_LOG_LEVEL and the parallel parsers do not
+// record into the binary log.
+void sempEnableBinaryLog(SEMP_PARSE_STATE *parse,
+                         SEMP_LOG_ENTRY *entries,
+                         uint16_t entryCount);
+void sempDisableBinaryLog(SEMP_PARSE_STATE *parse);
+
+// Remove the oldest entry from the binary log, returns true when an
+// entry was copied into the caller's entry and false when empty
+bool sempReadBinaryLog(SEMP_PARSE_STATE *parse, SEMP_LOG_ENTRY *entry);
+#endif  // SEMP_FEATURES
+
+// Get the statistics counters for a parser in the parse table, returns
+// nullptr when the type is not a parseTable index or when SEMP_STATS is
+// zero.  The counters are updated without locks, read them from the
+// context that parses the data.  The parallel parsers update the counters
+// of the parse structure passed to sempEnableParallelParsing.  When
+// built with SEMP_LATENCY, the statistics include histograms of the time
+// from the preamble to the eomCallback routine, the latency from the
+// sempParseNextByte or sempParseBuffer call delivering the last byte of
+// the message to the eomCallback routine and the time spent in the
+// eomCallback routine.
+const SEMP_PARSER_STATS * sempGetStats(const SEMP_PARSE_STATE *parse, uint16_t type);
+
+// Get the upper limit of a latency histogram bucket in timestamp ticks,
+// returns zero (0) for the last bucket which has no limit
+uint32_t sempGetLatencyBucketLimit(int bucket);
+
+// Get the number of data bytes that no parser accepted as a preamble
+uint32_t sempGetDiscardedBytes(const SEMP_PARSE_STATE *parse);
+
+// Zero the statistics counters
+void sempResetStats(SEMP_PARSE_STATE *parse);
+
+#if SEMP_FEATURES
+// Enable or disable parallel parsing.  When enabled, each parser in the
+// parse table gets its own parse structure with a separate state,
+// scratch pad and buffer, and every data byte is passed to all of the
+// parsers.  The first parser to deliver a valid message wins and the
+// other parsers are reset to search for a preamble.  The eomCallback
+// routine receives the parse structure of the winning parser, allowing
+// the parser specific routines such as sempRtcmGetMessageNumber to be
+// used.  Set the debug output, error output and resync options before
+// enabling parallel parsing.  sempEnableParallelParsing returns true
+// when successful and false when the allocation fails.
+bool sempEnableParallelParsing(SEMP_PARSE_STATE *parse);
+void sempDisableParallelParsing(SEMP_PARSE_STATE *parse);
+#endif  // SEMP_FEATURES
+
+// The byte ring routines pass data from an interrupt routine, DMA or
+// another task to the parser without locks.  sempByteRingInit uses the
+// caller's storage, which must contain a power of two bytes and at least
+// SEMP_RING_MINIMUM_SIZE bytes.  Only one producer may write into the
+// ring, using sempByteRingWrite or sempByteRingWriteByte, which may be
+// called from an interrupt routine, or using sempByteRingGetSpace and
+// sempByteRingCommit to receive the data directly into the ring.  Only
+// one consumer may call sempParseByteRing, which passes all of the data
+// in the ring to sempParseBuffer in one pass and then frees the space.
+// With zero-copy enabled the messages are parsed in the ring.
+//
+// Initialize a byte ring, returns true when successful
+bool sempByteRingInit(SEMP_BYTE_RING *ring, uint8_t *storage, uint32_t size);
+
+// Add data bytes to the ring, returns the number of bytes added
+size_t sempByteRingWrite(SEMP_BYTE_RING *ring, const uint8_t *data, size_t length);
+
+// Add a data byte to the ring, returns true when the byte was added
+bool sempByteRingWriteByte(SEMP_BYTE_RING *ring, uint8_t data);
+
+// Get the address of the contiguous free space in the ring, returns the
+// number of free bytes at that address
+size_t sempByteRingGetSpace(SEMP_BYTE_RING *ring, uint8_t **space);
+
+// Add the bytes placed in the free space to the ring
+void sempByteRingCommit(SEMP_BYTE_RING *ring, size_t length);
+
+// Get the number of data bytes in the ring
+size_t sempByteRingAvailable(const SEMP_BYTE_RING *ring);
+
+// Parse all of the data bytes in the ring, returns the number of bytes parsed
+size_t sempParseByteRing(SEMP_PARSE_STATE *parse, SEMP_BYTE_RING *ring);
+
+// The message ring routines pass complete messages from the parser to
+// another context without locks, such as saving the messages in the
+// eomCallback routine and processing the messages in a lower priority
+// task.  sempMessageRingInit uses the caller's storage, which must be
+// aligned on an 8 byte boundary, contain a power of two bytes and at
+// least SEMP_RING_MINIMUM_SIZE bytes.  Each message uses SEMP_ALIGN(8 +
+// length) bytes.  Only one producer may call sempMessageRingWrite and
+// only one consumer may call sempMessageRingRead and
+// sempMessageRingRelease.  The message data follows the record header:
+//
+//     while ((record = sempMessageRingRead(&ring)))
+//     {
+//         processMessage(record->type, (const uint8_t *)&record[1], record->length);
+//         sempMessageRingRelease(&ring, record);
+//     }
+//
+// Initialize a message ring, returns true when successful
+bool sempMessageRingInit(SEMP_MESSAGE_RING *ring, uint8_t *storage, uint32_t size);
+
+// Add a message to the ring, returns false when the ring is full
+bool sempMessageRingWrite(SEMP_MESSAGE_RING *ring,
+                          uint16_t stream,
+                          uint16_t type,
+                          const uint8_t *data,
+                          size_t length);
+
+// Get the oldest message in the ring, returns nullptr when the ring is empty
+const SEMP_MESSAGE_RECORD * sempMessageRingRead(SEMP_MESSAGE_RING *ring);
+
+// Remove the oldest message from the ring
+void sempMessageRingRelease(SEMP_MESSAGE_RING *ring, const SEMP_MESSAGE_RECORD *record);
+
+#if SEMP_FEATURES
+// The pool routines parse many data streams, such as the outputs of
+// multiple receivers, using one parser per stream.  sempBeginPool creates
+// streamCount parsers using the same parse table and assigns stream n to
+// worker n modulo workerCount, so a stream is always parsed by the same
+// worker.  Each worker has an input queue of data chunks and an output
+// queue of messages, both queueBytes in size rounded up to a power of
+// two.  The queues are message rings, which need no locks:
+//
+//   * sempPoolParse places a chunk of stream data into the input queue of
+//     the stream's worker, returning false when the queue is full.  Only
+//     one context may pass data for the streams of a worker.
+//   * sempPoolRunWorker parses the queued chunks of one worker, placing
+//     the messages into the output queue of the worker.  Messages are
+//     counted in droppedMessages when the output queue is full.  Only one
+//     context may run a worker, such as a thread pinned to a core.
+//   * sempPoolDeliverMessages passes the queued messages of one worker to
+//     the pool callback.  Only one context may deliver the messages of a
+//     worker.
+//
+// On the ESP32, sempPoolStartTasks runs each worker in a FreeRTOS task
+// pinned to core n modulo the number of cores.  On other platforms, the
+// application runs the workers, such as calling sempPoolRunWorker in a
+// loop from one thread per worker.  Use sempPoolGetParser to change the
+// settings of a stream parser, such as enabling zero-copy, before the
+// stream data is parsed.
+//
+// Allocate and initialize a pool of parsers
+SEMP_POOL * sempBeginPool(const SEMP_PARSE_ROUTINE *parseTable,
+                          uint16_t parserCount,
+                          const char * const *parserNameTable,
+                          uint16_t parserNameCount,
+                          uint16_t scratchPadBytes,
+                          size_t bufferLength,
+                          uint16_t streamCount,
+                          uint16_t workerCount,
+                          size_t queueBytes,
+                          SEMP_POOL_CALLBACK callback,
+                          const char *name,
+                          Print *printError = &Serial,
+                          const int16_t *preambleTable = (const int16_t *)nullptr,
+                          const SEMP_STATE_TABLE * const *stateTables = (const SEMP_STATE_TABLE * const *)nullptr);
+
+// Queue a chunk of stream data for parsing, returns true when queued
+bool sempPoolParse(SEMP_POOL *pool, uint16_t stream, const uint8_t *data, size_t length);
+
+// Parse the data queued for a worker, returns true when data was parsed
+bool sempPoolRunWorker(SEMP_POOL *pool, uint16_t worker);
+
+// Pass the queued messages of a worker to the pool callback, returns the
+// number of messages delivered
+int sempPoolDeliverMessages(SEMP_POOL *pool, uint16_t worker);
+
+// Get the parse structure of a stream, returns nullptr for an invalid stream
+SEMP_PARSE_STATE * sempPoolGetParser(SEMP_POOL *pool, uint16_t stream);
+
+// Get the worker assigned to a stream
+uint16_t sempPoolGetWorker(const SEMP_POOL *pool, uint16_t stream);
+
+#ifdef ESP32
+// Run each worker in a FreeRTOS task, returns true when all of the tasks
+// are running.  The stack size is specified in bytes.
+bool sempPoolStartTasks(SEMP_POOL *pool, uint32_t stackBytes, uint32_t priority);
+#endif  // ESP32
+
+// The routine sempStopPool stops the worker tasks, frees the parsers and
+// the pool and sets the pointer value to nullptr
+void sempStopPool(SEMP_POOL **pool);
+#endif  // SEMP_FEATURES
+
+// The splitter routines parse a large block of data in memory, such as a
+// memory mapped log file, using multiple threads.  sempBeginSplitter
+// divides the data into chunkCount chunks.  Each call to
+// sempSplitterParseNextChunk parses the next unparsed chunk from the
+// beginning of the chunk with its own parser, using zero-copy and resync,
+// and continues past the end of the chunk until the parser is searching
+// for a preamble again, completing the message in progress.  The messages
+// found by the parser are saved.  sempSplitterParseNextChunk may be called
+// from multiple threads at the same time, such as:
+//
+//     while (sempSplitterParseNextChunk(splitter) >= 0)
+//         ;
+//
+// sempSplitterDeliverMessages passes the messages of the parsed chunks to
+// the callback routine in the order of the data, along with their offsets
+// in the data.  The messages found by a chunk before the offset where the
+// parse of the previous chunk ended are discarded, such as the messages
+// found when a chunk starts in the middle of a message.  The delivered
+// messages match parsing the data with a single parser unless the parser
+// of a chunk is within a message at the resume offset, which is rare for
+// chunks much larger than bufferLength.  The message bytes are passed
+// from the data, so an NMEA or Unicore hash sentence received without a
+// carriage return followed by a line feed is passed without its line
+// termination.  Only one thread may call sempSplitterDeliverMessages,
+// which may be called while the chunks are being parsed.  The data must
+// remain in memory until the splitter is stopped.
+//
+// Allocate and initialize a splitter
+SEMP_SPLITTER * sempBeginSplitter(const SEMP_PARSE_ROUTINE *parseTable,
+                                  uint16_t parserCount,
+                                  const char * const *parserNameTable,
+                                  uint16_t parserNameCount,
+                                  uint16_t scratchPadBytes,
+                                  size_t bufferLength,
+                                  const uint8_t *data,
+                                  size_t length,
+                                  uint32_t chunkCount,
+                                  SEMP_SPLIT_CALLBACK callback,
+                                  const char *name,
+                                  Print *printError = &Serial,
+                                  const int16_t *preambleTable = (const int16_t *)nullptr);
+
+// Parse the next chunk, returns the chunk number or -1 when all of the
+// chunks have been parsed
+int32_t sempSplitterParseNextChunk(SEMP_SPLITTER *splitter);
+
+// Pass the messages of the parsed chunks to the callback routine in data
+// order, returns the number of messages delivered
+size_t sempSplitterDeliverMessages(SEMP_SPLITTER *splitter);
+
+// Determine if all of the chunks have been delivered
+bool sempSplitterComplete(const SEMP_SPLITTER *splitter);
+
+// The routine sempStopSplitter frees the splitter and sets the pointer
+// value to nullptr
+void sempStopSplitter(SEMP_SPLITTER **splitter);
+
+// The epoch routines group the messages of a receiver epoch, allowing an
+// RTK engine to process complete observation epochs.  Call
+// sempEpochAddMessage from the eomCallback or batch callback routine for
+// each message.  The epoch of a message is determined by its parser:
+//
+//   * RTCM: MSM1 - MSM7 messages.  The epoch ends with the MSM message
+//     whose multiple message bit is zero.  The epoch time is the epoch
+//     time field of the first MSM message, which is GNSS specific.
+//   * u-blox: NAV class messages, grouped by iTOW.  The epoch ends with
+//     the NAV-EOE message or when the iTOW changes.
+//   * SBF: blocks with a valid TOW, grouped by TOW.  The epoch ends when
+//     the TOW changes.
+//   * Unicore binary: messages grouped by the header secondsOfWeek value.
+//     The epoch ends when the value changes.
+//
+// The other messages are passed to the callback routine by themselves
+// with the SEMP_EPOCH_SINGLE status, without ending the open epoch.  An
+// epoch message of another parser ends the open epoch.  An epoch with an
+// end marker is passed to the callback routine as soon as the last
+// message arrives, the other epochs when the next epoch starts.  The
+// messages are copied into the caller's arena and described by the
+// caller's array of entries.  When either is full, the messages are
+// passed to the callback routine with the SEMP_EPOCH_PARTIAL status and
+// the epoch continues.  A message larger than the arena is passed by
+// itself from the caller's buffer.  The entry id values of the epoch
+// messages are the filter message IDs, see SEMP_MESSAGE_FILTER, the other
+// messages use parse->messageId which is only valid in eomCallback.
+//
+// Initialize the epoch state, returns true when successful
+bool sempEpochInit(SEMP_EPOCH *epoch,
+                   SEMP_BATCH_ENTRY *entries,
+                   uint16_t entryCount,
+                   uint8_t *arena,
+                   uint32_t arenaBytes,
+                   SEMP_EPOCH_CALLBACK callback,
+                   void *context = nullptr);
+
+// Add a valid message to its epoch
+void sempEpochAddMessage(SEMP_EPOCH *epoch,
+                         const SEMP_PARSE_STATE *parse,
+                         uint16_t type,
+                         const uint8_t *message,
+                         size_t length);
+
+// Pass the messages of the open epoch to the callback routine with the
+// SEMP_EPOCH_ENDED status, such as at the end of the data
+void sempEpochFlush(SEMP_EPOCH *epoch);
+
+#if SEMP_STREAM_FD
+// The stream routines let a single event loop thread, such as one using
+// epoll, parse the data of many receiver connections without a thread
+// per connection.  sempStreamInit attaches the parser to a non-blocking
+// file descriptor and replaces the parser's eomCallback.  The input and
+// output storage follow the byte ring and message ring requirements.
+// When the file descriptor is readable, sempStreamRead reads the data
+// with readv directly into the free space of the input ring, wrapping
+// around the end of the ring, and passes the data to sempParseBuffer in
+// at most two pieces.  The messages are placed into the output ring and
+// counted in droppedMessages when the output ring is full.  The
+// application then removes the messages from the output ring:
+//
+//     if (sempStreamRead(stream) > 0)
+//         while ((record = sempStreamNextMessage(stream)))
+//         {
+//             processMessage(record->type, (const uint8_t *)&record[1], record->length);
+//             sempStreamRelease(stream, record);
+//         }
+//
+// With zero-copy enabled the messages are parsed in the input ring.  A
+// stream is used by one thread at a time.
+//
+// Initialize a stream, returns true when successful
+bool sempStreamInit(SEMP_STREAM *stream,
+                    SEMP_PARSE_STATE *parse,
+                    int fd,
+                    uint16_t number,
+                    uint8_t *inputStorage,
+                    uint32_t inputBytes,
+                    uint8_t *outputStorage,
+                    uint32_t outputBytes);
+
+// Read and parse the available data, returns the number of bytes read,
+// zero (0) at the end of the file or -1 with errno set upon error, such
+// as EAGAIN when no data is available.  With edge triggered epoll, call
+// sempStreamRead until it returns -1 with errno set to EAGAIN.
+ssize_t sempStreamRead(SEMP_STREAM *stream);
+
+// Get the oldest message of the stream, returns nullptr when no messages
+// are available
+const SEMP_MESSAGE_RECORD * sempStreamNextMessage(SEMP_STREAM *stream);
+
+// Remove the oldest message of the stream
+void sempStreamRelease(SEMP_STREAM *stream, const SEMP_MESSAGE_RECORD *record);
+#endif  // SEMP_STREAM_FD
+
 // The parser routines within a parser module are typically placed in
 // reverse order within the module.  This lets the routine declaration
 // proceed the routine use and eliminates the need for forward declaration.
@@ -324,39 +1825,108 @@ void sempDisableErrorOutput(SEMP_PARSE_STATE *parse);
 // should need to be listed below.
 
 // NMEA parse routines
+#define SEMP_NMEA_PREAMBLE                    '$'
 bool sempNmeaPreamble(SEMP_PARSE_STATE *parse, uint8_t data);
 bool sempNmeaFindFirstComma(SEMP_PARSE_STATE *parse, uint8_t data);
+extern const SEMP_STATE_TABLE sempNmeaStateTable;
 const char * sempNmeaGetStateName(const SEMP_PARSE_STATE *parse);
 const char * sempNmeaGetSentenceName(const SEMP_PARSE_STATE *parse);
 
+// Get the NMEA sentence ID, a SEMP_NMEA_ID_* value.  The sentence name is
+// classified once as it is received, letting the eomCallback dispatch
+// using an integer comparison instead of comparing the names.
+uint8_t sempNmeaGetSentenceId(const SEMP_PARSE_STATE *parse);
+
+// Get the number of fields in the NMEA sentence including the sentence
+// name, only valid within the eomCallback routine
+uint16_t sempNmeaGetFieldCount(const SEMP_PARSE_STATE *parse);
+
+// Get a field of the NMEA sentence, only valid within the eomCallback
+// routine.  The field is found without scanning the sentence when
+// SEMP_SENTENCE_FIELD_OFFSETS is defined.  Field 0 is the sentence name and
+// field 1 is the data following the first comma.  The field is not zero
+// terminated, its length in bytes is returned in length.  Returns nullptr
+// when the sentence does not have the field.
+const char * sempNmeaGetField(const SEMP_PARSE_STATE *parse, uint16_t field, size_t *length);
+
 // RTCM parse routines
+#define SEMP_RTCM_PREAMBLE                    0xd3
 bool sempRtcmPreamble(SEMP_PARSE_STATE *parse, uint8_t data);
+extern const SEMP_STATE_TABLE sempRtcmStateTable;
 const char * sempRtcmGetStateName(const SEMP_PARSE_STATE *parse);
 uint16_t sempRtcmGetMessageNumber(const SEMP_PARSE_STATE *parse);
 
+// The RTCM decode routines decode the bit fields of a valid RTCM message
+// in place, such as parse->buffer and parse->length in the eomCallback
+// routine, without copying the message.  The routines return false when
+// the message is not of the expected type or is too short for its fields.
+//
+// Prepare to read the bit fields of a payload
+void sempRtcmBitReaderInit(SEMP_RTCM_BIT_READER *reader,
+                           const uint8_t *payload,
+                           size_t length);
+
+// Read an unsigned field of 1 - SEMP_RTCM_MAX_FIELD_BITS bits
+uint64_t sempRtcmGetBits(SEMP_RTCM_BIT_READER *reader, int width);
+
+// Read a two's complement field of 1 - SEMP_RTCM_MAX_FIELD_BITS bits
+int64_t sempRtcmGetSignedBits(SEMP_RTCM_BIT_READER *reader, int width);
+
+// Skip a field of any width
+void sempRtcmSkipBits(SEMP_RTCM_BIT_READER *reader, uint32_t width);
+
+// Decode a MSM4, MSM5, MSM6 or MSM7 message
+bool sempRtcmDecodeMsm(const uint8_t *message, size_t length, SEMP_RTCM_MSM *msm);
+
+// Decode a 1005 or 1006 message
+bool sempRtcmDecode1005(const uint8_t *message, size_t length, SEMP_RTCM_1005 *station);
+
+// Decode a 1033 message
+bool sempRtcmDecode1033(const uint8_t *message, size_t length, SEMP_RTCM_1033 *descriptors);
+
 // u-blox parse routines
+#define SEMP_UBLOX_PREAMBLE                   0xb5
 bool sempUbloxPreamble(SEMP_PARSE_STATE *parse, uint8_t data);
+extern const SEMP_STATE_TABLE sempUbloxStateTable;
 const char * sempUbloxGetStateName(const SEMP_PARSE_STATE *parse);
 uint16_t sempUbloxGetMessageNumber(const SEMP_PARSE_STATE *parse); // |- Class (8 bits) -||- ID (8 bits) -|
 
 // Unicore binary parse routines
+#define SEMP_UNICORE_BINARY_PREAMBLE          0xaa
 bool sempUnicoreBinaryPreamble(SEMP_PARSE_STATE *parse, uint8_t data);
+extern const SEMP_STATE_TABLE sempUnicoreBinaryStateTable;
 const char * sempUnicoreBinaryGetStateName(const SEMP_PARSE_STATE *parse);
 void sempUnicoreBinaryPrintHeader(SEMP_PARSE_STATE *parse);
 
 // Unicore hash (#) parse routines
+#define SEMP_UNICORE_HASH_PREAMBLE            '#'
 bool sempUnicoreHashPreamble(SEMP_PARSE_STATE *parse, uint8_t data);
+extern const SEMP_STATE_TABLE sempUnicoreHashStateTable;
 const char * sempUnicoreHashGetStateName(const SEMP_PARSE_STATE *parse);
 void sempUnicoreHashPrintHeader(SEMP_PARSE_STATE *parse);
 const char * sempUnicoreHashGetSentenceName(const SEMP_PARSE_STATE *parse);
 
+// Get the Unicore hash (#) sentence ID, a SEMP_UNICORE_HASH_ID_* value
+uint8_t sempUnicoreHashGetSentenceId(const SEMP_PARSE_STATE *parse);
+
+// Get the number of fields in the Unicore hash (#) sentence, the semicolon
+// ending the header also separates the fields
+uint16_t sempUnicoreHashGetFieldCount(const SEMP_PARSE_STATE *parse);
+
+// Get a field of the Unicore hash (#) sentence, see sempNmeaGetField
+const char * sempUnicoreHashGetField(const SEMP_PARSE_STATE *parse, uint16_t field, size_t *length);
+
 // SPARTN parse routines
+#define SEMP_SPARTN_PREAMBLE                  0x73
 bool sempSpartnPreamble(SEMP_PARSE_STATE *parse, uint8_t data);
+extern const SEMP_STATE_TABLE sempSpartnStateTable;
 const char * sempSpartnGetStateName(const SEMP_PARSE_STATE *parse);
 uint8_t sempSpartnGetMessageType(const SEMP_PARSE_STATE *parse);
 
 // SBF parse routines
+#define SEMP_SBF_PREAMBLE                     '$'
 bool sempSbfPreamble(SEMP_PARSE_STATE *parse, uint8_t data);
+extern const SEMP_STATE_TABLE sempSbfStateTable;
 const char * sempSbfGetStateName(const SEMP_PARSE_STATE *parse);
 void sempSbfSetInvalidDataCallback(const SEMP_PARSE_STATE *parse, SEMP_INVALID_DATA_CALLBACK invalidDataCallback);
 uint16_t sempSbfGetBlockNumber(const SEMP_PARSE_STATE *parse);
@@ -0,0 +1,368 @@
+/*------------------------------------------------------------------------------
+SparkFun_Extensible_Message_Parser_Set.h
+
+Parser front end for a set of parsers known at compile time
+
+The parse table, name table and preamble table are built by the compiler
+from the protocol list and the parse structure is placed in storage sized
+by the compiler, so no allocation is needed.  The preamble search is
+compiled for the protocols in the set: the first byte of each message is
+compared with the protocol preambles in line and the matching preamble
+routines are called directly instead of walking the parse table through
+function pointers.  The bytes within a message are passed to the protocol
+state routines in the same way as sempParseBuffer.
+
+    SEMP_PARSER_SET<3000, SEMP_RTCM_PROTOCOL, SEMP_UBLOX_PROTOCOL, SEMP_NMEA_PROTOCOL> parser;
+
+    parser.begin(processMessage, "Parser");
+    parser.parseBuffer(data, length);
+
+The callbacks are identical to those of a parser created by
+sempBeginParser with the same tables, and parser.parse is passed to the
+other semp routines.
+
+License: MIT. Please see LICENSE.md for more details
+------------------------------------------------------------------------------*/
+
+#ifndef __SPARKFUN_EXTENSIBLE_MESSAGE_PARSER_SET_H__
+#define __SPARKFUN_EXTENSIBLE_MESSAGE_PARSER_SET_H__
+
+#include "SparkFun_Extensible_Message_Parser.h"
+
+//----------------------------------------
+// Protocols
+//----------------------------------------
+
+// Describe a protocol for SEMP_PARSER_SET.  A user parser is added by
+// describing it the same way, using the number of scratch pad bytes the
+// parser needs, or zero (0) when SEMP_SCRATCH_PAD is large enough.  Use
+// SEMP_PROTOCOL_STATES to also specify the address of the state table.
+#define SEMP_PROTOCOL_STATES(protocol, protocolName, preambleByte, preambleRoutine, scratchPadBytes, stateTable) \
+struct protocol                                                             \
+{                                                                           \
+    static constexpr const char *NAME = protocolName;                       \
+    static const int16_t PREAMBLE = preambleByte;                           \
+    static constexpr SEMP_PARSE_ROUTINE PREAMBLE_ROUTINE = preambleRoutine; \
+    static const uint16_t SCRATCH_PAD_BYTES = scratchPadBytes;              \
+    static constexpr const SEMP_STATE_TABLE *STATE_TABLE = stateTable;      \
+}
+
+#define SEMP_PROTOCOL(protocol, protocolName, preambleByte, preambleRoutine, scratchPadBytes)   \
+    SEMP_PROTOCOL_STATES(protocol, protocolName, preambleByte, preambleRoutine, scratchPadBytes, \
+                         (const SEMP_STATE_TABLE *)nullptr)
+
+SEMP_PROTOCOL_STATES(SEMP_NMEA_PROTOCOL, "NMEA", SEMP_NMEA_PREAMBLE, sempNmeaPreamble, 0, &sempNmeaStateTable);
+SEMP_PROTOCOL_STATES(SEMP_RTCM_PROTOCOL, "RTCM", SEMP_RTCM_PREAMBLE, sempRtcmPreamble, 0, &sempRtcmStateTable);
+SEMP_PROTOCOL_STATES(SEMP_SBF_PROTOCOL, "SBF", SEMP_SBF_PREAMBLE, sempSbfPreamble, 0, &sempSbfStateTable);
+SEMP_PROTOCOL_STATES(SEMP_SPARTN_PROTOCOL, "SPARTN", SEMP_SPARTN_PREAMBLE, sempSpartnPreamble, 0, &sempSpartnStateTable);
+SEMP_PROTOCOL_STATES(SEMP_UBLOX_PROTOCOL, "UBLOX", SEMP_UBLOX_PREAMBLE, sempUbloxPreamble, 0, &sempUbloxStateTable);
+SEMP_PROTOCOL_STATES(SEMP_UNICORE_BINARY_PROTOCOL, "Unicore binary", SEMP_UNICORE_BINARY_PREAMBLE, sempUnicoreBinaryPreamble, 0, &sempUnicoreBinaryStateTable);
+SEMP_PROTOCOL_STATES(SEMP_UNICORE_HASH_PROTOCOL, "Unicore hash", SEMP_UNICORE_HASH_PREAMBLE, sempUnicoreHashPreamble, 0, &sempUnicoreHashStateTable);
+
+//----------------------------------------
+// Preamble dispatch
+//----------------------------------------
+
+// Walk the protocol list at compile time, INDEX is the parse table index
+// of the first protocol in the list
+template <uint16_t INDEX, typename... PROTOCOLS>
+struct SEMP_PROTOCOL_LIST
+{
+    static const uint16_t SCRATCH_PAD_BYTES = 0;
+
+    // No protocol accepted the preamble byte
+    static inline uint16_t startMessage(SEMP_PARSE_STATE *parse, uint8_t data)
+    {
+        (void)parse;
+        (void)data;
+        return INDEX;
+    }
+};
+
+template <uint16_t INDEX, typename PROTOCOL, typename... PROTOCOLS>
+struct SEMP_PROTOCOL_LIST<INDEX, PROTOCOL, PROTOCOLS...>
+{
+    typedef SEMP_PROTOCOL_LIST<INDEX + 1, PROTOCOLS...> NEXT;
+
+    static const uint16_t SCRATCH_PAD_BYTES = SEMP_MAX(PROTOCOL::SCRATCH_PAD_BYTES,
+                                                       NEXT::SCRATCH_PAD_BYTES);
+
+    // Call the preamble routines that accept the data byte in parse table
+    // order, returns the parse table index of the protocol starting the
+    // message or the number of protocols when none accepted the byte.  A
+    // parser may accept any byte at run time, see sempPreambleAcceptsAnyByte.
+    static inline uint16_t startMessage(SEMP_PARSE_STATE *parse, uint8_t data)
+    {
+        if (((PROTOCOL::PREAMBLE == data)
+             || (parse->preambles[INDEX] == SEMP_PREAMBLE_ANY))
+            && PROTOCOL::PREAMBLE_ROUTINE(parse, data))
+            return INDEX;
+        return NEXT::startMessage(parse, data);
+    }
+};
+
+//----------------------------------------
+// Parser set
+//----------------------------------------
+
+template <size_t BUFFER_LENGTH, typename... PROTOCOLS>
+class SEMP_PARSER_SET
+{
+  public:
+
+    typedef SEMP_PROTOCOL_LIST<0, PROTOCOLS...> LIST;
+
+    static const uint16_t PARSER_COUNT = sizeof...(PROTOCOLS);
+
+    static const size_t STORAGE_BYTES =
+        SEMP_PARSER_STORAGE_SIZE(LIST::SCRATCH_PAD_BYTES, BUFFER_LENGTH)
+        + SEMP_STATS_STORAGE_SIZE(PARSER_COUNT)
+        + SEMP_PREAMBLE_STORAGE_SIZE(PARSER_COUNT);
+
+    static const SEMP_PARSE_ROUTINE parseTable[PARSER_COUNT];
+    static const char * const parserNames[PARSER_COUNT];
+    static const int16_t preambleTable[PARSER_COUNT];
+    static const SEMP_STATE_TABLE * const stateTables[PARSER_COUNT];
+
+    SEMP_PARSE_STATE *parse;    // Parse structure, nullptr until begin succeeds
+
+    SEMP_PARSER_SET() : parse(nullptr)
+    {
+    }
+
+    // Initialize the parse structure, returns nullptr upon failure
+    SEMP_PARSE_STATE * begin(SEMP_EOM_CALLBACK eomCallback,
+                             const char *name,
+                             Print *printError = &Serial,
+                             Print *printDebug = (Print *)nullptr,
+                             SEMP_BAD_CRC_CALLBACK badCrcCallback = (SEMP_BAD_CRC_CALLBACK)nullptr)
+    {
+        parse = sempBeginParserWithStorage(storage, sizeof(storage),
+                                           parseTable, PARSER_COUNT,
+                                           parserNames, PARSER_COUNT,
+                                           LIST::SCRATCH_PAD_BYTES, BUFFER_LENGTH,
+                                           eomCallback, name, printError,
+                                           printDebug, badCrcCallback, preambleTable,
+                                           stateTables);
+        return parse;
+    }
+
+    // Parse the next byte
+    void parseNextByte(uint8_t data)
+    {
+        if (parse)
+        {
+#if SEMP_LATENCY
+            parse->features->receiveTime = SEMP_TIMESTAMP();
+#endif  // SEMP_LATENCY
+            parseByte(parse->buffer, parse->bufferLength, data);
+
+#if SEMP_FEATURES
+            // Forward the data byte
+            if (parse->forwardSink)
+                sempForwardFlush(parse);
+#endif  // SEMP_FEATURES
+        }
+    }
+
+    // Parse a buffer of data bytes, producing the same callbacks as
+    // sempParseBuffer
+    void parseBuffer(const uint8_t *data, size_t length)
+    {
+        uint8_t *buffer;
+        uint32_t bufferLength;
+        uint8_t byte;
+        size_t bytes;
+        const uint8_t *end;
+        const uint8_t *start;
+
+        // Zero-copy and parallel parsing use the general parse loop
+        if ((!parse) || (!data) || parse->zeroCopy
+#if SEMP_FEATURES
+            || parse->features->parallelParsers
+#endif  // SEMP_FEATURES
+            )
+        {
+            sempParseBuffer(parse, data, length);
+            return;
+        }
+
+#if SEMP_LATENCY
+        parse->features->receiveTime = SEMP_TIMESTAMP();
+#endif  // SEMP_LATENCY
+
+        // The buffer does not move while parsing, keep it in locals
+        buffer = parse->buffer;
+        bufferLength = parse->bufferLength;
+
+        // Pass each of the data bytes to the parser
+        end = &data[length];
+        while (data < end)
+        {
+            // Search for the preamble of the next message
+            if ((parse->state == sempFirstByte) && (!parse->messageStarted)
+                && (!parse->consumeBytes))
+            {
+                // Skip the data bytes that are not a preamble for any parser
+                if (parse->preambleScan[0])
+                {
+                    start = data;
+                    data = sempScanForPreamble(parse, data, end);
+
+                    // Pass the last skipped byte to the parser to leave the
+                    // parser in the same state as parsing each of the bytes
+                    if (data > start)
+                        data--;
+                    SEMP_STATS_DISCARD(parse, data - start);
+                }
+
+                // Call the preamble routines directly
+                byte = *data++;
+                if (parse->length >= bufferLength)
+                    sempMessageTooLong(parse, byte);
+                else
+                {
+                    parse->dataIndex = parse->length;
+                    firstByte(buffer, byte);
+                }
+                continue;
+            }
+
+            // Let the parser state consume a run of bytes when possible
+            if (parse->consumeBytes)
+            {
+                bytes = parse->consumeBytes(parse, data, end - data);
+                data += bytes;
+                if (data >= end)
+                    break;
+            }
+
+            byte = *data++;
+
+            // Verify that enough space exists in the buffer
+            if (parse->length >= bufferLength)
+            {
+                sempMessageTooLong(parse, byte);
+                continue;
+            }
+
+            // Save the data byte
+            parse->dataIndex = parse->length;
+            buffer[parse->length++] = byte;
+
+            // Compute the CRC value for the message
+            if (parse->computeCrc)
+                parse->crc = parse->computeCrc(parse, byte);
+
+            // Update the parser state based on the incoming byte
+            parse->state(parse, byte);
+        }
+
+#if SEMP_FEATURES
+        // Forward the partial message
+        if (parse->forwardSink)
+            sempForwardFlush(parse);
+
+        // Deliver the messages batched while parsing the buffer
+        if (parse->features->batchEachBuffer)
+            sempFlushBatch(parse);
+#endif  // SEMP_FEATURES
+    }
+
+  private:
+
+    uint64_t storage[(STORAGE_BYTES + sizeof(uint64_t) - 1) / sizeof(uint64_t)];
+
+    // Search for the preamble of the next message, matches sempFirstByte
+    // when the parser is not rescanning a failed message
+    inline void firstByte(uint8_t *buffer, uint8_t data)
+    {
+        uint16_t type;
+
+        // Add this byte to the buffer
+#if SEMP_FEATURES
+        parse->messageRejected = false;
+#endif  // SEMP_FEATURES
+        parse->messageFailed = false;
+        parse->crc = 0;
+        parse->computeCrc = nullptr;
+        parse->consumeBytes = nullptr;
+        parse->length = 0;
+        parse->type = PARSER_COUNT;
+        buffer[parse->length++] = data;
+
+        // Call the preamble routines that accept this byte
+        type = LIST::startMessage(parse, data);
+        if (type < PARSER_COUNT)
+        {
+#if SEMP_LATENCY
+            parse->features->preambleTime = SEMP_TIMESTAMP();
+#endif  // SEMP_LATENCY
+            parse->type = type;
+            parse->messageStarted = true;
+#if SEMP_FEATURES
+            if (parse->features->forwardSinks)
+                sempForwardStart(parse);
+#endif  // SEMP_FEATURES
+            return;
+        }
+
+        // Preamble byte not found, continue searching for a preamble byte
+        SEMP_STATS_DISCARD(parse, 1);
+        parse->state = sempFirstByte;
+    }
+
+    // Pass a data byte to the parser state, matches sempParseNextByte
+    inline void parseByte(uint8_t *buffer, uint32_t bufferLength, uint8_t data)
+    {
+        // Verify that enough space exists in the buffer
+        if (parse->length >= bufferLength)
+        {
+            sempMessageTooLong(parse, data);
+            return;
+        }
+
+        // Save the data byte
+        parse->dataIndex = parse->length;
+        buffer[parse->length++] = data;
+
+        // Compute the CRC value for the message
+        if (parse->computeCrc)
+            parse->crc = parse->computeCrc(parse, data);
+
+        // Update the parser state based on the incoming byte, calling the
+        // preamble routines directly when searching for a preamble
+        if ((parse->state == sempFirstByte) && (!parse->messageStarted)
+            && (!parse->consumeBytes))
+            firstByte(buffer, data);
+        else
+            parse->state(parse, data);
+    }
+};
+
+// Tables built from the protocol list
+template <size_t BUFFER_LENGTH, typename... PROTOCOLS>
+const SEMP_PARSE_ROUTINE SEMP_PARSER_SET<BUFFER_LENGTH, PROTOCOLS...>::parseTable[] =
+{
+    PROTOCOLS::PREAMBLE_ROUTINE...
+};
+
+template <size_t BUFFER_LENGTH, typename... PROTOCOLS>
+const char * const SEMP_PARSER_SET<BUFFER_LENGTH, PROTOCOLS...>::parserNames[] =
+{
+    PROTOCOLS::NAME...
+};
+
+template <size_t BUFFER_LENGTH, typename... PROTOCOLS>
+const int16_t SEMP_PARSER_SET<BUFFER_LENGTH, PROTOCOLS...>::preambleTable[] =
+{
+    PROTOCOLS::PREAMBLE...
+};
+
+template <size_t BUFFER_LENGTH, typename... PROTOCOLS>
+const SEMP_STATE_TABLE * const SEMP_PARSER_SET<BUFFER_LENGTH, PROTOCOLS...>::stateTables[] =
+{
+    PROTOCOLS::STATE_TABLE...
+};
+
+#endif  // __SPARKFUN_EXTENSIBLE_MESSAGE_PARSER_SET_H__
@@ -0,0 +1,290 @@
+/*------------------------------------------------------------------------------
+SparkFun_Extensible_Message_Parser_Views.h
+
+Lazy views of the commonly used u-blox, RTCM and Unicore binary messages
+
+A view locates a message in the buffer and decodes each field only when
+the field is read, using the field accessors.  Nothing is copied, so a
+consumer reading only a few fields of a large message only pays for
+those fields.  The views are created in the eomCallback routine, or from
+the message passed to a pool or splitter callback, and are only valid
+while the message remains in the buffer.
+
+    SEMP_UBLOX_NAV_PVT_VIEW pvt(parse->buffer, parse->length);
+
+    if (pvt.valid())
+        Serial.printf("%d SVs, lat %ld, lon %ld\r\n",
+                      pvt.numSV(), pvt.lat(), pvt.lon());
+
+License: MIT. Please see LICENSE.md for more details
+------------------------------------------------------------------------------*/
+
+#ifndef __SPARKFUN_EXTENSIBLE_MESSAGE_PARSER_VIEWS_H__
+#define __SPARKFUN_EXTENSIBLE_MESSAGE_PARSER_VIEWS_H__
+
+#include "SparkFun_Extensible_Message_Parser.h"
+
+//----------------------------------------
+// Constants
+//----------------------------------------
+
+// u-blox messages, class in the upper 8 bits, ID in the lower 8 bits,
+// matching sempUbloxGetMessageNumber
+#define SEMP_UBLOX_NAV_PVT              0x0107
+#define SEMP_UBLOX_RXM_RAWX             0x0215
+
+#define SEMP_UBLOX_HEADER_BYTES         6   // Sync, class, ID and length
+#define SEMP_UBLOX_NAV_PVT_BYTES        92  // Payload length
+#define SEMP_UBLOX_RXM_RAWX_BYTES       16  // Payload length without measurements
+#define SEMP_UBLOX_RXM_RAWX_MEAS_BYTES  32  // Bytes per measurement
+
+// RTCM framing
+#define SEMP_RTCM_HEADER_BYTES          3   // Preamble and length
+#define SEMP_RTCM_CRC_BYTES             3
+
+// Unicore binary messages
+#define SEMP_UNICORE_BESTNAV            2118
+#define SEMP_UNICORE_BESTNAV_BYTES      120 // Payload length
+
+//----------------------------------------
+// u-blox views
+//----------------------------------------
+
+// View of the u-blox message framing
+struct SEMP_UBLOX_VIEW
+{
+    const uint8_t *message;        // Start of the message, nullptr when invalid
+    uint16_t payloadLength;        // Payload length from the header
+
+    // Locate the payload of a u-blox message
+    SEMP_UBLOX_VIEW(const uint8_t *data, size_t length)
+        : message(nullptr), payloadLength(0)
+    {
+        if (data
+            && (length >= (SEMP_UBLOX_HEADER_BYTES + 2))
+            && (data[0] == 0xb5) && (data[1] == 0x62))
+        {
+            payloadLength = sempReadU2Le(&data[4]);
+            if (length >= (size_t)(SEMP_UBLOX_HEADER_BYTES + payloadLength + 2))
+                message = data;
+        }
+    }
+
+    bool valid() const { return message != nullptr; }
+    uint16_t messageNumber() const { return sempReadU2Be(&message[2]); }
+    const uint8_t * payload() const { return &message[SEMP_UBLOX_HEADER_BYTES]; }
+};
+
+// View of a u-blox NAV-PVT message, the units are listed in the u-blox
+// interface description
+struct SEMP_UBLOX_NAV_PVT_VIEW
+{
+    const uint8_t *payload;        // Start of the payload, nullptr when invalid
+
+    // Locate the payload of a NAV-PVT message
+    SEMP_UBLOX_NAV_PVT_VIEW(const uint8_t *data, size_t length)
+        : payload(nullptr)
+    {
+        SEMP_UBLOX_VIEW ubx(data, length);
+
+        if (ubx.valid()
+            && (ubx.messageNumber() == SEMP_UBLOX_NAV_PVT)
+            && (ubx.payloadLength >= SEMP_UBLOX_NAV_PVT_BYTES))
+            payload = ubx.payload();
+    }
+
+    bool valid() const { return payload != nullptr; }
+    uint32_t iTOW() const { return sempReadU4Le(&payload[0]); }        // ms
+    uint16_t year() const { return sempReadU2Le(&payload[4]); }
+    uint8_t month() const { return payload[6]; }
+    uint8_t day() const { return payload[7]; }
+    uint8_t hour() const { return payload[8]; }
+    uint8_t min() const { return payload[9]; }
+    uint8_t sec() const { return payload[10]; }
+    uint8_t validFlags() const { return payload[11]; }                 // valid field
+    uint32_t tAcc() const { return sempReadU4Le(&payload[12]); }       // ns
+    int32_t nano() const { return sempReadI4Le(&payload[16]); }        // ns
+    uint8_t fixType() const { return payload[20]; }
+    uint8_t flags() const { return payload[21]; }
+    uint8_t flags2() const { return payload[22]; }
+    uint8_t numSV() const { return payload[23]; }
+    int32_t lon() const { return sempReadI4Le(&payload[24]); }         // 1e-7 deg
+    int32_t lat() const { return sempReadI4Le(&payload[28]); }         // 1e-7 deg
+    int32_t height() const { return sempReadI4Le(&payload[32]); }      // mm
+    int32_t hMSL() const { return sempReadI4Le(&payload[36]); }        // mm
+    uint32_t hAcc() const { return sempReadU4Le(&payload[40]); }       // mm
+    uint32_t vAcc() const { return sempReadU4Le(&payload[44]); }       // mm
+    int32_t velN() const { return sempReadI4Le(&payload[48]); }        // mm/s
+    int32_t velE() const { return sempReadI4Le(&payload[52]); }        // mm/s
+    int32_t velD() const { return sempReadI4Le(&payload[56]); }        // mm/s
+    int32_t gSpeed() const { return sempReadI4Le(&payload[60]); }      // mm/s
+    int32_t headMot() const { return sempReadI4Le(&payload[64]); }     // 1e-5 deg
+    uint32_t sAcc() const { return sempReadU4Le(&payload[68]); }       // mm/s
+    uint32_t headAcc() const { return sempReadU4Le(&payload[72]); }    // 1e-5 deg
+    uint16_t pDOP() const { return sempReadU2Le(&payload[76]); }       // 0.01
+    uint16_t flags3() const { return sempReadU2Le(&payload[78]); }
+    int32_t headVeh() const { return sempReadI4Le(&payload[84]); }     // 1e-5 deg
+    int16_t magDec() const { return sempReadI2Le(&payload[88]); }      // 1e-2 deg
+    uint16_t magAcc() const { return sempReadU2Le(&payload[90]); }     // 1e-2 deg
+};
+
+// View of a u-blox RXM-RAWX message, the measurements are selected by index
+struct SEMP_UBLOX_RXM_RAWX_VIEW
+{
+    const uint8_t *payload;        // Start of the payload, nullptr when invalid
+
+    // Locate the payload of a RXM-RAWX message, verifying that all of the
+    // measurements are present
+    SEMP_UBLOX_RXM_RAWX_VIEW(const uint8_t *data, size_t length)
+        : payload(nullptr)
+    {
+        SEMP_UBLOX_VIEW ubx(data, length);
+
+        if (ubx.valid()
+            && (ubx.messageNumber() == SEMP_UBLOX_RXM_RAWX)
+            && (ubx.payloadLength >= SEMP_UBLOX_RXM_RAWX_BYTES)
+            && (ubx.payloadLength >= (SEMP_UBLOX_RXM_RAWX_BYTES
+                                      + ubx.payload()[11] * SEMP_UBLOX_RXM_RAWX_MEAS_BYTES)))
+            payload = ubx.payload();
+    }
+
+    bool valid() const { return payload != nullptr; }
+    double rcvTow() const { return sempReadF8Le(&payload[0]); }        // s
+    uint16_t week() const { return sempReadU2Le(&payload[8]); }
+    int8_t leapS() const { return sempReadI1(&payload[10]); }          // s
+    uint8_t numMeas() const { return payload[11]; }
+    uint8_t recStat() const { return payload[12]; }
+    uint8_t version() const { return payload[13]; }
+
+    // Measurement fields, index < numMeas()
+    const uint8_t * meas(int index) const
+    {
+        return &payload[SEMP_UBLOX_RXM_RAWX_BYTES + index * SEMP_UBLOX_RXM_RAWX_MEAS_BYTES];
+    }
+    double prMes(int index) const { return sempReadF8Le(&meas(index)[0]); }    // m
+    double cpMes(int index) const { return sempReadF8Le(&meas(index)[8]); }    // cycles
+    float doMes(int index) const { return sempReadF4Le(&meas(index)[16]); }    // Hz
+    uint8_t gnssId(int index) const { return meas(index)[20]; }
+    uint8_t svId(int index) const { return meas(index)[21]; }
+    uint8_t sigId(int index) const { return meas(index)[22]; }
+    uint8_t freqId(int index) const { return meas(index)[23]; }
+    uint16_t locktime(int index) const { return sempReadU2Le(&meas(index)[24]); } // ms
+    uint8_t cno(int index) const { return meas(index)[26]; }         // dBHz
+    uint8_t prStdev(int index) const { return meas(index)[27]; }
+    uint8_t cpStdev(int index) const { return meas(index)[28]; }
+    uint8_t doStdev(int index) const { return meas(index)[29]; }
+    uint8_t trkStat(int index) const { return meas(index)[30]; }
+};
+
+//----------------------------------------
+// RTCM views
+//----------------------------------------
+
+// View of the RTCM message framing, the payload fields are bit packed
+struct SEMP_RTCM_VIEW
+{
+    const uint8_t *message;        // Start of the message, nullptr when invalid
+    uint16_t payloadLength;        // Payload length from the header
+
+    // Locate the payload of a RTCM message
+    SEMP_RTCM_VIEW(const uint8_t *data, size_t length)
+        : message(nullptr), payloadLength(0)
+    {
+        if (data && (length >= (SEMP_RTCM_HEADER_BYTES + 2 + SEMP_RTCM_CRC_BYTES))
+            && (data[0] == 0xd3))
+        {
+            payloadLength = sempReadU2Be(&data[1]) & 0x3ff;
+            if ((payloadLength >= 2)
+                && (length >= (size_t)(SEMP_RTCM_HEADER_BYTES + payloadLength + SEMP_RTCM_CRC_BYTES)))
+                message = data;
+        }
+    }
+
+    bool valid() const { return message != nullptr; }
+    uint16_t messageNumber() const { return sempReadU2Be(&message[3]) >> 4; }
+    const uint8_t * payload() const { return &message[SEMP_RTCM_HEADER_BYTES]; }
+    uint32_t crc() const { return sempReadU3Be(&message[SEMP_RTCM_HEADER_BYTES + payloadLength]); }
+};
+
+//----------------------------------------
+// Unicore binary views
+//----------------------------------------
+
+// View of the Unicore binary header, see SEMP_UNICORE_HEADER
+struct SEMP_UNICORE_HEADER_VIEW
+{
+    const uint8_t *message;        // Start of the message, nullptr when invalid
+
+    // Locate the header of a Unicore binary message
+    SEMP_UNICORE_HEADER_VIEW(const uint8_t *data, size_t length)
+        : message(nullptr)
+    {
+        if (data && (length >= (sizeof(SEMP_UNICORE_HEADER) + 4))
+            && (data[0] == 0xaa) && (data[1] == 0x44) && (data[2] == 0xb5)
+            && (length >= (sizeof(SEMP_UNICORE_HEADER) + sempReadU2Le(&data[6]) + 4)))
+            message = data;
+    }
+
+    bool valid() const { return message != nullptr; }
+    uint8_t cpuIdlePercent() const { return message[3]; }
+    uint16_t messageId() const { return sempReadU2Le(&message[4]); }
+    uint16_t messageLength() const { return sempReadU2Le(&message[6]); }
+    uint8_t referenceTime() const { return message[8]; }
+    uint8_t timeStatus() const { return message[9]; }
+    uint16_t weekNumber() const { return sempReadU2Le(&message[10]); }
+    uint32_t secondsOfWeek() const { return sempReadU4Le(&message[12]); } // ms
+    uint8_t releasedVersion() const { return message[20]; }
+    uint8_t leapSeconds() const { return message[21]; }
+    uint16_t outputDelayMSec() const { return sempReadU2Le(&message[22]); }
+    const uint8_t * payload() const { return &message[sizeof(SEMP_UNICORE_HEADER)]; }
+};
+
+// View of a Unicore BESTNAV message, the position solution followed by
+// the velocity solution
+struct SEMP_UNICORE_BESTNAV_VIEW
+{
+    const uint8_t *payload;        // Start of the payload, nullptr when invalid
+
+    // Locate the payload of a BESTNAV message
+    SEMP_UNICORE_BESTNAV_VIEW(const uint8_t *data, size_t length)
+        : payload(nullptr)
+    {
+        SEMP_UNICORE_HEADER_VIEW header(data, length);
+
+        if (header.valid()
+            && (header.messageId() == SEMP_UNICORE_BESTNAV)
+            && (header.messageLength() >= SEMP_UNICORE_BESTNAV_BYTES))
+            payload = header.payload();
+    }
+
+    bool valid() const { return payload != nullptr; }
+    uint32_t solutionStatus() const { return sempReadU4Le(&payload[0]); }
+    uint32_t positionType() const { return sempReadU4Le(&payload[4]); }
+    double latitude() const { return sempReadF8Le(&payload[8]); }      // deg
+    double longitude() const { return sempReadF8Le(&payload[16]); }    // deg
+    double height() const { return sempReadF8Le(&payload[24]); }       // m
+    float undulation() const { return sempReadF4Le(&payload[32]); }    // m
+    uint32_t datumId() const { return sempReadU4Le(&payload[36]); }
+    float latitudeStd() const { return sempReadF4Le(&payload[40]); }   // m
+    float longitudeStd() const { return sempReadF4Le(&payload[44]); }  // m
+    float heightStd() const { return sempReadF4Le(&payload[48]); }     // m
+    const uint8_t * stationId() const { return &payload[52]; }         // 4 characters
+    float differentialAge() const { return sempReadF4Le(&payload[56]); } // s
+    float solutionAge() const { return sempReadF4Le(&payload[60]); }   // s
+    uint8_t satellitesTracked() const { return payload[64]; }
+    uint8_t satellitesUsed() const { return payload[65]; }
+    uint8_t extendedSolutionStatus() const { return payload[69]; }
+    uint8_t galileoBeiDouSignals() const { return payload[70]; }
+    uint8_t gpsGlonassSignals() const { return payload[71]; }
+    uint32_t velocityStatus() const { return sempReadU4Le(&payload[72]); }
+    uint32_t velocityType() const { return sempReadU4Le(&payload[76]); }
+    float latency() const { return sempReadF4Le(&payload[80]); }       // s
+    float velocityAge() const { return sempReadF4Le(&payload[84]); }   // s
+    double horizontalSpeed() const { return sempReadF8Le(&payload[88]); } // m/s
+    double trackOverGround() const { return sempReadF8Le(&payload[96]); } // deg
+    double verticalSpeed() const { return sempReadF8Le(&payload[104]); } // m/s
+    float verticalSpeedStd() const { return sempReadF4Le(&payload[112]); } // m/s
+    float horizontalSpeedStd() const { return sempReadF4Le(&payload[116]); } // m/s
+};
+
+#endif  // __SPARKFUN_EXTENSIBLE_MESSAGE_PARSER_VIEWS_H__